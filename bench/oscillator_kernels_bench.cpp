@@ -0,0 +1,150 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Reports which oscillator kernels the dispatcher picks and the speedup of
+// every instruction set over the generic kernels. Fails if any kernel
+// doesn't match the generic one bit for bit.
+
+#include "fixed_point_wave.h"
+#include "oscillator_kernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#define BUFFER_SIZE 256
+#define MAX_START 4
+#define TIMED_CALLS 5000
+#define TIMING_RUNS 9
+#define TABLE_HARMONICS 20000
+#define PHASE_INC 9000000
+
+using namespace mopo;
+
+namespace {
+  // Table render when negative, a PolyBLEP waveform otherwise.
+  const int kTableRender = -1;
+
+  const int poly_blep_waveforms[] = {
+    FixedPointWaveLookup::kTriangle,
+    FixedPointWaveLookup::kSquare,
+    FixedPointWaveLookup::kDownSaw,
+    FixedPointWaveLookup::kUpSaw,
+    FixedPointWaveLookup::kPulse25,
+    FixedPointWaveLookup::kPulse10,
+    FixedPointWaveLookup::kSawSquare,
+  };
+
+  // One voice of detuned, cross modulated input.
+  struct KernelInput {
+    int cross_mods[BUFFER_SIZE];
+    int phase_diffs[BUFFER_SIZE];
+    mopo_float phase_inc[BUFFER_SIZE];
+    const mopo_float* wave_buffer;
+
+    KernelInput() {
+      srand(3);
+      int phase_diff = 0;
+      for (int i = 0; i < BUFFER_SIZE; ++i) {
+        cross_mods[i] = rand() * 7;
+        phase_diff += PHASE_INC + rand() % 1000;
+        phase_diffs[i] = phase_diff;
+        phase_inc[i] = (PHASE_INC + i) / 4294967296.0;
+      }
+      wave_buffer = FixedPointWave::getBuffer(FixedPointWaveLookup::kUpSaw, TABLE_HARMONICS);
+    }
+  };
+
+  void render(const OscillatorKernels* kernels, const KernelInput& input, int waveform,
+              mopo_float* totals, unsigned int start_phase, int detune, int start) {
+    if (waveform == kTableRender) {
+      kernels->render_table(totals, input.cross_mods, input.phase_diffs, input.wave_buffer,
+                            start_phase, detune, start, BUFFER_SIZE);
+    }
+    else {
+      kernels->render_poly_blep(waveform, totals, input.cross_mods, input.phase_diffs,
+                                input.phase_inc, start_phase, detune, start, BUFFER_SIZE);
+    }
+  }
+
+  bool matchesGeneric(const OscillatorKernels* kernels, const KernelInput& input,
+                      int waveform) {
+    const OscillatorKernels* generic = genericOscillatorKernels();
+    for (int start = 0; start < MAX_START; ++start) {
+      mopo_float expected[BUFFER_SIZE] = { };
+      mopo_float totals[BUFFER_SIZE] = { };
+      render(generic, input, waveform, expected, 99u, -31337, start);
+      render(kernels, input, waveform, totals, 99u, -31337, start);
+      if (!std::equal(totals, totals + BUFFER_SIZE, expected))
+        return false;
+    }
+    return true;
+  }
+
+  double nanosecondsPerSample(const OscillatorKernels* kernels, const KernelInput& input,
+                              int waveform) {
+    mopo_float totals[BUFFER_SIZE] = { };
+    double best = 0.0;
+    for (int run = 0; run < TIMING_RUNS; ++run) {
+      auto start = std::chrono::steady_clock::now();
+      for (int c = 0; c < TIMED_CALLS; ++c)
+        render(kernels, input, waveform, totals, 12345u + c, 777, 0);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      double time = 1e9 * elapsed.count() / (1.0 * TIMED_CALLS * BUFFER_SIZE);
+      if (run == 0 || time < best)
+        best = time;
+    }
+    return best;
+  }
+} // namespace
+
+int main() {
+  KernelInput input;
+  int failures = 0;
+
+  printf("dispatcher picks %s\n", CpuFeatures::name(OscillatorKernels::get().isa));
+
+  const OscillatorKernels* generic = genericOscillatorKernels();
+  double generic_table = nanosecondsPerSample(generic, input, kTableRender);
+  double generic_poly_blep = nanosecondsPerSample(generic, input, FixedPointWaveLookup::kUpSaw);
+
+  for (int i = 0; i < CpuFeatures::kNumIsas; ++i) {
+    CpuFeatures::Isa isa = static_cast<CpuFeatures::Isa>(i);
+    const OscillatorKernels* kernels = OscillatorKernels::get(isa);
+    if (kernels == nullptr) {
+      printf("  %-8s not available\n", CpuFeatures::name(isa));
+      continue;
+    }
+
+    bool matches = matchesGeneric(kernels, input, kTableRender);
+    for (int waveform : poly_blep_waveforms)
+      matches = matchesGeneric(kernels, input, waveform) && matches;
+    failures += !matches;
+
+    double table = nanosecondsPerSample(kernels, input, kTableRender);
+    double poly_blep = nanosecondsPerSample(kernels, input, FixedPointWaveLookup::kUpSaw);
+    printf("  %-8s table %.2f ns/sample (x%.2f)  polyblep %.2f ns/sample (x%.2f)  %s\n",
+           CpuFeatures::name(isa), table, generic_table / table,
+           poly_blep, generic_poly_blep / poly_blep,
+           matches ? "matches generic" : "MISMATCH");
+  }
+
+  if (failures)
+    printf("%d instruction sets don't match the generic kernels\n", failures);
+  return failures ? 1 : 0;
+}
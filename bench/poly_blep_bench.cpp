@@ -0,0 +1,239 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Aliasing and cost of the PolyBLEP oscillators against the harmonic
+// tables and a naive waveform. Fails if PolyBLEP doesn't alias clearly less
+// than the naive waveform.
+
+#include "helm2025_oscillators.h"
+#include "oscillator_kernels.h"
+
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <vector>
+
+#define SAMPLE_RATE 44100.0
+#define BUFFER_SIZE 256
+#define FFT_SIZE 65536
+#define SETTLE_BLOCKS 8
+#define TIMED_BLOCKS 10000
+#define MIN_ALIAS_IMPROVEMENT_DB 6.0
+
+using namespace mopo;
+
+namespace {
+  enum Render {
+    kTable,
+    kPolyBlep,
+    kNaive,
+    kNumRenders
+  };
+
+  const char* render_names[kNumRenders] = { "table", "polyblep", "naive" };
+
+  struct Shape {
+    const char* name;
+    int waveform;
+  };
+
+  const Shape shapes[] = {
+    { "saw", FixedPointWaveLookup::kUpSaw },
+    { "square", FixedPointWaveLookup::kSquare },
+    { "triangle", FixedPointWaveLookup::kTriangle },
+    { "pulse 25", FixedPointWaveLookup::kPulse25 },
+    { "saw square", FixedPointWaveLookup::kSawSquare },
+  };
+
+  // Both oscillators of a HelmOscillators fed from constant values.
+  class OscillatorRig {
+    public:
+      OscillatorRig(int waveform, mopo_float phase_inc, int unison, bool poly_blep,
+                    bool simd_kernels = false) : oscillators_(simd_kernels) {
+        values_[HelmOscillators::kOscillator1Waveform].set(waveform);
+        values_[HelmOscillators::kOscillator2Waveform].set(waveform);
+        values_[HelmOscillators::kOscillator1PhaseInc].set(phase_inc);
+        values_[HelmOscillators::kOscillator2PhaseInc].set(phase_inc * 1.01);
+        values_[HelmOscillators::kOscillator1Amplitude].set(1.0);
+        values_[HelmOscillators::kUnisonVoices1].set(unison);
+        values_[HelmOscillators::kUnisonVoices2].set(unison);
+        values_[HelmOscillators::kUnisonDetune1].set(unison > 1 ? 20.0 : 0.0);
+        values_[HelmOscillators::kUnisonDetune2].set(unison > 1 ? 20.0 : 0.0);
+        values_[HelmOscillators::kPolyBlep].set(poly_blep ? 1.0 : 0.0);
+
+        for (int i = 0; i < HelmOscillators::kNumInputs; ++i) {
+          if (i == HelmOscillators::kReset)
+            oscillators_.plug(&reset_, i);
+          else {
+            values_[i].setBufferSize(BUFFER_SIZE);
+            oscillators_.plug(&values_[i], i);
+          }
+        }
+        oscillators_.setBufferSize(BUFFER_SIZE);
+      }
+
+      void setSecondAmplitude(mopo_float amplitude) {
+        values_[HelmOscillators::kOscillator2Amplitude].set(amplitude);
+      }
+
+      const mopo_float* process() {
+        oscillators_.process();
+        return oscillators_.output()->buffer;
+      }
+
+    private:
+      HelmOscillators oscillators_;
+      Value values_[HelmOscillators::kNumInputs];
+      Output reset_;
+  };
+
+  mopo_float naiveSample(int waveform, mopo_float t) {
+    switch (waveform) {
+      case FixedPointWaveLookup::kUpSaw:
+        return 2.0 * t - 1.0;
+      case FixedPointWaveLookup::kSquare:
+        return t < 0.5 ? 1.0 : -1.0;
+      case FixedPointWaveLookup::kTriangle:
+        return std::fabs(2.0 - 4.0 * std::fmod(t + 0.75, 1.0)) - 1.0;
+      case FixedPointWaveLookup::kPulse25:
+        return t < 0.25 ? 1.0 : -1.0;
+      case FixedPointWaveLookup::kSawSquare:
+        return -0.6 * (2.0 * t - 1.0) + 0.4 * (t < 0.5 ? 1.0 : -1.0);
+      default:
+        return 0.0;
+    }
+  }
+
+  void fft(std::vector<std::complex<double>>& data) {
+    int size = data.size();
+    for (int i = 1, j = 0; i < size; ++i) {
+      int bit = size >> 1;
+      for (; j & bit; bit >>= 1)
+        j ^= bit;
+      j ^= bit;
+      if (i < j)
+        std::swap(data[i], data[j]);
+    }
+
+    for (int length = 2; length <= size; length <<= 1) {
+      std::complex<double> step = std::polar(1.0, -2.0 * PI / length);
+      for (int i = 0; i < size; i += length) {
+        std::complex<double> twiddle = 1.0;
+        for (int j = 0; j < length / 2; ++j) {
+          std::complex<double> even = data[i + j];
+          std::complex<double> odd = data[i + j + length / 2] * twiddle;
+          data[i + j] = even + odd;
+          data[i + j + length / 2] = even - odd;
+          twiddle *= step;
+        }
+      }
+    }
+  }
+
+  // The phase increment is _cycles_ / FFT_SIZE, so harmonics land exactly
+  // on multiples of _cycles_ and everything else is aliasing.
+  double aliasDb(int waveform, Render render, int cycles) {
+    mopo_float phase_inc = (1.0 * cycles) / FFT_SIZE;
+    std::vector<std::complex<double>> signal(FFT_SIZE);
+
+    if (render == kNaive) {
+      for (int i = 0; i < FFT_SIZE; ++i)
+        signal[i] = naiveSample(waveform, std::fmod(i * phase_inc, 1.0));
+    }
+    else {
+      OscillatorRig rig(waveform, phase_inc, 1, render == kPolyBlep);
+      for (int b = 0; b < SETTLE_BLOCKS; ++b)
+        rig.process();
+
+      for (int b = 0; b < FFT_SIZE / BUFFER_SIZE; ++b) {
+        const mopo_float* buffer = rig.process();
+        for (int i = 0; i < BUFFER_SIZE; ++i)
+          signal[b * BUFFER_SIZE + i] = buffer[i];
+      }
+    }
+
+    fft(signal);
+    double harmonic_energy = 0.0;
+    double alias_energy = 0.0;
+    for (int k = 1; k < FFT_SIZE / 2; ++k) {
+      if (k % cycles == 0)
+        harmonic_energy += std::norm(signal[k]);
+      else
+        alias_energy += std::norm(signal[k]);
+    }
+    return 10.0 * std::log10(alias_energy / harmonic_energy);
+  }
+
+  double blockMicroseconds(int waveform, int unison, bool poly_blep, bool simd_kernels) {
+    OscillatorRig rig(waveform, 220.0 / SAMPLE_RATE, unison, poly_blep, simd_kernels);
+    rig.setSecondAmplitude(1.0);
+    for (int b = 0; b < SETTLE_BLOCKS; ++b)
+      rig.process();
+
+    double sink = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int b = 0; b < TIMED_BLOCKS; ++b)
+      sink += rig.process()[7];
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (!std::isfinite(sink))
+      return -1.0;
+    return 1e6 * elapsed.count() / TIMED_BLOCKS;
+  }
+} // namespace
+
+int main() {
+  int failures = 0;
+
+  // Around 440 Hz and 3.5 kHz.
+  int test_cycles[] = { 655, 5227 };
+  printf("alias energy / harmonic energy, one voice\n");
+  for (int cycles : test_cycles) {
+    for (const Shape& shape : shapes) {
+      double alias[kNumRenders];
+      for (int r = 0; r < kNumRenders; ++r)
+        alias[r] = aliasDb(shape.waveform, static_cast<Render>(r), cycles);
+
+      bool improved = alias[kPolyBlep] <= alias[kNaive] - MIN_ALIAS_IMPROVEMENT_DB;
+      failures += !improved;
+      printf("  %6.0f Hz %-10s", SAMPLE_RATE * cycles / FFT_SIZE, shape.name);
+      for (int r = 0; r < kNumRenders; ++r)
+        printf("  %s %6.1f dB", render_names[r], alias[r]);
+      printf("%s\n", improved ? "" : "  FAIL");
+    }
+  }
+
+  int test_unison[] = { 1, 4, 15 };
+  for (bool simd_kernels : { false, true }) {
+    CpuFeatures::Isa isa = simd_kernels ? OscillatorKernels::get().isa : CpuFeatures::kGeneric;
+    printf("cost per %d sample block, both oscillators at 220 Hz, %s kernels\n",
+           BUFFER_SIZE, CpuFeatures::name(isa));
+    for (int unison : test_unison) {
+      for (int s = 0; s < 2; ++s) {
+        double table = blockMicroseconds(shapes[s].waveform, unison, false, simd_kernels);
+        double poly_blep = blockMicroseconds(shapes[s].waveform, unison, true, simd_kernels);
+        failures += table < 0.0 || poly_blep < 0.0;
+        printf("  %-6s %2d unison  table %6.2f us  polyblep %6.2f us\n",
+               shapes[s].name, unison, table, poly_blep);
+      }
+    }
+  }
+
+  if (failures)
+    printf("%d checks failed\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,369 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Checks the grid responses against the per frequency biquad responses and
+// against the filter processors themselves, measured with a quiet sine.
+// Then times a filter curve per frequency against the grid.
+
+#include "mopo.h"
+#include "ladder_filter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <vector>
+
+#define SAMPLE_RATE 44100
+#define BUFFER_SIZE 256
+#define SETTLE_BLOCKS 120
+#define MEASURE_BLOCKS 256
+#define MEASURE_AMPLITUDE 1e-5
+#define MIN_CHECKED_DB -60.0
+#define MAX_GRID_ERROR 1e-9
+#define MAX_MEASURED_DB_ERROR 1e-4
+#define MAX_MEASURED_PHASE_ERROR 1e-4
+#define CURVE_POINTS 302
+#define TIMED_CURVES 2000
+#define TIMING_RUNS 9
+
+using namespace mopo;
+
+namespace {
+  typedef std::complex<mopo_float> Complex;
+
+  mopo_float toDb(mopo_float magnitude) {
+    return 20.0 * std::log10(magnitude);
+  }
+
+  // Response of _processor_ at _frequency_ from a windowed sine fed through
+  // _audio_, small enough that every saturation stays linear.
+  Complex measure(Processor* processor, Output* audio, mopo_float frequency) {
+    processor->setSampleRate(SAMPLE_RATE);
+    processor->setBufferSize(BUFFER_SIZE);
+
+    mopo_float phase_inc = 2.0 * PI * frequency / SAMPLE_RATE;
+    int measured_samples = MEASURE_BLOCKS * BUFFER_SIZE;
+    Complex output_sum = 0.0;
+    Complex input_sum = 0.0;
+    int sample = 0;
+    for (int b = 0; b < SETTLE_BLOCKS + MEASURE_BLOCKS; ++b) {
+      for (int i = 0; i < BUFFER_SIZE; ++i)
+        audio->buffer[i] = MEASURE_AMPLITUDE * std::sin(phase_inc * (sample + i));
+      processor->process();
+
+      if (b >= SETTLE_BLOCKS) {
+        for (int i = 0; i < BUFFER_SIZE; ++i) {
+          int m = sample + i - SETTLE_BLOCKS * BUFFER_SIZE;
+          mopo_float window = 0.5 - 0.5 * std::cos(2.0 * PI * m / measured_samples);
+          Complex carrier = std::polar(window, -phase_inc * (sample + i));
+          output_sum += processor->output()->buffer[i] * carrier;
+          input_sum += audio->buffer[i] * carrier;
+        }
+      }
+      sample += BUFFER_SIZE;
+    }
+    return output_sum / input_sum;
+  }
+
+  // Compares _response_ with _expected_ at every grid point loud enough to
+  // matter. Prints the worst errors and returns whether they're in range.
+  template<class Expected>
+  bool checkResponse(const char* name, const FrequencyResponse& response,
+                     Expected expected) {
+    int size = response.size();
+    std::vector<mopo_float> magnitudes(size);
+    std::vector<mopo_float> phases(size);
+    response.getMagnitudes(magnitudes.data());
+    response.getPhases(phases.data());
+
+    mopo_float db_error = 0.0;
+    mopo_float phase_error = 0.0;
+    for (int i = 0; i < size; ++i) {
+      if (toDb(magnitudes[i]) < MIN_CHECKED_DB)
+        continue;
+
+      Complex value = expected(response.grid()->frequencies()[i]);
+      db_error = std::max(db_error, std::fabs(toDb(std::abs(value)) - toDb(magnitudes[i])));
+      phase_error = std::max(phase_error, std::fabs(std::arg(value / std::polar(1.0, phases[i]))));
+    }
+
+    bool passed = db_error <= MAX_MEASURED_DB_ERROR && phase_error <= MAX_MEASURED_PHASE_ERROR;
+    printf("  %-40s %.1e dB  %.1e rad%s\n", name, db_error, phase_error, passed ? "" : "  FAIL");
+    return passed;
+  }
+
+  // Every biquad type on the grid against its per frequency response.
+  int checkBiquads(const ResponseGrid& grid) {
+    int failures = 0;
+    mopo_float cutoffs[] = { 60.0, 1000.0, 15000.0 };
+    mopo_float resonances[] = { 0.5, 4.0 };
+    std::vector<mopo_float> magnitudes(grid.size());
+
+    mopo_float worst = 0.0;
+    for (int type = 0; type < BiquadFilter::kNumTypes; ++type) {
+      for (mopo_float cutoff : cutoffs) {
+        for (mopo_float resonance : resonances) {
+          BiquadFilter::Coefficients coefficients =
+              BiquadFilter::computeCoefficients(static_cast<BiquadFilter::Type>(type),
+                                                cutoff, resonance, 2.0, SAMPLE_RATE);
+          BiquadFilter::getMagnitudes(coefficients, grid, magnitudes.data());
+
+          FrequencyResponse response(&grid);
+          response.multiplyBiquad(coefficients);
+          std::vector<mopo_float> response_magnitudes(grid.size());
+          response.getMagnitudes(response_magnitudes.data());
+
+          for (int i = 0; i < grid.size(); ++i) {
+            mopo_float expected = std::abs(BiquadFilter::getResponse(
+                coefficients, grid.frequencies()[i], SAMPLE_RATE));
+            mopo_float scale = std::max<mopo_float>(expected, 1.0);
+            mopo_float error = std::max(std::fabs(magnitudes[i] - expected),
+                                        std::fabs(response_magnitudes[i] - expected)) / scale;
+            worst = std::max(worst, error);
+          }
+        }
+      }
+    }
+
+    failures += worst > MAX_GRID_ERROR;
+    printf("  %-40s %.1e relative%s\n", "biquads on the grid vs getResponse", worst,
+           worst > MAX_GRID_ERROR ? "  FAIL" : "");
+    return failures;
+  }
+
+  int checkStateVariableFilters(const ResponseGrid& grid) {
+    struct Case {
+      StateVariableFilter::Styles style;
+      mopo_float blend;
+      StateVariableFilter::Shelves shelf;
+      mopo_float cutoff, resonance, gain, drive;
+    };
+    const Case cases[] = {
+      { StateVariableFilter::k12dB, 0.0, StateVariableFilter::kLowShelf, 1000.0, 0.7, 1.0, 1.0 },
+      { StateVariableFilter::k12dB, 1.0, StateVariableFilter::kLowShelf, 3000.0, 4.0, 1.0, 1.0 },
+      { StateVariableFilter::k12dB, 2.0, StateVariableFilter::kLowShelf, 500.0, 2.0, 1.0, 1.0 },
+      { StateVariableFilter::k12dB, 0.5, StateVariableFilter::kLowShelf, 8000.0, 10.0, 1.0, 2.0 },
+      { StateVariableFilter::k24dB, 0.0, StateVariableFilter::kLowShelf, 1200.0, 3.0, 1.0, 1.0 },
+      { StateVariableFilter::k24dB, 1.5, StateVariableFilter::kLowShelf, 2000.0, 6.0, 1.0, 1.5 },
+      { StateVariableFilter::kShelf, 0.0, StateVariableFilter::kLowShelf, 800.0, 1.0, 4.0, 1.0 },
+      { StateVariableFilter::kShelf, 0.0, StateVariableFilter::kBandShelf, 2500.0, 1.0, 0.25, 1.0 },
+      { StateVariableFilter::kShelf, 0.0, StateVariableFilter::kHighShelf, 5000.0, 1.0, 3.0, 1.0 },
+    };
+
+    int failures = 0;
+    for (const Case& c : cases) {
+      FrequencyResponse response(&grid);
+      StateVariableFilter::getResponse(c.style, c.blend, c.shelf, c.cutoff, c.resonance,
+                                       c.gain, c.drive, &response);
+
+      Output audio, reset;
+      cr::Value on(1.0), style(c.style), blend(c.blend), shelf(c.shelf);
+      cr::Value cutoff(c.cutoff), resonance(c.resonance), gain(c.gain), drive(c.drive);
+      char name[64];
+      snprintf(name, sizeof(name), "svf style %d blend %.1f shelf %d %.0f Hz",
+               c.style, c.blend, c.shelf, c.cutoff);
+
+      failures += !checkResponse(name, response, [&](mopo_float frequency) {
+        StateVariableFilter filter;
+        filter.plug(&audio, StateVariableFilter::kAudio);
+        filter.plug(&on, StateVariableFilter::kOn);
+        filter.plug(&style, StateVariableFilter::kStyle);
+        filter.plug(&blend, StateVariableFilter::kPassBlend);
+        filter.plug(&shelf, StateVariableFilter::kShelfChoice);
+        filter.plug(&cutoff, StateVariableFilter::kCutoff);
+        filter.plug(&resonance, StateVariableFilter::kResonance);
+        filter.plug(&gain, StateVariableFilter::kGain);
+        filter.plug(&drive, StateVariableFilter::kDrive);
+        filter.plug(&reset, StateVariableFilter::kReset);
+        return measure(&filter, &audio, frequency);
+      });
+    }
+    return failures;
+  }
+
+  int checkLadderFilters(const ResponseGrid& grid) {
+    struct Case {
+      mopo_float cutoff, resonance, drive;
+      bool draft;
+    };
+    const Case cases[] = {
+      { 500.0, 0.0, 1.0, false },
+      { 2000.0, 2.0, 1.0, false },
+      { 6000.0, 3.5, 1.0, false },
+      { 12000.0, 1.0, 2.0, false },
+      { 500.0, 0.0, 1.0, true },
+      { 2000.0, 2.0, 1.0, true },
+      { 6000.0, 3.5, 1.0, true },
+    };
+
+    int failures = 0;
+    for (const Case& c : cases) {
+      FrequencyResponse response(&grid);
+      LadderFilter::getResponse(c.cutoff, c.resonance, c.drive, c.draft, &response);
+
+      Output audio, reset;
+      cr::Value cutoff(c.cutoff), resonance(c.resonance), drive(c.drive), draft(c.draft);
+      char name[64];
+      snprintf(name, sizeof(name), "ladder %.0f Hz resonance %.1f%s",
+               c.cutoff, c.resonance, c.draft ? " draft" : "");
+
+      failures += !checkResponse(name, response, [&](mopo_float frequency) {
+        LadderFilter filter;
+        filter.plug(&audio, LadderFilter::kAudio);
+        filter.plug(&cutoff, LadderFilter::kCutoff);
+        filter.plug(&resonance, LadderFilter::kResonance);
+        filter.plug(&drive, LadderFilter::kDrive);
+        filter.plug(&reset, LadderFilter::kReset);
+        filter.plug(&draft, LadderFilter::kDraft);
+        return measure(&filter, &audio, frequency);
+      });
+    }
+    return failures;
+  }
+
+  int checkFormants(const ResponseGrid& grid) {
+    Output audio, reset;
+    cr::Value type(BiquadFilter::kGainedBandPass);
+    cr::Value cutoffs[] = { cr::Value(500.0), cr::Value(1200.0),
+                            cr::Value(2600.0), cr::Value(3500.0) };
+    cr::Value resonance(8.0), gain(0.5);
+
+    FormantManager formants(4);
+    formants.plug(&audio, FormantManager::kAudio);
+    formants.plug(&reset, FormantManager::kReset);
+    for (int i = 0; i < 4; ++i) {
+      formants.plug(&type, FormantManager::formantInput(i, FormantManager::kType));
+      formants.plug(&cutoffs[i], FormantManager::formantInput(i, FormantManager::kCutoff));
+      formants.plug(&resonance, FormantManager::formantInput(i, FormantManager::kResonance));
+      formants.plug(&gain, FormantManager::formantInput(i, FormantManager::kGain));
+    }
+    formants.setSampleRate(SAMPLE_RATE);
+    formants.setBufferSize(BUFFER_SIZE);
+    formants.process();
+
+    FrequencyResponse response(&grid);
+    formants.getResponse(&response);
+    bool passed = checkResponse("formant bank vs its scalar getResponse", response,
+                                [&](mopo_float frequency) {
+      return formants.getResponse(frequency);
+    });
+    return !passed;
+  }
+
+  template<class Function>
+  double curveMicroseconds(Function function) {
+    double best = 0.0;
+    for (int run = 0; run < TIMING_RUNS; ++run) {
+      auto start = std::chrono::steady_clock::now();
+      for (int c = 0; c < TIMED_CURVES; ++c)
+        function(c);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      double time = 1e6 * elapsed.count() / TIMED_CURVES;
+      if (run == 0 || time < best)
+        best = time;
+    }
+    return best;
+  }
+
+  // A low, band and high pass blend, the curve the filter graph draws.
+  void timeCurves() {
+    std::vector<mopo_float> frequencies(CURVE_POINTS);
+    for (int i = 0; i < CURVE_POINTS; ++i)
+      frequencies[i] = utils::midiNoteToFrequency((127.0 * i) / (CURVE_POINTS - 1));
+    ResponseGrid grid(frequencies.data(), CURVE_POINTS, SAMPLE_RATE);
+
+    BiquadFilter::Type types[] = { BiquadFilter::kLowPass, BiquadFilter::kBandPass,
+                                   BiquadFilter::kHighPass };
+    mopo_float amounts[] = { 0.5, 0.5, 0.0 };
+    std::vector<mopo_float> curve(CURVE_POINTS);
+    std::vector<mopo_float> magnitudes(CURVE_POINTS);
+    mopo_float sink = 0.0;
+
+    double per_frequency = curveMicroseconds([&](int c) {
+      for (int t = 0; t < 3; ++t) {
+        BiquadFilter::Coefficients coefficients = BiquadFilter::computeCoefficients(
+            types[t], 200.0 + c, 2.0, 1.0, SAMPLE_RATE);
+        for (int i = 0; i < CURVE_POINTS; ++i) {
+          mopo_float magnitude = std::abs(BiquadFilter::getResponse(
+              coefficients, frequencies[i], SAMPLE_RATE));
+          curve[i] = (t ? curve[i] : 0.0) + amounts[t] * magnitude;
+        }
+      }
+      sink += curve[c % CURVE_POINTS];
+    });
+
+    double on_grid = curveMicroseconds([&](int c) {
+      for (int t = 0; t < 3; ++t) {
+        BiquadFilter::Coefficients coefficients = BiquadFilter::computeCoefficients(
+            types[t], 200.0 + c, 2.0, 1.0, SAMPLE_RATE);
+        BiquadFilter::getMagnitudes(coefficients, grid, magnitudes.data());
+        for (int i = 0; i < CURVE_POINTS; ++i)
+          curve[i] = (t ? curve[i] : 0.0) + amounts[t] * magnitudes[i];
+      }
+      sink += curve[c % CURVE_POINTS];
+    });
+
+    double state_variable = curveMicroseconds([&](int c) {
+      FrequencyResponse response(&grid);
+      StateVariableFilter::getResponse(StateVariableFilter::k24dB, 0.5,
+                                       StateVariableFilter::kLowShelf,
+                                       500.0 + c, 2.0, 1.0, 1.0, &response);
+      response.getMagnitudes(magnitudes.data());
+      sink += magnitudes[c % CURVE_POINTS];
+    });
+
+    double ladder = curveMicroseconds([&](int c) {
+      FrequencyResponse response(&grid);
+      LadderFilter::getResponse(500.0 + c, 2.0, 1.0, false, &response);
+      response.getMagnitudes(magnitudes.data());
+      sink += magnitudes[c % CURVE_POINTS];
+    });
+
+    double grid_build = curveMicroseconds([&](int c) {
+      ResponseGrid new_grid(frequencies.data(), CURVE_POINTS, SAMPLE_RATE);
+      sink += new_grid.cosines()[c % CURVE_POINTS];
+    });
+
+    printf("%d point curves\n", CURVE_POINTS);
+    printf("  biquad blend per frequency %.1f us  on the grid %.1f us\n", per_frequency, on_grid);
+    printf("  24 dB svf %.1f us  ladder %.1f us  grid build %.1f us\n",
+           state_variable, ladder, grid_build);
+    if (!std::isfinite(sink))
+      printf("  non finite curve\n");
+  }
+} // namespace
+
+int main() {
+  std::vector<mopo_float> frequencies;
+  for (mopo_float frequency = 40.0; frequency < 20000.0; frequency *= 1.5)
+    frequencies.push_back(frequency);
+  ResponseGrid grid(frequencies.data(), frequencies.size(), SAMPLE_RATE);
+
+  printf("worst error of the grid responses\n");
+  int failures = checkBiquads(grid);
+  failures += checkStateVariableFilters(grid);
+  failures += checkLadderFilters(grid);
+  failures += checkFormants(grid);
+
+  timeCurves();
+
+  if (failures)
+    printf("%d checks failed\n", failures);
+  return failures ? 1 : 0;
+}
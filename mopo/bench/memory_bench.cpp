@@ -0,0 +1,220 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Checks the Memory block reads and writes against get() and push(), then
+// times them and the delay processors built on them. Fails on any
+// difference.
+
+#include "mopo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#define MEMORY_SIZE 4096
+#define CHECKED_BLOCKS 20000
+#define BUFFER_SIZE 256
+#define TIMED_BLOCKS 2000
+#define TIMING_RUNS 15
+#define SAMPLE_RATE 44100
+#define MAX_SECONDS 2.0
+
+using namespace mopo;
+
+namespace {
+  std::mt19937 random_generator(1);
+
+  mopo_float randomFloat(mopo_float from, mopo_float to) {
+    return std::uniform_real_distribution<mopo_float>(from, to)(random_generator);
+  }
+
+  int randomInt(int from, int to) {
+    return std::uniform_int_distribution<int>(from, to)(random_generator);
+  }
+
+  // Runs random blocks through two memories holding the same samples. One
+  // uses the block calls, the other get() and push() one sample at a time.
+  int checkBlocks() {
+    Memory block_memory(MEMORY_SIZE);
+    Memory sample_memory(MEMORY_SIZE);
+    mopo_float samples[BUFFER_SIZE];
+    mopo_float pasts[BUFFER_SIZE];
+    mopo_float read[BUFFER_SIZE];
+    mopo_float expected[BUFFER_SIZE];
+    int failures = 0;
+
+    for (int b = 0; b < CHECKED_BLOCKS; ++b) {
+      int num = randomInt(1, BUFFER_SIZE);
+      for (int i = 0; i < num; ++i)
+        samples[i] = randomFloat(-1.0, 1.0);
+
+      int read_num = num;
+      bool constant = b % 2;
+      if (constant) {
+        mopo_float past = randomFloat(num, MEMORY_SIZE / 2);
+        block_memory.readBlock(read, past, num);
+        std::fill(pasts, pasts + num, past);
+      }
+      else {
+        // Now and then one delay is too short and the read stops there.
+        int too_short = b % 8 ? num : randomInt(0, num - 1);
+        for (int i = 0; i < num; ++i) {
+          if (i == too_short)
+            pasts[i] = randomFloat(0.0, i + 0.5);
+          else
+            pasts[i] = randomFloat(i + 1, MEMORY_SIZE / 2);
+        }
+        read_num = block_memory.readBlock(read, pasts, num);
+        failures += read_num != too_short;
+      }
+
+      for (int i = 0; i < num; ++i) {
+        expected[i] = sample_memory.get(pasts[i]);
+        sample_memory.push(samples[i]);
+      }
+      block_memory.pushBlock(samples, num);
+
+      failures += !std::equal(read, read + read_num, expected);
+      for (int i = 0; i < MEMORY_SIZE; ++i)
+        failures += block_memory.getIndex(i) != sample_memory.getIndex(i);
+    }
+    return failures;
+  }
+
+  template<class Function>
+  double nanosecondsPerSample(Function function) {
+    double best = 0.0;
+    for (int run = 0; run < TIMING_RUNS; ++run) {
+      auto start = std::chrono::steady_clock::now();
+      for (int b = 0; b < TIMED_BLOCKS; ++b)
+        function();
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      double time = 1e9 * elapsed.count() / (1.0 * TIMED_BLOCKS * BUFFER_SIZE);
+      if (run == 0 || time < best)
+        best = time;
+    }
+    return best;
+  }
+
+  void timeReads() {
+    Memory memory(MEMORY_SIZE);
+    mopo_float samples[BUFFER_SIZE];
+    mopo_float read[BUFFER_SIZE];
+    for (int i = 0; i < BUFFER_SIZE; ++i)
+      samples[i] = randomFloat(-1.0, 1.0);
+    mopo_float past = 1000.37;
+
+    double per_sample = nanosecondsPerSample([&] {
+      for (int i = 0; i < BUFFER_SIZE; ++i) {
+        read[i] = memory.get(past);
+        memory.push(samples[i]);
+      }
+    });
+    double block = nanosecondsPerSample([&] {
+      memory.readBlock(read, past, BUFFER_SIZE);
+      memory.pushBlock(samples, BUFFER_SIZE);
+    });
+    printf("memory read and write  get/push %.2f ns/sample  readBlock/pushBlock %.2f ns/sample\n",
+           per_sample, block);
+  }
+
+  void timeProcessors() {
+    Output audio, period, ramp, feedback, damping, wet, delay_period, reset;
+    Output stutter_frequency, resample_frequency, softness;
+    for (int i = 0; i < BUFFER_SIZE; ++i) {
+      audio.buffer[i] = randomFloat(-1.0, 1.0);
+      period.buffer[i] = 100.37;
+      ramp.buffer[i] = 100.37 + 0.01 * i;
+      feedback.buffer[i] = 0.5;
+      damping.buffer[i] = 0.3;
+    }
+    wet.buffer[0] = 0.5;
+    delay_period.buffer[0] = 1116;
+    stutter_frequency.buffer[0] = 20;
+    resample_frequency.buffer[0] = 0.5;
+    softness.buffer[0] = 0.5;
+
+    Delay delay(1 << 16);
+    delay.plug(&audio, Delay::kAudio);
+    delay.plug(&wet, Delay::kWet);
+    delay.plug(&delay_period, Delay::kSampleDelay);
+    delay.plug(&feedback, Delay::kFeedback);
+
+    SimpleDelay simple_delay(MEMORY_SIZE);
+    simple_delay.plug(&audio, SimpleDelay::kAudio);
+    simple_delay.plug(&period, SimpleDelay::kSampleDelay);
+    simple_delay.plug(&feedback, SimpleDelay::kFeedback);
+    simple_delay.plug(&reset, SimpleDelay::kReset);
+
+    SimpleDelay ramped_delay(MEMORY_SIZE);
+    ramped_delay.plug(&audio, SimpleDelay::kAudio);
+    ramped_delay.plug(&ramp, SimpleDelay::kSampleDelay);
+    ramped_delay.plug(&feedback, SimpleDelay::kFeedback);
+    ramped_delay.plug(&reset, SimpleDelay::kReset);
+
+    ReverbComb comb(MAX_SECONDS);
+    comb.plug(&audio, ReverbComb::kAudio);
+    comb.plug(&delay_period, ReverbComb::kSampleDelay);
+    comb.plug(&feedback, ReverbComb::kFeedback);
+    comb.plug(&damping, ReverbComb::kDamping);
+
+    ReverbAllPass all_pass(MAX_SECONDS);
+    all_pass.plug(&audio, ReverbAllPass::kAudio);
+    all_pass.plug(&delay_period, ReverbAllPass::kSampleDelay);
+    all_pass.plug(&feedback, ReverbAllPass::kFeedback);
+
+    Stutter stutter(MAX_SECONDS);
+    stutter.plug(&audio, Stutter::kAudio);
+    stutter.plug(&stutter_frequency, Stutter::kStutterFrequency);
+    stutter.plug(&resample_frequency, Stutter::kResampleFrequency);
+    stutter.plug(&softness, Stutter::kWindowSoftness);
+    stutter.plug(&reset, Stutter::kReset);
+    stutter.setSampleRate(SAMPLE_RATE);
+    stutter.swapMemory(new Memory(stutter.getMemorySize()));
+
+    struct { const char* name; Processor* processor; } processors[] = {
+      { "Delay", &delay },
+      { "SimpleDelay", &simple_delay },
+      { "SimpleDelay ramp", &ramped_delay },
+      { "ReverbComb", &comb },
+      { "ReverbAllPass", &all_pass },
+      { "Stutter", &stutter },
+    };
+
+    printf("delay processors at %d samples per block\n", BUFFER_SIZE);
+    for (auto& entry : processors) {
+      entry.processor->setSampleRate(SAMPLE_RATE);
+      entry.processor->setBufferSize(BUFFER_SIZE);
+      double time = nanosecondsPerSample([&] { entry.processor->process(); });
+      printf("  %-18s %.2f ns/sample\n", entry.name, time);
+    }
+  }
+} // namespace
+
+int main() {
+  int failures = checkBlocks();
+  printf("block reads and writes against get() and push(): %s\n",
+         failures ? "MISMATCH" : "identical");
+
+  timeReads();
+  timeProcessors();
+
+  if (failures)
+    printf("%d checks failed\n", failures);
+  return failures ? 1 : 0;
+}
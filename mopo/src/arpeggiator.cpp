@@ -19,7 +19,6 @@
 #include "utils.h"
 
 #include <algorithm>
-#include <cstdlib>
 
 namespace mopo {
 
@@ -85,8 +84,8 @@ namespace mopo {
         break;
       case kRandom:
         pattern = &ascending_;
-        note_index_ = rand() % ascending_.size();
-        current_octave_ = rand() % octaves;
+        note_index_ = random_.next() % ascending_.size();
+        current_octave_ = random_.next() % octaves;
         break;
       case kUpDown:
         if (note_index_ >= ascending_.size() - 1) {
@@ -21,6 +21,7 @@
 #include "circular_queue.h"
 #include "note_handler.h"
 #include "processor.h"
+#include "random_generator.h"
 #include "value.h"
 
 #include <list>
@@ -58,6 +59,7 @@ namespace mopo {
       }
 
       virtual void process() override;
+      virtual void setRandomSeed(uint64_t seed) override { random_.setSeed(seed); }
 
       int getNumNotes() { return pressed_notes_.size(); }
       CircularQueue<mopo_float>& getPressedNotes();
@@ -83,6 +85,7 @@ namespace mopo {
       int current_octave_;
       bool octave_up_;
       mopo_float last_played_note_;
+      RandomGenerator random_;
 
       std::vector<mopo_float> as_played_;
       std::vector<mopo_float> ascending_;
@@ -15,6 +15,7 @@
  */
 
 #include "biquad_filter.h"
+#include "frequency_response.h"
 #include "utils.h"
 
 #include <cmath>
@@ -41,23 +42,61 @@ namespace mopo {
     past_in_1_ = past_in_2_ = past_out_1_ = past_out_2_ = 0.0;
   }
 
-  std::complex<mopo_float> BiquadFilter::getResponse(mopo_float frequency) {
+  mopo_float BiquadFilter::clampCutoff(mopo_float cutoff, int sample_rate) {
+    return utils::clamp(cutoff, MIN_CUTTOFF, sample_rate);
+  }
+
+  mopo_float BiquadFilter::clampResonance(mopo_float resonance) {
+    return utils::clamp(resonance, MIN_RESONANCE, MAX_RESONANCE);
+  }
+
+  std::complex<mopo_float> BiquadFilter::getResponse(const Coefficients& coefficients,
+                                                     mopo_float frequency, int sample_rate) {
     static const std::complex<mopo_float> one(1.0, 0.0);
-    const mopo_float phase_delta = 2.0 * PI * frequency / sample_rate_;
+    const mopo_float phase_delta = 2.0 * PI * frequency / sample_rate;
     const std::complex<mopo_float> freq_tick1 = std::polar(mopo_float(1.0), -phase_delta);
     const std::complex<mopo_float> freq_tick2 = std::polar(mopo_float(1.0), -2 * phase_delta);
 
-    return (target_in_0_ * one + target_in_1_ * freq_tick1 + target_in_2_ * freq_tick2) /
-           (one + target_out_1_ * freq_tick1 + target_out_2_ * freq_tick2);
+    return (coefficients.in_0 * one + coefficients.in_1 * freq_tick1 +
+            coefficients.in_2 * freq_tick2) /
+           (one + coefficients.out_1 * freq_tick1 + coefficients.out_2 * freq_tick2);
+  }
+
+  void BiquadFilter::getMagnitudes(const Coefficients& coefficients,
+                                   const ResponseGrid& grid, mopo_float* dest) {
+    // Numerator and denominator are evaluated as complex values first.
+    // Expanding their squared magnitudes into polynomials of cos(w) cancels
+    // badly near zeros and limits how deep a notch reads.
+    const Coefficients& c = coefficients;
+    const mopo_float* cosines = grid.cosines();
+    const mopo_float* sines = grid.sines();
+    int points = grid.size();
+    for (int i = 0; i < points; ++i) {
+      mopo_float cosine = cosines[i];
+      mopo_float cosine2 = 2.0 * cosine * cosine - 1.0;
+      mopo_float sine2 = 2.0 * cosine * sines[i];
+
+      mopo_float num_real = c.in_0 + c.in_1 * cosine + c.in_2 * cosine2;
+      mopo_float num_imag = c.in_1 * sines[i] + c.in_2 * sine2;
+      mopo_float den_real = 1.0 + c.out_1 * cosine + c.out_2 * cosine2;
+      mopo_float den_imag = c.out_1 * sines[i] + c.out_2 * sine2;
+      dest[i] = sqrt((num_real * num_real + num_imag * num_imag) /
+                     (den_real * den_real + den_imag * den_imag));
+    }
+  }
+
+  std::complex<mopo_float> BiquadFilter::getResponse(mopo_float frequency) {
+    Coefficients target = { target_in_0_, target_in_1_, target_in_2_,
+                            target_out_1_, target_out_2_ };
+    return getResponse(target, frequency, sample_rate_);
   }
 
   void BiquadFilter::process() {
     MOPO_ASSERT(inputMatchesBufferSize(kAudio));
 
     current_type_ = static_cast<Type>(static_cast<int>(input(kType)->at(0)));
-    mopo_float cutoff = utils::clamp(input(kCutoff)->at(0), MIN_CUTTOFF, sample_rate_);
-    mopo_float resonance = utils::clamp(input(kResonance)->at(0),
-                                        MIN_RESONANCE, MAX_RESONANCE);
+    mopo_float cutoff = clampCutoff(input(kCutoff)->at(0), sample_rate_);
+    mopo_float resonance = clampResonance(input(kResonance)->at(0));
     computeCoefficients(current_type_, cutoff, resonance, input(kGain)->at(0));
 
     mopo_float delta_in_0 = (target_in_0_ - in_0_) / buffer_size_;
@@ -98,47 +137,49 @@ namespace mopo {
     }
   }
 
-  void BiquadFilter::computeCoefficients(Type type,
-                                   mopo_float cutoff,
-                                   mopo_float resonance,
-                                   mopo_float gain) {
+  BiquadFilter::Coefficients BiquadFilter::computeCoefficients(Type type,
+                                                               mopo_float cutoff,
+                                                               mopo_float resonance,
+                                                               mopo_float gain,
+                                                               int sample_rate) {
     MOPO_ASSERT(resonance > 0.0);
     MOPO_ASSERT(cutoff > 0.0);
     MOPO_ASSERT(gain >= 0.0);
 
-    mopo_float phase_delta = 2.0 * PI * cutoff / sample_rate_;
+    mopo_float phase_delta = 2.0 * PI * cutoff / sample_rate;
     mopo_float real_delta = cos(phase_delta);
     mopo_float imag_delta = sin(phase_delta);
+    Coefficients c;
 
     switch(type) {
       case kLowPass: {
         mopo_float alpha = imag_delta / (2.0 * resonance);
         mopo_float norm = 1.0 + alpha;
-        target_in_0_ = (1.0 - real_delta) / (2.0 * norm);
-        target_in_1_ = (1.0 - real_delta) / norm;
-        target_in_2_ = target_in_0_;
-        target_out_1_ = -2.0 * real_delta / norm;
-        target_out_2_ = (1.0 - alpha) / norm;
+        c.in_0 = (1.0 - real_delta) / (2.0 * norm);
+        c.in_1 = (1.0 - real_delta) / norm;
+        c.in_2 = c.in_0;
+        c.out_1 = -2.0 * real_delta / norm;
+        c.out_2 = (1.0 - alpha) / norm;
         break;
       }
       case kHighPass: {
         mopo_float alpha = imag_delta / (2.0 * resonance);
         mopo_float norm = 1.0 + alpha;
-        target_in_0_ = (1.0 + real_delta) / (2.0 * norm);
-        target_in_1_ = -(1.0 + real_delta) / norm;
-        target_in_2_ = target_in_0_;
-        target_out_1_ = -2.0 * real_delta / norm;
-        target_out_2_ = (1.0 - alpha) / norm;
+        c.in_0 = (1.0 + real_delta) / (2.0 * norm);
+        c.in_1 = -(1.0 + real_delta) / norm;
+        c.in_2 = c.in_0;
+        c.out_1 = -2.0 * real_delta / norm;
+        c.out_2 = (1.0 - alpha) / norm;
         break;
       }
       case kBandPass: {
         mopo_float alpha = imag_delta / (2.0 * resonance);
         mopo_float norm = 1.0 + alpha;
-        target_in_0_ = (imag_delta / 2.0) / norm;
-        target_in_1_ = 0;
-        target_in_2_ = -target_in_0_;
-        target_out_1_ = -2.0 * real_delta / norm;
-        target_out_2_ = (1.0 - alpha) / norm;
+        c.in_0 = (imag_delta / 2.0) / norm;
+        c.in_1 = 0;
+        c.in_2 = -c.in_0;
+        c.out_1 = -2.0 * real_delta / norm;
+        c.out_2 = (1.0 - alpha) / norm;
         break;
       }
       case kLowShelf: {
@@ -148,11 +189,11 @@ namespace mopo {
         mopo_float sq = 2 * std::sqrt(g) * alpha;
         mopo_float norm = (g + 1) + (g - 1) * real_delta + sq;
 
-        target_in_0_ = ((g + 1) - (g - 1) * real_delta + sq) * (g / norm);
-        target_in_1_ = 2 * ((g - 1) - (g + 1) * real_delta) * (g / norm);
-        target_in_2_ = ((g + 1) - (g - 1) * real_delta - sq) * (g / norm);
-        target_out_1_ = -2 * ((g - 1) + (g + 1) * real_delta) / norm;
-        target_out_2_ = ((g + 1) + (g - 1) * real_delta - sq) / norm;
+        c.in_0 = ((g + 1) - (g - 1) * real_delta + sq) * (g / norm);
+        c.in_1 = 2 * ((g - 1) - (g + 1) * real_delta) * (g / norm);
+        c.in_2 = ((g + 1) - (g - 1) * real_delta - sq) * (g / norm);
+        c.out_1 = -2 * ((g - 1) + (g + 1) * real_delta) / norm;
+        c.out_2 = ((g + 1) + (g - 1) * real_delta - sq) / norm;
         break;
       }
       case kHighShelf: {
@@ -162,11 +203,11 @@ namespace mopo {
         mopo_float sq = 2 * std::sqrt(g) * alpha;
         mopo_float norm = (g + 1) - (g - 1) * real_delta + sq;
 
-        target_in_0_ = ((g + 1) + (g - 1) * real_delta + sq) * (g / norm);
-        target_in_1_ = -2 * ((g - 1) + (g + 1) * real_delta) * (g / norm);
-        target_in_2_ = ((g + 1) + (g - 1) * real_delta - sq) * (g / norm);
-        target_out_1_ = 2 * ((g - 1) - (g + 1) * real_delta) / norm;
-        target_out_2_ = ((g + 1) - (g - 1) * real_delta - sq) / norm;
+        c.in_0 = ((g + 1) + (g - 1) * real_delta + sq) * (g / norm);
+        c.in_1 = -2 * ((g - 1) + (g + 1) * real_delta) * (g / norm);
+        c.in_2 = ((g + 1) + (g - 1) * real_delta - sq) * (g / norm);
+        c.out_1 = 2 * ((g - 1) - (g + 1) * real_delta) / norm;
+        c.out_2 = ((g + 1) - (g - 1) * real_delta - sq) / norm;
         break;
       }
       case kBandShelf: {
@@ -175,49 +216,63 @@ namespace mopo {
                            sinh(log(2.0) * resonance * phase_delta / (2.0 * imag_delta));
         mopo_float norm = 1.0 + alpha / g;
 
-        target_in_0_ = (1.0 + alpha * g) / norm;
-        target_in_1_ = -2.0 * real_delta / norm;
-        target_in_2_ = (1.0 - alpha * g) / norm;
-        target_out_1_ = -2.0 * real_delta / norm;
-        target_out_2_ = (1.0 - alpha / g) / norm;
+        c.in_0 = (1.0 + alpha * g) / norm;
+        c.in_1 = -2.0 * real_delta / norm;
+        c.in_2 = (1.0 - alpha * g) / norm;
+        c.out_1 = -2.0 * real_delta / norm;
+        c.out_2 = (1.0 - alpha / g) / norm;
         break;
       }
       case kAllPass: {
         mopo_float alpha = imag_delta / (2.0 * resonance);
         mopo_float norm = 1.0 + alpha;
-        target_in_0_ = (1.0 - alpha) / norm;
-        target_in_1_ = -2.0 * real_delta / norm;
-        target_in_2_ = 1.0;
-        target_out_1_ = -2.0 * real_delta / norm;
-        target_out_2_ = (1.0 - alpha) / norm;
+        c.in_0 = (1.0 - alpha) / norm;
+        c.in_1 = -2.0 * real_delta / norm;
+        c.in_2 = 1.0;
+        c.out_1 = -2.0 * real_delta / norm;
+        c.out_2 = (1.0 - alpha) / norm;
         break;
       }
       case kNotch: {
         mopo_float alpha = imag_delta / (2.0 * resonance);
         mopo_float norm = 1.0 + alpha;
-        target_in_0_ = 1.0 / norm;
-        target_in_1_ = -2.0 * real_delta / norm;
-        target_in_2_ = target_in_0_;
-        target_out_1_ = target_in_1_;
-        target_out_2_ = (1.0 - alpha) / norm;
+        c.in_0 = 1.0 / norm;
+        c.in_1 = -2.0 * real_delta / norm;
+        c.in_2 = c.in_0;
+        c.out_1 = c.in_1;
+        c.out_2 = (1.0 - alpha) / norm;
         break;
       }
       case kGainedBandPass: {
         mopo_float alpha = imag_delta / (2.0 * resonance);
         mopo_float norm = 1.0 + alpha;
-        target_in_0_ = gain * (imag_delta / (2.0 * resonance)) / norm;
-        target_in_1_ = 0;
-        target_in_2_ = -target_in_0_;
-        target_out_1_ = -2.0 * real_delta / norm;
-        target_out_2_ = (1.0 - alpha) / norm;
+        c.in_0 = gain * (imag_delta / (2.0 * resonance)) / norm;
+        c.in_1 = 0;
+        c.in_2 = -c.in_0;
+        c.out_1 = -2.0 * real_delta / norm;
+        c.out_2 = (1.0 - alpha) / norm;
         break;
       }
       default: {
-        target_in_0_ = 1.0;
-        target_in_2_ = target_in_1_ = target_out_2_ = target_out_1_ = 0.0;
+        c.in_0 = 1.0;
+        c.in_2 = c.in_1 = c.out_2 = c.out_1 = 0.0;
       }
     }
 
+    return c;
+  }
+
+  void BiquadFilter::computeCoefficients(Type type,
+                                         mopo_float cutoff,
+                                         mopo_float resonance,
+                                         mopo_float gain) {
+    Coefficients c = computeCoefficients(type, cutoff, resonance, gain, sample_rate_);
+    target_in_0_ = c.in_0;
+    target_in_1_ = c.in_1;
+    target_in_2_ = c.in_2;
+    target_out_1_ = c.out_1;
+    target_out_2_ = c.out_2;
+
     current_cutoff_ = cutoff;
     current_resonance_ = resonance;
   }
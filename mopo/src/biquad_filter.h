@@ -25,6 +25,8 @@
 
 namespace mopo {
 
+  class ResponseGrid;
+
   // Implements RBJ biquad filters of different types.
   class BiquadFilter : public Processor {
     public:
@@ -51,6 +53,28 @@ namespace mopo {
         kNumTypes,
       };
 
+      // Normalized coefficients of one biquad, out_0 is always 1.
+      struct Coefficients {
+        mopo_float in_0, in_1, in_2;
+        mopo_float out_1, out_2;
+      };
+
+      static mopo_float clampCutoff(mopo_float cutoff, int sample_rate);
+      static mopo_float clampResonance(mopo_float resonance);
+
+      static Coefficients computeCoefficients(Type type,
+                                              mopo_float cutoff,
+                                              mopo_float resonance,
+                                              mopo_float gain,
+                                              int sample_rate);
+
+      static std::complex<mopo_float> getResponse(const Coefficients& coefficients,
+                                                  mopo_float frequency, int sample_rate);
+
+      // Amplitude response at every frequency of _grid_, without the phase.
+      static void getMagnitudes(const Coefficients& coefficients,
+                                const ResponseGrid& grid, mopo_float* dest);
+
       BiquadFilter();
       virtual ~BiquadFilter() { }
 
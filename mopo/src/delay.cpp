@@ -26,6 +26,9 @@ namespace mopo {
     current_wet_ = 0.0;
     current_dry_ = 0.0;
     current_period_ = DEFAULT_PERIOD;
+    feedback_inc_ = 0.0;
+    wet_inc_ = 0.0;
+    dry_inc_ = 0.0;
   }
 
   Delay::Delay(const Delay& other) : Processor(other) {
@@ -34,6 +37,9 @@ namespace mopo {
     this->current_wet_ = 0.0;
     this->current_dry_ = 0.0;
     this->current_period_ = DEFAULT_PERIOD;
+    this->feedback_inc_ = 0.0;
+    this->wet_inc_ = 0.0;
+    this->dry_inc_ = 0.0;
   }
 
   Delay::~Delay() {
@@ -49,28 +55,61 @@ namespace mopo {
     mopo_float wet = utils::clamp(input(kWet)->at(0), 0.0, 1.0);
     mopo_float new_wet = sqrt(wet);
     mopo_float new_dry = sqrt(1.0 - wet);
-    mopo_float wet_inc = (new_wet - current_wet_) / buffer_size_;
-    mopo_float dry_inc = (new_dry - current_dry_) / buffer_size_;
+    wet_inc_ = (new_wet - current_wet_) / buffer_size_;
+    dry_inc_ = (new_dry - current_dry_) / buffer_size_;
 
     mopo_float new_feedback = input(kFeedback)->at(0);
-    mopo_float feedback_inc = (new_feedback - current_feedback_) / buffer_size_;
+    feedback_inc_ = (new_feedback - current_feedback_) / buffer_size_;
 
     mopo_float new_period = utils::clamp(input(kSampleDelay)->at(0), 2.0, memory_->getSize() - 1.0);
     mopo_float period_inc = (new_period - current_period_) / buffer_size_;
 
+    // Blocks can't be longer than the delay or they would read themselves.
+    mopo_float read[MAX_BUFFER_SIZE];
+    if (period_inc == 0.0) {
+      int block = utils::imin(current_period_, buffer_size_);
+      for (int i = 0; i < buffer_size_; i += block) {
+        int num = utils::imin(block, buffer_size_ - i);
+        memory_->readBlock(read, current_period_, num);
+        tickBlock(i, num, audio, read, dest);
+      }
+      return;
+    }
+
+    mopo_float periods[MAX_BUFFER_SIZE];
     for (int i = 0; i < buffer_size_; ++i) {
-      current_feedback_ += feedback_inc;
-      current_wet_ += wet_inc;
-      current_dry_ += dry_inc;
       current_period_ += period_inc;
-      tick(i, audio, dest);
+      periods[i] = current_period_;
+    }
+
+    for (int i = 0; i < buffer_size_;) {
+      int num = memory_->readBlock(read, periods + i, buffer_size_ - i);
+      MOPO_ASSERT(num > 0);
+      tickBlock(i, num, audio, read, dest);
+      i += num;
     }
   }
 
-  inline void Delay::tick(int i, const mopo_float* audio, mopo_float* dest) {
-    mopo_float read = memory_->get(current_period_);
-    memory_->push(audio[i] + read * current_feedback_);
-    dest[i] = current_dry_ * audio[i] + current_wet_ * read;
-    MOPO_ASSERT(std::isfinite(dest[i]));
+  void Delay::tickBlock(int start, int num, const mopo_float* audio,
+                        const mopo_float* read, mopo_float* dest) {
+    mopo_float feedback = current_feedback_;
+    mopo_float wet = current_wet_;
+    mopo_float dry = current_dry_;
+    mopo_float write[MAX_BUFFER_SIZE];
+    for (int i = 0; i < num; ++i) {
+      feedback += feedback_inc_;
+      wet += wet_inc_;
+      dry += dry_inc_;
+
+      mopo_float sample = audio[start + i];
+      write[i] = sample + read[i] * feedback;
+      dest[start + i] = dry * sample + wet * read[i];
+      MOPO_ASSERT(std::isfinite(dest[start + i]));
+    }
+
+    current_feedback_ = feedback;
+    current_wet_ = wet;
+    current_dry_ = dry;
+    memory_->pushBlock(write, num);
   }
 } // namespace mopo
@@ -41,11 +41,21 @@ namespace mopo {
       virtual ~Delay();
 
       virtual Processor* clone() const override { return new Delay(*this); }
+      virtual size_t allocatedBytes() const override {
+        return memory_->getSize() * sizeof(mopo_float);
+      }
       virtual void process() override;
 
-      inline void tick(int i, const mopo_float* audio, mopo_float* dest);
-
     protected:
+      // Mixes and pushes _num_ samples from _start_ given the delayed
+      // samples in _read_.
+      void tickBlock(int start, int num, const mopo_float* audio,
+                     const mopo_float* read, mopo_float* dest);
+
+      mopo_float feedback_inc_;
+      mopo_float wet_inc_;
+      mopo_float dry_inc_;
+
       Memory* memory_;
       mopo_float current_feedback_;
       mopo_float current_wet_;
@@ -17,40 +17,208 @@
 #include "formant_manager.h"
 
 #include "biquad_filter.h"
-#include "operators.h"
+#include "frequency_response.h"
 
 namespace mopo {
 
-  FormantManager::FormantManager(int num_formants) : ProcessorRouter(0, 0) {
-    Bypass* audio_input = new Bypass();
-    cr::Bypass* reset_input = new cr::Bypass();
+  namespace {
+    // Sections past num_formants_ keep all zero coefficients and add
+    // nothing to the output.
+    inline void zeroSections(mopo_float* values) {
+      for (int f = 0; f < MAX_FORMANTS; ++f)
+        values[f] = 0.0;
+    }
+  } // namespace
+
+  FormantManager::FormantManager(int num_formants) :
+      Processor(kNumInputs + num_formants * kNumFormantInputs, 1),
+      num_formants_(num_formants) {
+    MOPO_ASSERT(num_formants <= MAX_FORMANTS);
 
-    registerInput(audio_input->input(), kAudio);
-    registerInput(reset_input->input(), kReset);
+    zeroSections(type_);
+    zeroSections(cutoff_);
+    zeroSections(resonance_);
+    zeroSections(gain_);
 
-    addProcessor(audio_input);
-    addProcessor(reset_input);
+    zeroSections(target_in_0_);
+    zeroSections(target_in_1_);
+    zeroSections(target_in_2_);
+    zeroSections(target_out_1_);
+    zeroSections(target_out_2_);
 
-    VariableAdd* total = new VariableAdd(num_formants);
-    for (int i = 0; i < num_formants; ++i) {
-      BiquadFilter* formant = new BiquadFilter();
-      formant->plug(audio_input, BiquadFilter::kAudio);
-      formant->plug(reset_input, BiquadFilter::kReset);
-      formants_.push_back(formant);
+    zeroSections(delta_in_0_);
+    zeroSections(delta_in_1_);
+    zeroSections(delta_in_2_);
+    zeroSections(delta_out_1_);
+    zeroSections(delta_out_2_);
 
-      addProcessor(formant);
-      total->plugNext(formant);
+    for (int f = 0; f < num_formants_; ++f) {
+      type_[f] = BiquadFilter::kNumTypes;
+      target_in_0_[f] = 1.0;
     }
 
-    addProcessor(total);
-    registerOutput(total->output());
+    past_in_1_ = past_in_2_ = 0.0;
+    zeroSections(past_out_1_);
+    zeroSections(past_out_2_);
+    reset();
   }
 
   std::complex<mopo_float> FormantManager::getResponse(mopo_float frequency) {
     std::complex<mopo_float> total;
-    for (int i = 0; i < formants_.size(); ++i)
-      total += formants_[i]->getResponse(frequency);
+    for (int f = 0; f < num_formants_; ++f) {
+      BiquadFilter::Coefficients target = { target_in_0_[f], target_in_1_[f], target_in_2_[f],
+                                            target_out_1_[f], target_out_2_[f] };
+      total += BiquadFilter::getResponse(target, frequency, sample_rate_);
+    }
 
     return total;
   }
+
+  void FormantManager::getResponse(FrequencyResponse* response) {
+    MOPO_ASSERT(response->grid()->sampleRate() == sample_rate_);
+
+    FrequencyResponse total(response->grid());
+    total.setConstant(0.0);
+    for (int f = 0; f < num_formants_; ++f) {
+      BiquadFilter::Coefficients target = { target_in_0_[f], target_in_1_[f], target_in_2_[f],
+                                            target_out_1_[f], target_out_2_[f] };
+      total.addBiquad(target);
+    }
+    response->multiply(total);
+  }
+
+  void FormantManager::process() {
+    MOPO_ASSERT(inputMatchesBufferSize(kAudio));
+
+    computeTargets();
+
+    for (int f = 0; f < MAX_FORMANTS; ++f) {
+      delta_in_0_[f] = (target_in_0_[f] - in_0_[f]) / buffer_size_;
+      delta_in_1_[f] = (target_in_1_[f] - in_1_[f]) / buffer_size_;
+      delta_in_2_[f] = (target_in_2_[f] - in_2_[f]) / buffer_size_;
+      delta_out_1_[f] = (target_out_1_[f] - out_1_[f]) / buffer_size_;
+      delta_out_2_[f] = (target_out_2_[f] - out_2_[f]) / buffer_size_;
+    }
+
+    const mopo_float* audio_buffer = input(kAudio)->source->buffer;
+    mopo_float* dest = output()->buffer;
+    if (input(kReset)->source->triggered &&
+        static_cast<int>(input(kReset)->source->trigger_value) == kVoiceReset) {
+      int trigger_offset = input(kReset)->source->trigger_offset;
+      tickBlock(0, trigger_offset, audio_buffer, dest);
+
+      // Coefficients sit on their targets after a reset.
+      reset();
+      zeroSections(delta_in_0_);
+      zeroSections(delta_in_1_);
+      zeroSections(delta_in_2_);
+      zeroSections(delta_out_1_);
+      zeroSections(delta_out_2_);
+      tickBlock(trigger_offset, buffer_size_, audio_buffer, dest);
+    }
+    else
+      tickBlock(0, buffer_size_, audio_buffer, dest);
+  }
+
+  void FormantManager::computeTargets() {
+    for (int f = 0; f < num_formants_; ++f) {
+      mopo_float type = static_cast<int>(input(formantInput(f, kType))->at(0));
+      mopo_float cutoff = BiquadFilter::clampCutoff(input(formantInput(f, kCutoff))->at(0),
+                                                    sample_rate_);
+      mopo_float resonance = BiquadFilter::clampResonance(
+          input(formantInput(f, kResonance))->at(0));
+      mopo_float gain = input(formantInput(f, kGain))->at(0);
+
+      if (type == type_[f] && cutoff == cutoff_[f] &&
+          resonance == resonance_[f] && gain == gain_[f]) {
+        continue;
+      }
+
+      type_[f] = type;
+      cutoff_[f] = cutoff;
+      resonance_[f] = resonance;
+      gain_[f] = gain;
+
+      BiquadFilter::Coefficients target = BiquadFilter::computeCoefficients(
+          static_cast<BiquadFilter::Type>(static_cast<int>(type)),
+          cutoff, resonance, gain, sample_rate_);
+      target_in_0_[f] = target.in_0;
+      target_in_1_[f] = target.in_1;
+      target_in_2_[f] = target.in_2;
+      target_out_1_[f] = target.out_1;
+      target_out_2_[f] = target.out_2;
+    }
+  }
+
+  void FormantManager::tickBlock(int start, int end,
+                                 const mopo_float* audio_buffer, mopo_float* dest) {
+    // Works on copies so the compiler can keep every lane in registers.
+    mopo_float in_0[MAX_FORMANTS], in_1[MAX_FORMANTS], in_2[MAX_FORMANTS];
+    mopo_float out_1[MAX_FORMANTS], out_2[MAX_FORMANTS];
+    mopo_float past_out_1[MAX_FORMANTS], past_out_2[MAX_FORMANTS];
+    for (int f = 0; f < MAX_FORMANTS; ++f) {
+      in_0[f] = in_0_[f];
+      in_1[f] = in_1_[f];
+      in_2[f] = in_2_[f];
+      out_1[f] = out_1_[f];
+      out_2[f] = out_2_[f];
+      past_out_1[f] = past_out_1_[f];
+      past_out_2[f] = past_out_2_[f];
+    }
+    mopo_float past_in_1 = past_in_1_;
+    mopo_float past_in_2 = past_in_2_;
+
+    for (int i = start; i < end; ++i) {
+      mopo_float audio = audio_buffer[i];
+      mopo_float out[MAX_FORMANTS];
+
+      for (int f = 0; f < MAX_FORMANTS; ++f) {
+        in_0[f] += delta_in_0_[f];
+        in_1[f] += delta_in_1_[f];
+        in_2[f] += delta_in_2_[f];
+        out_1[f] += delta_out_1_[f];
+        out_2[f] += delta_out_2_[f];
+
+        out[f] = audio * in_0[f] +
+                 past_in_1 * in_1[f] +
+                 past_in_2 * in_2[f] -
+                 past_out_1[f] * out_1[f] -
+                 past_out_2[f] * out_2[f];
+        past_out_2[f] = past_out_1[f];
+        past_out_1[f] = out[f];
+      }
+      past_in_2 = past_in_1;
+      past_in_1 = audio;
+
+      mopo_float total = 0.0;
+      for (int f = 0; f < MAX_FORMANTS; ++f)
+        total += out[f];
+      dest[i] = total;
+    }
+
+    for (int f = 0; f < MAX_FORMANTS; ++f) {
+      in_0_[f] = in_0[f];
+      in_1_[f] = in_1[f];
+      in_2_[f] = in_2[f];
+      out_1_[f] = out_1[f];
+      out_2_[f] = out_2[f];
+      past_out_1_[f] = past_out_1[f];
+      past_out_2_[f] = past_out_2[f];
+    }
+    past_in_1_ = past_in_1;
+    past_in_2_ = past_in_2;
+  }
+
+  void FormantManager::reset() {
+    past_in_1_ = past_in_2_ = 0.0;
+    for (int f = 0; f < MAX_FORMANTS; ++f) {
+      past_out_1_[f] = past_out_2_[f] = 0.0;
+
+      in_0_[f] = target_in_0_[f];
+      in_1_[f] = target_in_1_[f];
+      in_2_[f] = target_in_2_[f];
+      out_1_[f] = target_out_1_[f];
+      out_2_[f] = target_out_2_[f];
+    }
+  }
 } // namespace mopo
@@ -18,15 +18,21 @@
 #ifndef FORMANT_MANAGER_H
 #define FORMANT_MANAGER_H
 
-#include "processor_router.h"
+#include "processor.h"
 
 #include <complex>
 
+#define MAX_FORMANTS 4
+
 namespace mopo {
 
-  class BiquadFilter;
+  class FrequencyResponse;
 
-  class FormantManager : public ProcessorRouter {
+  // A bank of biquad formants run in parallel on the same audio and summed.
+  // All the sections run in one pass, each holding a lane of the arrays
+  // below, and share their input history. A section's coefficients are
+  // only recomputed when its type, cutoff, resonance or gain change.
+  class FormantManager : public Processor {
     public:
       enum Inputs {
         kAudio,
@@ -34,17 +40,35 @@ namespace mopo {
         kNumInputs
       };
 
-      FormantManager(int num_formants = 4);
+      enum FormantInputs {
+        kType,
+        kCutoff,
+        kResonance,
+        kGain,
+        kNumFormantInputs
+      };
+
+      FormantManager(int num_formants = MAX_FORMANTS);
 
       virtual Processor* clone() const override {
         return new FormantManager(*this);
       }
 
-      BiquadFilter* getFormant(int index = 0) { return formants_[index]; }
-      int num_formants() { return formants_.size(); }
+      virtual void process() override;
+
+      // Input index of _parameter_ for the formant at _index_.
+      static int formantInput(int index, FormantInputs parameter) {
+        return kNumInputs + index * kNumFormantInputs + parameter;
+      }
+
+      int num_formants() { return num_formants_; }
 
       std::complex<mopo_float> getResponse(mopo_float frequency);
 
+      // Multiplies _response_ by the bank's current target response. The grid
+      // has to be at this processor's sample rate.
+      void getResponse(FrequencyResponse* response);
+
       mopo_float getAmplitudeResponse(mopo_float frequency) {
         return std::abs(getResponse(frequency));
       }
@@ -54,7 +78,39 @@ namespace mopo {
       }
 
     protected:
-      std::vector<BiquadFilter*> formants_;
+      void computeTargets();
+      void tickBlock(int start, int end, const mopo_float* audio_buffer, mopo_float* dest);
+      void reset();
+
+      int num_formants_;
+
+      // Last parameters the targets were computed from.
+      mopo_float type_[MAX_FORMANTS];
+      mopo_float cutoff_[MAX_FORMANTS];
+      mopo_float resonance_[MAX_FORMANTS];
+      mopo_float gain_[MAX_FORMANTS];
+
+      // Current biquad coefficients.
+      mopo_float in_0_[MAX_FORMANTS], in_1_[MAX_FORMANTS], in_2_[MAX_FORMANTS];
+      mopo_float out_1_[MAX_FORMANTS], out_2_[MAX_FORMANTS];
+
+      // Target biquad coefficients.
+      mopo_float target_in_0_[MAX_FORMANTS];
+      mopo_float target_in_1_[MAX_FORMANTS];
+      mopo_float target_in_2_[MAX_FORMANTS];
+      mopo_float target_out_1_[MAX_FORMANTS];
+      mopo_float target_out_2_[MAX_FORMANTS];
+
+      // Per sample change of the coefficients this block.
+      mopo_float delta_in_0_[MAX_FORMANTS];
+      mopo_float delta_in_1_[MAX_FORMANTS];
+      mopo_float delta_in_2_[MAX_FORMANTS];
+      mopo_float delta_out_1_[MAX_FORMANTS];
+      mopo_float delta_out_2_[MAX_FORMANTS];
+
+      // Past input and output values.
+      mopo_float past_in_1_, past_in_2_;
+      mopo_float past_out_1_[MAX_FORMANTS], past_out_2_[MAX_FORMANTS];
   };
 } // namespace mopo
 
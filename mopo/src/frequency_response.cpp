@@ -0,0 +1,142 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frequency_response.h"
+
+#include <cmath>
+
+namespace mopo {
+
+  namespace {
+    inline void biquadResponse(const BiquadFilter::Coefficients& coefficients,
+                               mopo_float cosine, mopo_float sine,
+                               mopo_float* real, mopo_float* imag) {
+      // One and two samples of delay, e^-jw and e^-2jw.
+      mopo_float delay_real = cosine;
+      mopo_float delay_imag = -sine;
+      mopo_float delay2_real = 2.0 * cosine * cosine - 1.0;
+      mopo_float delay2_imag = 2.0 * cosine * delay_imag;
+
+      mopo_float num_real = coefficients.in_0 + coefficients.in_1 * delay_real +
+                            coefficients.in_2 * delay2_real;
+      mopo_float num_imag = coefficients.in_1 * delay_imag + coefficients.in_2 * delay2_imag;
+      mopo_float den_real = 1.0 + coefficients.out_1 * delay_real +
+                            coefficients.out_2 * delay2_real;
+      mopo_float den_imag = coefficients.out_1 * delay_imag + coefficients.out_2 * delay2_imag;
+
+      // num / den as num * conj(den) / |den|^2.
+      mopo_float den_norm = 1.0 / (den_real * den_real + den_imag * den_imag);
+      *real = (num_real * den_real + num_imag * den_imag) * den_norm;
+      *imag = (num_imag * den_real - num_real * den_imag) * den_norm;
+    }
+  } // namespace
+
+  ResponseGrid::ResponseGrid(const mopo_float* frequencies, int size, int sample_rate) :
+      sample_rate_(sample_rate), frequencies_(frequencies, frequencies + size),
+      cosines_(size), sines_(size) {
+    for (int i = 0; i < size; ++i) {
+      mopo_float phase_delta = 2.0 * PI * frequencies[i] / sample_rate;
+      cosines_[i] = cos(phase_delta);
+      sines_[i] = sin(phase_delta);
+    }
+  }
+
+  FrequencyResponse::FrequencyResponse(const ResponseGrid* grid) :
+      grid_(grid), real_(grid->size(), 1.0), imag_(grid->size(), 0.0) { }
+
+  void FrequencyResponse::setConstant(mopo_float value) {
+    int points = size();
+    for (int i = 0; i < points; ++i) {
+      real_[i] = value;
+      imag_[i] = 0.0;
+    }
+  }
+
+  void FrequencyResponse::scale(mopo_float value) {
+    int points = size();
+    for (int i = 0; i < points; ++i) {
+      real_[i] *= value;
+      imag_[i] *= value;
+    }
+  }
+
+  void FrequencyResponse::multiplyBiquad(const BiquadFilter::Coefficients& coefficients) {
+    const mopo_float* cosines = grid_->cosines();
+    const mopo_float* sines = grid_->sines();
+
+    int points = size();
+    for (int i = 0; i < points; ++i) {
+      mopo_float section_real, section_imag;
+      biquadResponse(coefficients, cosines[i], sines[i], &section_real, &section_imag);
+
+      mopo_float old_real = real_[i];
+      real_[i] = old_real * section_real - imag_[i] * section_imag;
+      imag_[i] = old_real * section_imag + imag_[i] * section_real;
+    }
+  }
+
+  void FrequencyResponse::addBiquad(const BiquadFilter::Coefficients& coefficients,
+                                    mopo_float gain) {
+    const mopo_float* cosines = grid_->cosines();
+    const mopo_float* sines = grid_->sines();
+
+    int points = size();
+    for (int i = 0; i < points; ++i) {
+      mopo_float section_real, section_imag;
+      biquadResponse(coefficients, cosines[i], sines[i], &section_real, &section_imag);
+
+      real_[i] += gain * section_real;
+      imag_[i] += gain * section_imag;
+    }
+  }
+
+  void FrequencyResponse::multiply(const FrequencyResponse& other) {
+    MOPO_ASSERT(other.grid_ == grid_);
+    const mopo_float* other_real = other.real();
+    const mopo_float* other_imag = other.imag();
+
+    int points = size();
+    for (int i = 0; i < points; ++i) {
+      mopo_float old_real = real_[i];
+      real_[i] = old_real * other_real[i] - imag_[i] * other_imag[i];
+      imag_[i] = old_real * other_imag[i] + imag_[i] * other_real[i];
+    }
+  }
+
+  void FrequencyResponse::add(const FrequencyResponse& other, mopo_float gain) {
+    MOPO_ASSERT(other.grid_ == grid_);
+    const mopo_float* other_real = other.real();
+    const mopo_float* other_imag = other.imag();
+
+    int points = size();
+    for (int i = 0; i < points; ++i) {
+      real_[i] += gain * other_real[i];
+      imag_[i] += gain * other_imag[i];
+    }
+  }
+
+  void FrequencyResponse::getMagnitudes(mopo_float* dest) const {
+    int points = size();
+    for (int i = 0; i < points; ++i)
+      dest[i] = sqrt(real_[i] * real_[i] + imag_[i] * imag_[i]);
+  }
+
+  void FrequencyResponse::getPhases(mopo_float* dest) const {
+    int points = size();
+    for (int i = 0; i < points; ++i)
+      dest[i] = atan2(imag_[i], real_[i]);
+  }
+} // namespace mopo
@@ -0,0 +1,88 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef FREQUENCY_RESPONSE_H
+#define FREQUENCY_RESPONSE_H
+
+#include "biquad_filter.h"
+#include "common.h"
+
+#include <vector>
+
+namespace mopo {
+
+  // Frequencies a response is evaluated at. The phasor of one sample delay
+  // at each of them is computed here once, so evaluating a filter on the
+  // grid takes no trigonometry.
+  class ResponseGrid {
+    public:
+      ResponseGrid(const mopo_float* frequencies, int size, int sample_rate);
+
+      int size() const { return static_cast<int>(frequencies_.size()); }
+      int sampleRate() const { return sample_rate_; }
+      const mopo_float* frequencies() const { return frequencies_.data(); }
+
+      // Cosine and sine of the phase one sample covers at each frequency.
+      const mopo_float* cosines() const { return cosines_.data(); }
+      const mopo_float* sines() const { return sines_.data(); }
+
+    private:
+      int sample_rate_;
+      std::vector<mopo_float> frequencies_;
+      std::vector<mopo_float> cosines_;
+      std::vector<mopo_float> sines_;
+  };
+
+  // Complex response of a filter at every point of a grid. Real and
+  // imaginary parts live in separate arrays and every operation is one
+  // branch free loop over the points, so they vectorize.
+  //
+  // Filters describe themselves by their getResponse methods, this class
+  // only combines sections: multiplying puts them in series, adding in
+  // parallel.
+  class FrequencyResponse {
+    public:
+      // Starts out flat, a gain of one everywhere.
+      FrequencyResponse(const ResponseGrid* grid);
+
+      const ResponseGrid* grid() const { return grid_; }
+      int size() const { return grid_->size(); }
+
+      mopo_float* real() { return real_.data(); }
+      mopo_float* imag() { return imag_.data(); }
+      const mopo_float* real() const { return real_.data(); }
+      const mopo_float* imag() const { return imag_.data(); }
+
+      void setConstant(mopo_float value);
+      void scale(mopo_float value);
+
+      void multiplyBiquad(const BiquadFilter::Coefficients& coefficients);
+      void addBiquad(const BiquadFilter::Coefficients& coefficients, mopo_float gain = 1.0);
+      void multiply(const FrequencyResponse& other);
+      void add(const FrequencyResponse& other, mopo_float gain = 1.0);
+
+      void getMagnitudes(mopo_float* dest) const;
+      void getPhases(mopo_float* dest) const;
+
+    private:
+      const ResponseGrid* grid_;
+      std::vector<mopo_float> real_;
+      std::vector<mopo_float> imag_;
+  };
+} // namespace mopo
+
+#endif // FREQUENCY_RESPONSE_H
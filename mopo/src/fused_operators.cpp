@@ -0,0 +1,111 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fused_operators.h"
+
+#include "magnitude_lookup.h"
+#include "midi_lookup.h"
+#include "resonance_lookup.h"
+#include "utils.h"
+
+#include <cmath>
+#include <set>
+
+namespace mopo {
+
+  namespace cr {
+
+    FusedOperators::FusedOperators(const std::vector<Processor*>& operators) :
+        Processor(0, 0, true) {
+      std::set<const Processor*> members(operators.begin(), operators.end());
+
+      for (Processor* processor : operators) {
+        FusedStep step;
+        bool fusable = processor->fusedStep(&step);
+        MOPO_ASSERT(fusable);
+        (void)fusable;
+        MOPO_ASSERT(processor->numInputs() <= FusedStep::MAX_INPUTS);
+
+        step.processor = processor;
+        step.output = processor->output();
+        for (int i = 0; i < FusedStep::MAX_INPUTS; ++i)
+          step.inputs[i] = i < processor->numInputs() ? processor->input(i) : nullptr;
+        steps_.push_back(step);
+
+        // Inputs from outside the tree so the router still orders us.
+        for (int i = 0; i < processor->numInputs(); ++i) {
+          const ::mopo::Output* source = processor->input(i)->source;
+          if (source && source != &null_source_ && members.count(source->owner) == 0)
+            plugNext(source);
+        }
+      }
+
+      // Readers of the operators now depend on us.
+      for (Processor* processor : operators)
+        processor->output()->owner = this;
+    }
+
+    void FusedOperators::process() {
+      for (const FusedStep& step : steps_) {
+        if (step.processor->enabled())
+          step.output->buffer[0] = evaluate(step);
+      }
+    }
+
+    // Same arithmetic as the operators in operators.h.
+    mopo_float FusedOperators::evaluate(const FusedStep& step) const {
+      mopo_float a = step.inputs[0]->at(0);
+
+      switch (step.opcode) {
+        case FusedStep::kAdd:
+          return a + step.inputs[1]->at(0);
+        case FusedStep::kMultiply:
+          return a * step.inputs[1]->at(0);
+        case FusedStep::kClamp:
+          return utils::clamp(a, step.constants[0], step.constants[1]);
+        case FusedStep::kLowerBound:
+          return utils::max(a, step.constants[0]);
+        case FusedStep::kUpperBound:
+          return utils::min(a, step.constants[0]);
+        case FusedStep::kInterpolate:
+          return utils::interpolate(a, step.inputs[1]->at(0), step.inputs[2]->at(0));
+        case FusedStep::kSquare:
+          return a * a;
+        case FusedStep::kQuadratic:
+          return a * a + step.constants[0];
+        case FusedStep::kRoot:
+          return sqrt(a) + step.constants[0];
+        case FusedStep::kExponentialScale:
+          return std::pow(step.constants[0], a) + step.constants[1];
+        case FusedStep::kFrequencyToPhase:
+          return a / sample_rate_;
+        case FusedStep::kFrequencyToSamples:
+          return sample_rate_ / a;
+        case FusedStep::kTimeToSamples:
+          return sample_rate_ * a;
+        case FusedStep::kMagnitudeScale:
+          return MagnitudeLookup::magnitudeLookup(a);
+        case FusedStep::kMidiScale:
+          return MidiLookup::centsLookup(CENTS_PER_NOTE * a);
+        case FusedStep::kResonanceScale:
+          return ResonanceLookup::qLookup(a);
+        default:
+          MOPO_ASSERT(false);
+          return a;
+      }
+    }
+  } // namespace cr
+} // namespace mopo
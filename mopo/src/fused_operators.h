@@ -0,0 +1,89 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef FUSED_OPERATORS_H
+#define FUSED_OPERATORS_H
+
+#include "processor.h"
+
+#include <vector>
+
+namespace mopo {
+
+  namespace cr {
+
+    // One control rate operator inside a FusedOperators program. The
+    // operator keeps its own inputs and output; the step only says what to
+    // compute from them.
+    struct FusedStep {
+      static const int MAX_INPUTS = 3;
+
+      enum Opcode {
+        kAdd,
+        kMultiply,
+        kClamp,
+        kLowerBound,
+        kUpperBound,
+        kInterpolate,
+        kSquare,
+        kQuadratic,
+        kRoot,
+        kExponentialScale,
+        kFrequencyToPhase,
+        kFrequencyToSamples,
+        kTimeToSamples,
+        kMagnitudeScale,
+        kMidiScale,
+        kResonanceScale,
+        kNumOpcodes
+      };
+
+      Opcode opcode;
+      mopo_float constants[2];
+
+      const Processor* processor;
+      const Input* inputs[MAX_INPUTS];
+      ::mopo::Output* output;
+    };
+
+    // Runs a tree of single value operators in one process() call instead
+    // of one virtual call each. Built by ProcessorRouter::fuseOperators,
+    // which hands over the operators and takes them out of the processing
+    // order. Every operator still writes its own output and still honors
+    // being disabled, so anything reading them sees the same values.
+    class FusedOperators : public Processor {
+      public:
+        // _operators_ in processing order, the last one is the root.
+        FusedOperators(const std::vector<Processor*>& operators);
+
+        virtual Processor* clone() const override {
+          return new FusedOperators(*this);
+        }
+
+        void process() override;
+
+        int numSteps() const { return steps_.size(); }
+
+      private:
+        mopo_float evaluate(const FusedStep& step) const;
+
+        std::vector<FusedStep> steps_;
+    };
+  } // namespace cr
+} // namespace mopo
+
+#endif // FUSED_OPERATORS_H
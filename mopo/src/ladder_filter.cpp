@@ -15,6 +15,7 @@
  */
 
 #include "ladder_filter.h"
+#include "frequency_response.h"
 #include "utils.h"
 
 #include <cmath>
@@ -27,6 +28,44 @@
 
 namespace mopo {
 
+  namespace {
+    // Plain complex arithmetic that the compiler can keep in registers
+    // across a loop, unlike std::complex's checked multiply and divide.
+    struct Complex {
+      mopo_float real, imag;
+    };
+
+    inline Complex multiply(Complex one, Complex two) {
+      return { one.real * two.real - one.imag * two.imag,
+               one.real * two.imag + one.imag * two.real };
+    }
+
+    inline Complex divide(Complex num, Complex den) {
+      mopo_float norm = 1.0 / (den.real * den.real + den.imag * den.imag);
+      return { (num.real * den.real + num.imag * den.imag) * norm,
+               (num.imag * den.real - num.real * den.imag) * norm };
+    }
+
+    // Linearized ladder at one tick of delay _delay_. Each stage integrates
+    // with the trapezoid rule on the previous stage's new value and its own
+    // old one, so its response is a (1 + z) / (1 - z + a z (1 + z)), and the
+    // resonance feeds back the output one tick late.
+    inline Complex ladderResponse(Complex delay, mopo_float a, mopo_float resonance) {
+      Complex sum = { 1.0 + delay.real, delay.imag };
+      Complex stage_num = { a * sum.real, a * sum.imag };
+      Complex delayed_sum = multiply(delay, stage_num);
+      Complex stage_den = { 1.0 - delay.real + delayed_sum.real,
+                            -delay.imag + delayed_sum.imag };
+      Complex stage = divide(stage_num, stage_den);
+      Complex stages = multiply(stage, stage);
+      stages = multiply(stages, stages);
+
+      Complex feedback = multiply(delay, stages);
+      Complex loop = { 1.0 + resonance * feedback.real, resonance * feedback.imag };
+      return divide(stages, loop);
+    }
+  } // namespace
+
   LadderFilter::LadderFilter() : Processor(LadderFilter::kNumInputs, 1) {
     current_resonance_ = 0.0;
     current_drive_ = 1.0f;
@@ -36,7 +75,12 @@ namespace mopo {
   void LadderFilter::process() {
     MOPO_ASSERT(inputMatchesBufferSize(kAudio));
 
-    mopo_float cutoff = utils::clamp(input(kCutoff)->at(0), MIN_CUTTOFF, sample_rate_);
+    // In draft mode the model integrates at the base rate, so the cutoff has
+    // to stay under the base nyquist instead of the oversampled one.
+    bool draft = input(kDraft)->at(0) != 0.0;
+    int ticks = draft ? 1 : 2;
+    mopo_float max_cutoff = draft ? sample_rate_ / 2.0 : sample_rate_;
+    mopo_float cutoff = utils::clamp(input(kCutoff)->at(0), MIN_CUTTOFF, max_cutoff);
 
     mopo_float g = g_;
     computeCoefficients(cutoff);
@@ -51,41 +95,53 @@ namespace mopo {
 
     const mopo_float* audio_buffer = input(kAudio)->source->buffer;
     mopo_float* dest = output()->buffer;
-    double two_sr = sample_rate_ * 2.0;
+    double tick_rate = sample_rate_ * ticks;
     if (input(kReset)->source->triggered &&
         input(kReset)->source->trigger_value == kVoiceReset) {
 
       int trigger_offset = input(kReset)->source->trigger_offset;
-      int i = 0;
-      for (; i < trigger_offset; ++i) {
-        g += delta_g;
-        current_resonance_ += delta_resonance;
-        current_drive_ += delta_drive;
-        tick(i, dest, audio_buffer, g, current_resonance_, two_sr);
-        tick(i, dest, audio_buffer, g, current_resonance_, two_sr);
-      }
+      tickSamples(0, trigger_offset, dest, audio_buffer, ticks,
+                  g, delta_g, delta_resonance, delta_drive, tick_rate);
 
       reset();
       current_resonance_ = resonance;
       current_drive_ = drive;
 
-      for (; i < buffer_size_; ++i) {
-        tick(i, dest, audio_buffer, g_, resonance, two_sr);
-        tick(i, dest, audio_buffer, g_, resonance, two_sr);
-      }
+      g = g_;
+      tickSamples(trigger_offset, buffer_size_, dest, audio_buffer, ticks,
+                  g, 0.0, 0.0, 0.0, tick_rate);
     }
     else {
-      for (int i = 0; i < buffer_size_; ++i) {
+      tickSamples(0, buffer_size_, dest, audio_buffer, ticks,
+                  g, delta_g, delta_resonance, delta_drive, tick_rate);
+    }
+
+    current_resonance_ = resonance;
+    current_drive_ = drive;
+  }
+
+  inline void LadderFilter::tickSamples(int start, int end, mopo_float* dest,
+                                        const mopo_float* audio_buffer, int ticks,
+                                        mopo_float& g, mopo_float delta_g,
+                                        mopo_float delta_resonance, mopo_float delta_drive,
+                                        mopo_float tick_rate) {
+    if (ticks == 1) {
+      for (int i = start; i < end; ++i) {
         g += delta_g;
         current_resonance_ += delta_resonance;
         current_drive_ += delta_drive;
-        tick(i, dest, audio_buffer, g, current_resonance_, two_sr);
-        tick(i, dest, audio_buffer, g, current_resonance_, two_sr);
+        tick(i, dest, audio_buffer, g, current_resonance_, tick_rate);
       }
+      return;
     }
 
-    current_resonance_ = resonance;
-    current_drive_ = drive;
+    for (int i = start; i < end; ++i) {
+      g += delta_g;
+      current_resonance_ += delta_resonance;
+      current_drive_ += delta_drive;
+      tick(i, dest, audio_buffer, g, current_resonance_, tick_rate);
+      tick(i, dest, audio_buffer, g, current_resonance_, tick_rate);
+    }
   }
 
   inline void LadderFilter::tick(int i, mopo_float* dest, const mopo_float* audio_buffer,
@@ -116,12 +172,73 @@ namespace mopo {
     dest[i] = v_[3];
   }
 
-  void LadderFilter::computeCoefficients(mopo_float cutoff) {
+  LadderFilter::Coefficients LadderFilter::computeCoefficients(mopo_float cutoff,
+                                                               int sample_rate) {
     MOPO_ASSERT(cutoff > 0.0);
 
-    mopo_float delta_phase = (mopo::PI * cutoff * 0.5) / sample_rate_;
-    resonance_multiple_ = 1.0 / (-1.273 * delta_phase * delta_phase + 3.5 * delta_phase + 0.7);
-    g_ = mopo::PI * TWO_THERMAL_VOLTAGE * cutoff * (1.0 - delta_phase) / (1.0 + delta_phase);
+    mopo_float delta_phase = (mopo::PI * cutoff * 0.5) / sample_rate;
+    Coefficients c;
+    c.resonance_multiple = 1.0 / (-1.273 * delta_phase * delta_phase +
+                                  3.5 * delta_phase + 0.7);
+    c.g = mopo::PI * TWO_THERMAL_VOLTAGE * cutoff * (1.0 - delta_phase) / (1.0 + delta_phase);
+    return c;
+  }
+
+  void LadderFilter::getResponse(mopo_float cutoff, mopo_float resonance,
+                                 mopo_float drive, bool draft,
+                                 FrequencyResponse* response) {
+    int sample_rate = response->grid()->sampleRate();
+    mopo_float max_cutoff = draft ? sample_rate / 2.0 : sample_rate;
+    cutoff = utils::clamp(cutoff, MIN_CUTTOFF, max_cutoff);
+
+    Coefficients c = computeCoefficients(cutoff, sample_rate);
+    resonance = utils::clamp(c.resonance_multiple * resonance / 4.0,
+                             MIN_RESONANCE, MAX_RESONANCE);
+    int ticks = draft ? 1 : 2;
+    mopo_float a = QUICK_TANH_SLOPE * c.g / (TWO_THERMAL_VOLTAGE * sample_rate * ticks);
+
+    const mopo_float* cosines = response->grid()->cosines();
+    const mopo_float* sines = response->grid()->sines();
+    mopo_float* real = response->real();
+    mopo_float* imag = response->imag();
+
+    int points = response->size();
+    for (int i = 0; i < points; ++i) {
+      Complex total;
+      if (draft)
+        total = ladderResponse({ cosines[i], -sines[i] }, a, resonance);
+      else {
+        // A sample is held for two ticks and the second one is kept. Holding
+        // makes a copy of the input at the tick nyquist mirror, which the
+        // decimation folds back on top of it, so both are evaluated.
+        mopo_float half_cos = copysign(sqrt(utils::max(0.5 + 0.5 * cosines[i], 0.0)), sines[i]);
+        mopo_float half_sin = sqrt(utils::max(0.5 - 0.5 * cosines[i], 0.0));
+        Complex delay = { half_cos, -half_sin };
+        Complex direct = ladderResponse(delay, a, resonance);
+        Complex mirror = ladderResponse({ -half_cos, half_sin }, a, resonance);
+
+        Complex direct_hold = { 0.5 + 0.5 * delay.real, 0.5 * delay.imag };
+        Complex mirror_hold = { 0.5 - 0.5 * delay.real, -0.5 * delay.imag };
+        Complex held = multiply(direct_hold, direct);
+        Complex folded = multiply(mirror_hold, mirror);
+        Complex difference = { held.real - folded.real, held.imag - folded.imag };
+
+        // Kept on the second tick, half a sample after the hold started.
+        total = multiply(difference, { half_cos, half_sin });
+      }
+
+      total.real *= drive;
+      total.imag *= drive;
+      mopo_float old_real = real[i];
+      real[i] = old_real * total.real - imag[i] * total.imag;
+      imag[i] = old_real * total.imag + imag[i] * total.real;
+    }
+  }
+
+  void LadderFilter::computeCoefficients(mopo_float cutoff) {
+    Coefficients c = computeCoefficients(cutoff, sample_rate_);
+    resonance_multiple_ = c.resonance_multiple;
+    g_ = c.g;
   }
 
   void LadderFilter::reset() {
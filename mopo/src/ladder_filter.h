@@ -22,6 +22,8 @@
 
 namespace mopo {
 
+  class FrequencyResponse;
+
   /*
    * This ladder filter implementation is based on the version in:
    * An Improved Virtual Analog Model of the Moog Ladder Filter
@@ -36,9 +38,26 @@ namespace mopo {
         kResonance,
         kDrive,
         kReset,
+        kDraft,
         kNumInputs
       };
 
+      // Stage gain _g_ and the scale that keeps resonance even across
+      // cutoffs.
+      struct Coefficients {
+        mopo_float g;
+        mopo_float resonance_multiple;
+      };
+
+      static Coefficients computeCoefficients(mopo_float cutoff, int sample_rate);
+
+      // Multiplies _response_ by the filter with these settings, clamped the
+      // way process() clamps its inputs. This is the model with every tanh
+      // replaced by its slope at zero, the response to quiet input.
+      static void getResponse(mopo_float cutoff, mopo_float resonance,
+                              mopo_float drive, bool draft,
+                              FrequencyResponse* response);
+
       LadderFilter();
       virtual ~LadderFilter() { }
 
@@ -50,6 +69,14 @@ namespace mopo {
       inline void tick(int i, mopo_float* dest, const mopo_float* audio_buffer,
                        mopo_float g, mopo_float resonance, mopo_float two_sr);
 
+      // Runs the model _ticks_ times per sample. The default is two; a
+      // nonzero kDraft input drops to one to shed load.
+      inline void tickSamples(int start, int end, mopo_float* dest,
+                              const mopo_float* audio_buffer, int ticks,
+                              mopo_float& g, mopo_float delta_g,
+                              mopo_float delta_resonance, mopo_float delta_drive,
+                              mopo_float tick_rate);
+
     private:
       void reset();
 
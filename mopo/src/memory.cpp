@@ -19,25 +19,133 @@
 
 #include <cmath>
 #include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 namespace mopo {
 
+  namespace {
+    size_t pageSize() {
+#if defined(_WIN32)
+      SYSTEM_INFO info;
+      GetSystemInfo(&info);
+      return info.dwPageSize;
+#else
+      return sysconf(_SC_PAGESIZE);
+#endif
+    }
+
+    // Whole pages, so unlocking one buffer never unlocks its neighbour.
+    size_t pageBytes(unsigned int size) {
+      size_t page = pageSize();
+      return (size * sizeof(mopo_float) + page - 1) / page * page;
+    }
+
+    bool lockPages(void* pointer, size_t bytes) {
+#if defined(_WIN32)
+      return VirtualLock(pointer, bytes);
+#else
+      return mlock(pointer, bytes) == 0;
+#endif
+    }
+
+    void unlockPages(void* pointer, size_t bytes) {
+#if defined(_WIN32)
+      VirtualUnlock(pointer, bytes);
+#else
+      munlock(pointer, bytes);
+#endif
+    }
+
+    // _older_ holds num + 1 samples, each one is blended with the next.
+    inline void interpolateRun(mopo_float* dest, const mopo_float* older,
+                               mopo_float t, int num) {
+      VECTORIZE_LOOP
+      for (int i = 0; i < num; ++i)
+        dest[i] = utils::interpolate(older[i + 1], older[i], t);
+    }
+  } // namespace
+
   Memory::Memory(int size) : offset_(0) {
-    size_ = utils::nextPowerOfTwo(size);
-    bitmask_ = size_ - 1;
-    memory_ = new mopo_float[size_];
-    utils::zeroBuffer(memory_, size_);
+    allocate(utils::nextPowerOfTwo(size));
   }
 
   Memory::Memory(const Memory& other) {
-    this->memory_ = new mopo_float[other.size_];
-    utils::zeroBuffer(this->memory_, other.size_);
-    this->size_ = other.size_;
-    this->bitmask_ = other.bitmask_;
+    allocate(other.size_);
     this->offset_ = other.offset_;
   }
 
   Memory::~Memory() {
-    delete memory_;
+    release();
+  }
+
+  void Memory::resize(int size) {
+    unsigned int new_size = utils::nextPowerOfTwo(size);
+    offset_ = 0;
+    if (new_size == size_) {
+      utils::zeroBuffer(memory_, size_);
+      return;
+    }
+
+    release();
+    allocate(new_size);
+  }
+
+  void Memory::allocate(unsigned int size) {
+    size_ = size;
+    bitmask_ = size_ - 1;
+
+    size_t bytes = pageBytes(size_);
+    memory_ = static_cast<mopo_float*>(::operator new(bytes, std::align_val_t(pageSize())));
+    utils::zeroBuffer(memory_, size_);
+    locked_ = lockPages(memory_, bytes);
+  }
+
+  void Memory::release() {
+    size_t bytes = pageBytes(size_);
+    if (locked_)
+      unlockPages(memory_, bytes);
+    ::operator delete(memory_, std::align_val_t(pageSize()));
+  }
+
+  void Memory::readBlock(mopo_float* dest, mopo_float past, int num) const {
+    MOPO_ASSERT(past >= num && num > 0);
+    int index = past;
+    mopo_float t = past - index;
+
+    // Every read shares the fraction, so this is a sliding window over
+    // num + 1 samples starting _index_ samples ago.
+    Spans spans = getSpans(index, num + 1);
+    if (spans.second_size == 0) {
+      interpolateRun(dest, spans.first, t, num);
+      return;
+    }
+
+    int first = spans.first_size - 1;
+    interpolateRun(dest, spans.first, t, first);
+    dest[first] = utils::interpolate(spans.second[0], spans.first[first], t);
+    interpolateRun(dest + spans.first_size, spans.second, t, spans.second_size - 1);
+  }
+
+  int Memory::readBlock(mopo_float* dest, const mopo_float* pasts, int num) const {
+    mopo_float min_past = 1.0;
+    for (int i = 0; i < num; ++i) {
+      if (pasts[i] < min_past)
+        return i;
+
+      int index = pasts[i];
+      mopo_float t = pasts[i] - index;
+      unsigned int spot = offset_ + i - index;
+      dest[i] = utils::interpolate(memory_[(spot + 1) & bitmask_], memory_[spot & bitmask_], t);
+      min_past += 1.0;
+    }
+    return num;
   }
 } // namespace mopo
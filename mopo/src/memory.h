@@ -28,12 +28,27 @@
 namespace mopo {
 
   // A processor utility to store a stream of data for later lookup.
+  // Buffers are page aligned and locked in RAM where the system allows,
+  // so the audio thread never faults on a delay line that was swapped out.
   class Memory {
     public:
+      // A range of stored samples, oldest first. It wraps around the end of
+      // the buffer into _second_ when _second_size_ is not zero.
+      struct Spans {
+        const mopo_float* first;
+        int first_size;
+        const mopo_float* second;
+        int second_size;
+      };
+
       Memory(int size);
       Memory(const Memory& other);
       ~Memory();
 
+      // Not realtime safe. Clears the memory and makes room for at least
+      // _size_ samples, keeping the buffer if it already fits exactly.
+      void resize(int size);
+
       void push(mopo_float sample) {
         offset_ = (offset_ + 1) & bitmask_;
         memory_[offset_] = sample;
@@ -44,7 +59,7 @@ namespace mopo {
         if (next_offset < offset_) {
           int block1 = num - next_offset - 1;
           memcpy(memory_ + offset_ + 1, samples, sizeof(mopo_float) * block1);
-          memcpy(memory_, samples + block1, sizeof(mopo_float) * next_offset);
+          memcpy(memory_, samples + block1, sizeof(mopo_float) * (next_offset + 1));
         }
         else
           memcpy(memory_ + offset_ + 1, samples, sizeof(mopo_float) * num);
@@ -57,7 +72,7 @@ namespace mopo {
         if (next_offset < offset_) {
           int block1 = num - next_offset - 1;
           memset(memory_ + offset_ + 1, 0, sizeof(mopo_float) * block1);
-          memset(memory_, 0, sizeof(mopo_float) * next_offset);
+          memset(memory_, 0, sizeof(mopo_float) * (next_offset + 1));
         }
         else
           memset(memory_ + offset_ + 1, 0, sizeof(mopo_float) * num);
@@ -81,6 +96,24 @@ namespace mopo {
         return utils::interpolate(from, to, sample_fraction);
       }
 
+      // The _num_ samples starting _past_ samples ago.
+      Spans getSpans(int past, int num) const {
+        MOPO_ASSERT(num <= size_);
+        int start = (offset_ - past) & bitmask_;
+        int first_size = std::min<int>(num, size_ - start);
+        return { memory_ + start, first_size, memory_, num - first_size };
+      }
+
+      // Block versions of get(). _dest_[i] is what get() returns after i
+      // more pushes, so a delay line can read a whole block before pushing
+      // it. Only stored samples are read, so the delay for _dest_[i] must be
+      // at least i + 1.
+      void readBlock(mopo_float* dest, mopo_float past, int num) const;
+
+      // Per sample delays. Stops at the first delay that is too short and
+      // returns the number of samples read.
+      int readBlock(mopo_float* dest, const mopo_float* pasts, int num) const;
+
       unsigned int getOffset() const { return offset_; }
 
       void setOffset(int offset) { offset_ = offset; }
@@ -97,11 +130,19 @@ namespace mopo {
         return size_;
       }
 
+      bool isLocked() const {
+        return locked_;
+      }
+
     protected:
+      void allocate(unsigned int size);
+      void release();
+
       mopo_float* memory_;
       unsigned int size_;
       unsigned int bitmask_;
       unsigned int offset_;
+      bool locked_;
   };
 } // namespace mopo
 
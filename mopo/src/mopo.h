@@ -30,6 +30,8 @@
 #include "envelope.h"
 #include "feedback.h"
 #include "formant_manager.h"
+#include "frequency_response.h"
+#include "fused_operators.h"
 #include "linear_slope.h"
 #include "magnitude_lookup.h"
 #include "memory.h"
@@ -38,9 +40,13 @@
 #include "note_handler.h"
 #include "operators.h"
 #include "oscillator.h"
+#include "oversampler.h"
 #include "portamento_slope.h"
 #include "processor.h"
 #include "processor_router.h"
+#include "profiler.h"
+#include "random_generator.h"
+#include "realtime_audit.h"
 #include "resonance_lookup.h"
 #include "reverb.h"
 #include "reverb_all_pass.h"
@@ -52,10 +58,12 @@
 #include "step_generator.h"
 #include "stutter.h"
 #include "tick_router.h"
+#include "trace_recorder.h"
 #include "trigger_operators.h"
 #include "utils.h"
 #include "value.h"
 #include "voice_handler.h"
+#include "voice_retirement.h"
 #include "wave.h"
 
 #endif // MOPO_H
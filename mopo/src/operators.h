@@ -18,6 +18,7 @@
 #ifndef OPERATORS_H
 #define OPERATORS_H
 
+#include "fused_operators.h"
 #include "magnitude_lookup.h"
 #include "midi_lookup.h"
 #include "resonance_lookup.h"
@@ -538,6 +539,13 @@ namespace mopo {
 
         virtual Processor* clone() const override { return new Clamp(*this); }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kClamp;
+          step->constants[0] = min_;
+          step->constants[1] = max_;
+          return true;
+        }
+
         void process() override {
           tick(0);
         }
@@ -561,6 +569,12 @@ namespace mopo {
 
         virtual Processor* clone() const override { return new LowerBound(*this); }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kLowerBound;
+          step->constants[0] = min_;
+          return true;
+        }
+
         void process() override {
           tick(0);
         }
@@ -584,6 +598,12 @@ namespace mopo {
 
         virtual Processor* clone() const override { return new UpperBound(*this); }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kUpperBound;
+          step->constants[0] = max_;
+          return true;
+        }
+
         void process() override {
           tick(0);
         }
@@ -607,6 +627,11 @@ namespace mopo {
 
         virtual Processor* clone() const override { return new Add(*this); }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kAdd;
+          return true;
+        }
+
         inline void tick(int i) override {
           output()->buffer[0] = input(0)->at(0) + input(1)->at(0);
         }
@@ -623,6 +648,11 @@ namespace mopo {
 
         virtual Processor* clone() const override { return new Multiply(*this); }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kMultiply;
+          return true;
+        }
+
         inline void tick(int i) override {
           output()->buffer[0] = input(0)->at(0) * input(1)->at(0);
         }
@@ -648,6 +678,11 @@ namespace mopo {
         return new Interpolate(*this);
       }
 
+      bool fusedStep(FusedStep* step) const override {
+        step->opcode = FusedStep::kInterpolate;
+        return true;
+      }
+
       void process() override {
         tick(0);
       }
@@ -672,6 +707,11 @@ namespace mopo {
       Square() : Operator(1, 1, true) { }
       virtual Processor* clone() const override { return new Square(*this); }
 
+      bool fusedStep(FusedStep* step) const override {
+        step->opcode = FusedStep::kSquare;
+        return true;
+      }
+
       void process() override {
         tick(0);
       }
@@ -691,6 +731,12 @@ namespace mopo {
         Quadratic(mopo_float offset) : Operator(1, 1, true), offset_(offset) { }
         virtual Processor* clone() const override { return new Quadratic(*this); }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kQuadratic;
+          step->constants[0] = offset_;
+          return true;
+        }
+
         void process() override {
           tick(0);
         }
@@ -714,6 +760,12 @@ namespace mopo {
         Root(mopo_float offset) : Operator(1, 1, true), offset_(offset) { }
         virtual Processor* clone() const override { return new Root(*this); }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kRoot;
+          step->constants[0] = offset_;
+          return true;
+        }
+
         void process() override {
           tick(0);
         }
@@ -740,6 +792,13 @@ namespace mopo {
           return new ExponentialScale(*this);
         }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kExponentialScale;
+          step->constants[0] = scale_;
+          step->constants[1] = offset_;
+          return true;
+        }
+
         void process() override {
           tick(0);
         }
@@ -795,6 +854,11 @@ namespace mopo {
           return new FrequencyToPhase(*this);
         }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kFrequencyToPhase;
+          return true;
+        }
+
         void process() override {
           tick(0);
         }
@@ -816,6 +880,11 @@ namespace mopo {
           return new FrequencyToSamples(*this);
         }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kFrequencyToSamples;
+          return true;
+        }
+
         void process() override {
           tick(0);
         }
@@ -837,6 +906,11 @@ namespace mopo {
           return new TimeToSamples(*this);
         }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kTimeToSamples;
+          return true;
+        }
+
         void process() override {
           tick(0);
         }
@@ -860,6 +934,11 @@ namespace mopo {
           return new MagnitudeScale(*this);
         }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kMagnitudeScale;
+          return true;
+        }
+
         void process() override {
           tick(0);
         }
@@ -882,6 +961,11 @@ namespace mopo {
           return new MidiScale(*this);
         }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kMidiScale;
+          return true;
+        }
+
         void process() override {
           tick(0);
         }
@@ -905,6 +989,11 @@ namespace mopo {
           return new ResonanceScale(*this);
         }
 
+        bool fusedStep(FusedStep* step) const override {
+          step->opcode = FusedStep::kResonanceScale;
+          return true;
+        }
+
         void process() override {
           tick(0);
         }
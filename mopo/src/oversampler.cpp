@@ -0,0 +1,309 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oversampler.h"
+
+#include "utils.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mopo {
+
+  namespace {
+    // Blackman-Harris windowed sinc with a cutoff at half the band. Only the
+    // odd offsets from the center are stored, reversed so the convolution
+    // walks forward through the history. They sum to one half; the center
+    // tap is the other half.
+    struct HalfbandCoefficients {
+      HalfbandCoefficients() {
+        compute(short_taps, HalfbandFilter::kShortTaps);
+        compute(long_taps, HalfbandFilter::kLongTaps);
+      }
+
+      static void compute(mopo_float* coefficients, int taps) {
+        int center = taps - 1;
+        mopo_float total = 0.0;
+        for (int k = 0; k < taps; ++k) {
+          int offset = 2 * k - center;
+          mopo_float x = PI * offset / 2.0;
+          mopo_float sinc = sin(x) / x;
+
+          mopo_float phase = (2.0 * PI * (2 * k + 1)) / (2 * center + 2);
+          mopo_float window = 0.35875 - 0.48829 * cos(phase) +
+                              0.14128 * cos(2.0 * phase) - 0.01168 * cos(3.0 * phase);
+          coefficients[taps - 1 - k] = sinc * window;
+          total += sinc * window;
+        }
+
+        for (int k = 0; k < taps; ++k)
+          coefficients[k] *= 0.5 / total;
+      }
+
+      mopo_float short_taps[HalfbandFilter::kShortTaps];
+      mopo_float long_taps[HalfbandFilter::kLongTaps];
+    };
+
+    const HalfbandCoefficients& halfbandCoefficients() {
+      static const HalfbandCoefficients coefficients;
+      return coefficients;
+    }
+  } // namespace
+
+  HalfbandFilter::HalfbandFilter(int taps) {
+    setTaps(taps);
+  }
+
+  void HalfbandFilter::setTaps(int taps) {
+    MOPO_ASSERT(taps == kShortTaps || taps == kLongTaps);
+    taps_ = taps;
+    if (taps == kShortTaps)
+      coefficients_ = halfbandCoefficients().short_taps;
+    else
+      coefficients_ = halfbandCoefficients().long_taps;
+  }
+
+  HalfbandUpsampler::HalfbandUpsampler(int taps) : HalfbandFilter(taps) {
+    reset();
+  }
+
+  void HalfbandUpsampler::setTaps(int taps) {
+    HalfbandFilter::setTaps(taps);
+    reset();
+  }
+
+  void HalfbandUpsampler::reset() {
+    utils::zeroBuffer(history_, MAX_BUFFER_SIZE + MAX_TAPS);
+  }
+
+  void HalfbandUpsampler::process(const mopo_float* source, mopo_float* dest, int samples) {
+    MOPO_ASSERT(samples <= MAX_BUFFER_SIZE);
+    int taps = taps_;
+    int delay = taps / 2;
+    int history = taps - 1;
+    const mopo_float* coefficients = coefficients_;
+
+    utils::copyBuffer(history_ + history, source, samples);
+
+    for (int i = 0; i < samples; ++i) {
+      const mopo_float* window = history_ + i;
+      mopo_float total = 0.0;
+
+      VECTORIZE_LOOP
+      for (int k = 0; k < taps; ++k)
+        total += coefficients[k] * window[k];
+
+      dest[2 * i] = 2.0 * total;
+      dest[2 * i + 1] = window[delay];
+    }
+
+    memmove(history_, history_ + samples, history * sizeof(mopo_float));
+  }
+
+  HalfbandDownsampler::HalfbandDownsampler(int taps) : HalfbandFilter(taps) {
+    reset();
+  }
+
+  void HalfbandDownsampler::setTaps(int taps) {
+    HalfbandFilter::setTaps(taps);
+    reset();
+  }
+
+  void HalfbandDownsampler::reset() {
+    utils::zeroBuffer(even_history_, MAX_BUFFER_SIZE / 2 + MAX_TAPS);
+    utils::zeroBuffer(odd_history_, MAX_BUFFER_SIZE / 2 + MAX_TAPS);
+  }
+
+  void HalfbandDownsampler::process(const mopo_float* source, mopo_float* dest, int samples) {
+    MOPO_ASSERT(samples <= MAX_BUFFER_SIZE / 2);
+    int taps = taps_;
+    int even_history = taps - 1;
+    int odd_history = taps / 2;
+    const mopo_float* coefficients = coefficients_;
+
+    mopo_float* even = even_history_ + even_history;
+    mopo_float* odd = odd_history_ + odd_history;
+    for (int i = 0; i < samples; ++i) {
+      even[i] = source[2 * i];
+      odd[i] = source[2 * i + 1];
+    }
+
+    for (int i = 0; i < samples; ++i) {
+      const mopo_float* window = even_history_ + i;
+      mopo_float total = 0.0;
+
+      VECTORIZE_LOOP
+      for (int k = 0; k < taps; ++k)
+        total += coefficients[k] * window[k];
+
+      dest[i] = total + 0.5 * odd_history_[i];
+    }
+
+    memmove(even_history_, even_history_ + samples, even_history * sizeof(mopo_float));
+    memmove(odd_history_, odd_history_ + samples, odd_history * sizeof(mopo_float));
+  }
+
+  Oversampler::Oversampler() : ProcessorRouter(kNumInputs, kNumOutputs),
+      stages_(0), pad_(0), minimum_stages_(0), internal_buffer_size_(0), oversampled_output_(nullptr) {
+    // Later stages only have to reject what the first stage let through,
+    // so they get away with the short filter.
+    for (int i = 1; i < MAX_STAGES; ++i) {
+      upsamplers_[i].setTaps(HalfbandFilter::kShortTaps);
+      downsamplers_[i].setTaps(HalfbandFilter::kShortTaps);
+    }
+    utils::zeroBuffer(pad_history_, 1 << MAX_STAGES);
+  }
+
+  void Oversampler::process() {
+    MOPO_ASSERT(inputMatchesBufferSize(kAudio));
+    MOPO_ASSERT(oversampled_output_);
+
+    int stages = utils::iclamp(input(kStages)->at(0), minimum_stages_, MAX_STAGES);
+    if (stages != stages_)
+      setStages(stages);
+
+    const mopo_float* source = input(kAudio)->source->buffer;
+    mopo_float* dest = output(kDownsampled)->buffer;
+    int amount = getOversampleAmount();
+    int chunk = MAX_BUFFER_SIZE / amount;
+
+    for (int offset = 0; offset < buffer_size_; offset += chunk) {
+      int samples = std::min(chunk, buffer_size_ - offset);
+      setInternalBufferSize(samples * amount);
+
+      upsample(source + offset, samples);
+      ProcessorRouter::process();
+      downsample(dest + offset, samples);
+    }
+  }
+
+  void Oversampler::setSampleRate(int sample_rate) {
+    ProcessorRouter::setSampleRate(sample_rate * getOversampleAmount());
+    Processor::setSampleRate(sample_rate);
+  }
+
+  void Oversampler::setBufferSize(int buffer_size) {
+    Processor::setBufferSize(buffer_size);
+    internal_buffer_size_ = 0;
+  }
+
+  void Oversampler::addProcessor(Processor* processor) {
+    ProcessorRouter::addProcessor(processor);
+    internal_buffer_size_ = 0;
+  }
+
+  void Oversampler::addReaders(reader_map* readers) const {
+    ProcessorRouter::addReaders(readers);
+    if (oversampled_output_)
+      readers->insert(std::make_pair(oversampled_output_, this));
+  }
+
+  void Oversampler::setMinimumStages(int stages) {
+    minimum_stages_ = stages;
+    int current = utils::iclamp(input(kStages)->at(0), minimum_stages_, MAX_STAGES);
+    if (current != stages_)
+      setStages(current);
+  }
+
+  int Oversampler::getLatency() const {
+    return (getFilterLatency() + pad_) / getOversampleAmount();
+  }
+
+  int Oversampler::getFilterLatency() const {
+    int amount = getOversampleAmount();
+    int latency = 0;
+    for (int i = 0; i < stages_; ++i) {
+      int rate = 2 << i;
+      latency += (upsamplers_[i].latency() + downsamplers_[i].latency()) * (amount / rate);
+    }
+    return latency;
+  }
+
+  void Oversampler::setStages(int stages) {
+    stages_ = stages;
+    setSampleRate(sample_rate_);
+    internal_buffer_size_ = 0;
+
+    for (int i = 0; i < MAX_STAGES; ++i) {
+      upsamplers_[i].reset();
+      downsamplers_[i].reset();
+    }
+
+    // Pads the filter latency up to a whole base sample.
+    int amount = getOversampleAmount();
+    pad_ = (amount - getFilterLatency() % amount) % amount;
+    utils::zeroBuffer(pad_history_, 1 << MAX_STAGES);
+  }
+
+  void Oversampler::setInternalBufferSize(int buffer_size) {
+    if (buffer_size == internal_buffer_size_)
+      return;
+
+    int base_buffer_size = buffer_size_;
+    ProcessorRouter::setBufferSize(buffer_size);
+    Processor::setBufferSize(base_buffer_size);
+    internal_buffer_size_ = buffer_size;
+  }
+
+  void Oversampler::upsample(const mopo_float* source, int samples) {
+    mopo_float* dest = output(kUpsampled)->buffer;
+    if (stages_ == 0) {
+      utils::copyBuffer(dest, source, samples);
+      return;
+    }
+
+    // Alternate scratch buffers so no stage reads what it is writing.
+    const mopo_float* stage_source = source;
+    for (int i = 0; i < stages_; ++i) {
+      mopo_float* stage_dest = dest;
+      if (i < stages_ - 1)
+        stage_dest = (i % 2) ? down_buffer_ : up_buffer_;
+
+      upsamplers_[i].process(stage_source, stage_dest, samples << i);
+      stage_source = stage_dest;
+    }
+    pad(dest, samples << stages_);
+  }
+
+  void Oversampler::downsample(mopo_float* dest, int samples) {
+    const mopo_float* source = oversampled_output_->buffer;
+    if (stages_ == 0) {
+      utils::copyBuffer(dest, source, samples);
+      return;
+    }
+
+    const mopo_float* stage_source = source;
+    for (int i = stages_ - 1; i >= 0; --i) {
+      mopo_float* stage_dest = dest;
+      if (i > 0)
+        stage_dest = (i % 2) ? up_buffer_ : down_buffer_;
+
+      downsamplers_[i].process(stage_source, stage_dest, samples << i);
+      stage_source = stage_dest;
+    }
+  }
+
+  void Oversampler::pad(mopo_float* dest, int samples) {
+    if (pad_ == 0)
+      return;
+
+    mopo_float tail[1 << MAX_STAGES];
+    utils::copyBuffer(tail, dest + samples - pad_, pad_);
+    memmove(dest + pad_, dest, (samples - pad_) * sizeof(mopo_float));
+    utils::copyBuffer(dest, pad_history_, pad_);
+    utils::copyBuffer(pad_history_, tail, pad_);
+  }
+} // namespace mopo
@@ -0,0 +1,147 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef OVERSAMPLER_H
+#define OVERSAMPLER_H
+
+#include "processor_router.h"
+
+namespace mopo {
+
+  // Linear phase half-band FIR split into its two polyphase branches. One
+  // branch is a pure delay, so only _taps_ multiplies are done per output
+  // pair. _taps_ counts the nonzero off center coefficients.
+  class HalfbandFilter {
+    public:
+      static const int kShortTaps = 8;
+      static const int kLongTaps = 16;
+      static const int MAX_TAPS = kLongTaps;
+
+      HalfbandFilter(int taps = kLongTaps);
+
+      void setTaps(int taps);
+      int taps() const { return taps_; }
+
+      // Latency of one pass through the filter in samples at the high rate.
+      int latency() const { return taps_ - 1; }
+
+    protected:
+      int taps_;
+      const mopo_float* coefficients_;
+  };
+
+  class HalfbandUpsampler : public HalfbandFilter {
+    public:
+      HalfbandUpsampler(int taps = kLongTaps);
+
+      void setTaps(int taps);
+      void reset();
+
+      // Writes 2 * _samples_ values to _dest_.
+      void process(const mopo_float* source, mopo_float* dest, int samples);
+
+    private:
+      mopo_float history_[MAX_BUFFER_SIZE + MAX_TAPS];
+  };
+
+  class HalfbandDownsampler : public HalfbandFilter {
+    public:
+      HalfbandDownsampler(int taps = kLongTaps);
+
+      void setTaps(int taps);
+      void reset();
+
+      // Reads 2 * _samples_ values from _source_.
+      void process(const mopo_float* source, mopo_float* dest, int samples);
+
+    private:
+      mopo_float even_history_[MAX_BUFFER_SIZE / 2 + MAX_TAPS];
+      mopo_float odd_history_[MAX_BUFFER_SIZE / 2 + MAX_TAPS];
+  };
+
+  // Runs its processors at 2, 4 or 8 times the sample rate. Plug the
+  // processors to wrap into audio() and point setOversampledOutput at the
+  // result. Works on the mono bus or inside a voice.
+  //
+  // Wrapped processors must only read audio through audio(): other audio
+  // rate inputs and trigger offsets are still at the base rate.
+  class Oversampler : public ProcessorRouter {
+    public:
+      static const int MAX_STAGES = 3;
+
+      enum Inputs {
+        kAudio,
+        kStages,
+        kNumInputs
+      };
+
+      enum Outputs {
+        kDownsampled,
+        kUpsampled,
+        kNumOutputs
+      };
+
+      Oversampler();
+
+      virtual Processor* clone() const override {
+        return new Oversampler(*this);
+      }
+
+      void process() override;
+      void setSampleRate(int sample_rate) override;
+      void setBufferSize(int buffer_size) override;
+      void addProcessor(Processor* processor) override;
+      void addReaders(reader_map* readers) const override;
+
+      Output* audio() { return output(kUpsampled); }
+      void setOversampledOutput(const Output* output) { oversampled_output_ = output; }
+
+      // Runs at least _stages_ stages whatever kStages asks for. Takes
+      // effect at once so getLatency() can be reported ahead.
+      void setMinimumStages(int stages);
+
+      int getStages() const { return stages_; }
+      int getOversampleAmount() const { return 1 << stages_; }
+
+      // Round trip latency in samples at the base rate. The upsampled audio
+      // is padded by under one base sample so this is a whole number.
+      int getLatency() const;
+
+    private:
+      // Round trip latency of the filters in samples at the top rate.
+      int getFilterLatency() const;
+      void setStages(int stages);
+      void setInternalBufferSize(int buffer_size);
+      void upsample(const mopo_float* source, int samples);
+      void downsample(mopo_float* dest, int samples);
+      void pad(mopo_float* dest, int samples);
+
+      int stages_;
+      int pad_;
+      int minimum_stages_;
+      int internal_buffer_size_;
+      const Output* oversampled_output_;
+
+      HalfbandUpsampler upsamplers_[MAX_STAGES];
+      HalfbandDownsampler downsamplers_[MAX_STAGES];
+      mopo_float up_buffer_[MAX_BUFFER_SIZE];
+      mopo_float down_buffer_[MAX_BUFFER_SIZE];
+      mopo_float pad_history_[1 << MAX_STAGES];
+  };
+} // namespace mopo
+
+#endif // OVERSAMPLER_H
@@ -63,6 +63,13 @@ namespace mopo {
     return false;
   }
 
+  void Processor::addReaders(reader_map* readers) const {
+    for (const Input* input : *inputs_) {
+      if (input && input->source)
+        readers->insert(std::make_pair(input->source, this));
+    }
+  }
+
   void Processor::plug(const Output* source) {
     plug(source, 0);
   }
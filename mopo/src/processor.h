@@ -20,13 +20,16 @@
 
 #include "common.h"
 
+#include <cstdint>
 #include <cstring>
+#include <map>
 #include <vector>
 
 namespace mopo {
 
   class Processor;
   class ProcessorRouter;
+  class ProfileSection;
 
   // An output port from the Processor.
   struct Output {
@@ -86,8 +89,13 @@ namespace mopo {
     struct Output : public ::mopo::Output {
       Output() : ::mopo::Output(1) { }
     };
+
+    struct FusedStep;
   } // namespace cr
 
+  // Every Output read somewhere in a graph, with the Processors reading it.
+  typedef std::multimap<const Output*, const Processor*> reader_map;
+
   class Processor {
     public:
       Processor(int num_inputs, int num_outputs, bool control_rate = false);
@@ -152,6 +160,30 @@ namespace mopo {
 
       virtual bool isPolyphonic() const;
 
+      // Pure single value operators describe themselves as a step of a
+      // cr::FusedOperators program. Returns false if this can't be fused.
+      virtual bool fusedStep(cr::FusedStep*) const { return false; }
+
+      // Adds every Output this Processor, or anything inside it, reads.
+      virtual void addReaders(reader_map* readers) const;
+
+      // Heap each copy of this Processor holds for its own state, like
+      // delay lines. Outputs are shared between copies and not counted.
+      virtual size_t allocatedBytes() const { return 0; }
+
+      // Processors with random streams restart them from _seed_. Routers
+      // give each processor, and each copy of it, its own seed.
+      virtual void setRandomSeed(uint64_t) { }
+
+#if MOPO_PROFILE
+      // Every run of this Processor and its copies is timed under _section_.
+      void setProfileSection(ProfileSection* section) { profile_section_ = section; }
+      ProfileSection* profileSection() const { return profile_section_; }
+#else
+      void setProfileSection(ProfileSection*) { }
+      ProfileSection* profileSection() const { return nullptr; }
+#endif
+
       // Attaches an output to an input in this processor.
       void plug(const Output* source);
       void plug(const Output* source, unsigned int input_index);
@@ -229,6 +261,10 @@ namespace mopo {
 
       ProcessorRouter* router_;
 
+#if MOPO_PROFILE
+      ProfileSection* profile_section_ = nullptr;
+#endif
+
       static const Output null_source_;
   };
 } // namespace mopo
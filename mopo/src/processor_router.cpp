@@ -17,6 +17,10 @@
 #include "processor_router.h"
 
 #include "feedback.h"
+#include "fused_operators.h"
+#include "profiler.h"
+#include "random_generator.h"
+#include "trace_recorder.h"
 
 #include <algorithm>
 #include <vector>
@@ -53,6 +57,8 @@ namespace mopo {
       local_feedback_order_[i] = clone;
       feedback_processors_[next] = clone;
     }
+
+    reserveStaleProcessors();
   }
 
   ProcessorRouter::~ProcessorRouter() {
@@ -65,6 +71,9 @@ namespace mopo {
       processor->destroy();
       delete processor;
     }
+
+    for (Processor* processor : stale_processors_)
+      delete processor;
   }
 
   void ProcessorRouter::process() {
@@ -78,8 +87,11 @@ namespace mopo {
     // Run all the main processors.
     int num_processors = local_order_.size();
     for (int i = 0; i < num_processors; ++i) {
-      if (local_order_[i]->enabled())
+      if (local_order_[i]->enabled()) {
+        ProfileScope scope(local_order_[i]->profileSection());
+        TraceScope trace(local_order_[i]);
         local_order_[i]->process();
+      }
     }
 
     // Store the outputs into the Feedback objects for next time.
@@ -127,6 +139,32 @@ namespace mopo {
       local_feedback_order_[i]->setBufferSize(buffer_size);
   }
 
+  void ProcessorRouter::addReaders(reader_map* readers) const {
+    Processor::addReaders(readers);
+
+    for (const Processor* processor : *global_order_)
+      processor->addReaders(readers);
+    for (const Feedback* feedback : *global_feedback_order_)
+      feedback->addReaders(readers);
+  }
+
+  size_t ProcessorRouter::allocatedBytes() const {
+    size_t bytes = 0;
+    for (const Processor* processor : local_order_)
+      bytes += processor->allocatedBytes();
+    return bytes;
+  }
+
+  void ProcessorRouter::setRandomSeed(uint64_t seed) {
+    updateAllProcessors();
+
+    // Processing order doesn't depend on where things live in memory, so
+    // the same graph always hands out the same seeds.
+    int num_processors = local_order_.size();
+    for (int i = 0; i < num_processors; ++i)
+      local_order_[i]->setRandomSeed(RandomGenerator::mix(seed, i));
+  }
+
   void ProcessorRouter::addProcessor(Processor* processor) {
     MOPO_ASSERT(processor->router() == 0 || processor->router() == this);
     (*global_changes_)++;
@@ -166,6 +204,34 @@ namespace mopo {
     processors_.erase(processor);
   }
 
+  Processor* ProcessorRouter::getLocalProcessor(const Processor* processor) const {
+    auto found = processors_.find(processor);
+    if (found != processors_.end())
+      return found->second;
+
+    const ProcessorRouter* parent = processor->router();
+    if (parent == nullptr)
+      return nullptr;
+
+    Processor* local_parent = getLocalProcessor(parent);
+    ProcessorRouter* local_router = dynamic_cast<ProcessorRouter*>(local_parent);
+    if (local_router == nullptr || local_router == this)
+      return nullptr;
+    return local_router->getLocalProcessor(processor);
+  }
+
+  void ProcessorRouter::freeStaleProcessors() {
+    for (Processor* processor : stale_processors_)
+      delete processor;
+    stale_processors_.clear();
+
+    for (Processor* processor : local_order_) {
+      ProcessorRouter* router = dynamic_cast<ProcessorRouter*>(processor);
+      if (router)
+        router->freeStaleProcessors();
+    }
+  }
+
   void ProcessorRouter::connect(Processor* destination,
                                 const Output* source, int index) {
     if (isDownstream(destination, source->owner)) {
@@ -274,6 +340,76 @@ namespace mopo {
     return false;
   }
 
+  int ProcessorRouter::fuseOperators(const std::set<const Output*>& exposed) {
+    // Readers anywhere in the graph count, not only the ones in here.
+    const ProcessorRouter* top_level = getTopLevelRouter();
+    reader_map readers;
+    if (top_level)
+      top_level->addReaders(&readers);
+    else
+      addReaders(&readers);
+
+    // Walking backwards, an operator read by exactly one other operator of
+    // this router joins that operator's tree.
+    std::map<const Processor*, const Processor*> roots;
+    for (int i = global_order_->size() - 1; i >= 0; --i) {
+      const Processor* processor = global_order_->at(i);
+      cr::FusedStep step;
+      if (!processor->fusedStep(&step))
+        continue;
+
+      roots[processor] = processor;
+      const Output* output = processor->output();
+      if (readers.count(output) != 1 || exposed.count(output))
+        continue;
+
+      const Processor* reader = readers.find(output)->second;
+      if (roots.count(reader))
+        roots[processor] = roots[reader];
+    }
+
+    std::map<const Processor*, std::vector<Processor*>> trees;
+    for (const Processor* processor : *global_order_) {
+      if (roots.count(processor))
+        trees[roots[processor]].push_back(processors_[processor]);
+    }
+
+    // Nothing else reads the operators below a root, so the whole tree can
+    // run where the root was.
+    std::vector<const Processor*> new_order;
+    for (const Processor* processor : *global_order_) {
+      if (roots.count(processor) == 0 || trees[roots[processor]].size() < 2)
+        new_order.push_back(processor);
+      else if (roots[processor] == processor) {
+        std::vector<Processor*>& tree = trees[processor];
+        cr::FusedOperators* fused = new cr::FusedOperators(tree);
+        fused->router(this);
+        fused->setSampleRate(sample_rate_);
+        fused->setBufferSize(getBufferSize());
+        processors_[fused] = fused;
+        new_order.push_back(fused);
+
+        for (Processor* member : tree) {
+          processors_.erase(member);
+          addIdleProcessor(member);
+        }
+      }
+    }
+
+    int removed = global_order_->size() - new_order.size();
+    if (removed == 0)
+      return 0;
+
+    (*global_changes_)++;
+    local_changes_ = *global_changes_;
+    (*global_order_) = new_order;
+    local_order_.assign(new_order.size(), 0);
+    for (size_t i = 0; i < new_order.size(); ++i)
+      local_order_[i] = processors_[new_order[i]];
+
+    return removed;
+  }
+
   ProcessorRouter* ProcessorRouter::getMonoRouter() {
     if (isPolyphonic(this))
       return router_->getMonoRouter();
@@ -321,6 +457,7 @@ namespace mopo {
         processors_[next] = next->clone();
       local_order_[i] = processors_[next];
     }
+    reserveStaleProcessors();
 
     size_t num_feedbacks = global_feedback_order_->size();
     for (int i = 0; i < num_feedbacks; ++i) {
@@ -330,9 +467,29 @@ namespace mopo {
       local_feedback_order_[i] = feedback_processors_[next];
     }
 
+    // Drop our copies of anything that left the order, like operators
+    // that were fused. They're freed later by freeStaleProcessors.
+    if (processors_.size() > num_processors) {
+      auto order_begin = global_order_->begin();
+      auto order_end = global_order_->end();
+      for (auto iter = processors_.begin(); iter != processors_.end();) {
+        if (std::find(order_begin, order_end, iter->first) == order_end) {
+          if (iter->second != iter->first)
+            stale_processors_.push_back(iter->second);
+          iter = processors_.erase(iter);
+        }
+        else
+          ++iter;
+      }
+    }
+
     local_changes_ = *global_changes_;
   }
 
+  void ProcessorRouter::reserveStaleProcessors() {
+    stale_processors_.reserve(stale_processors_.size() + processors_.size());
+  }
+
   const Processor* ProcessorRouter::getContext(const Processor* processor)
       const {
     const Processor* context = processor;
@@ -42,11 +42,23 @@ namespace mopo {
       virtual void process() override;
       virtual void setSampleRate(int sample_rate) override;
       virtual void setBufferSize(int buffer_size) override;
+      virtual void addReaders(reader_map* readers) const override;
+      virtual size_t allocatedBytes() const override;
+      virtual void setRandomSeed(uint64_t seed) override;
 
       virtual void addProcessor(Processor* processor);
       virtual void addIdleProcessor(Processor* processor);
       virtual void removeProcessor(const Processor* processor);
 
+      // Returns this router's copy of _processor_, which can sit in a router
+      // below. Null if _processor_ isn't in the graph.
+      Processor* getLocalProcessor(const Processor* processor) const;
+
+      // Copies that left the order are only dropped by updateAllProcessors,
+      // which can run on the audio thread. This deletes them, here and in
+      // every router below. Call from the control thread.
+      virtual void freeStaleProcessors();
+
       // Any time new dependencies are added into the ProcessorRouter graph, we
       // should call _connect_ on the destination Processor and source Output.
       void connect(Processor* destination, const Output* source, int index);
@@ -56,6 +68,14 @@ namespace mopo {
 
       virtual bool isPolyphonic(const Processor* processor) const;
 
+      // Replaces each tree of single value operators, where every operator
+      // but the last is only read by another operator of the tree, with one
+      // cr::FusedOperators in the last one's place. Call once the graph is
+      // built. Outputs in _exposed_ may get more readers later (modulation
+      // sources) so they always end a tree. Returns how many processors left
+      // the processing order.
+      int fuseOperators(const std::set<const Output*>& exposed = std::set<const Output*>());
+
       virtual ProcessorRouter* getMonoRouter();
       virtual ProcessorRouter* getPolyRouter();
 
@@ -72,6 +92,10 @@ namespace mopo {
       // Ensures we have all copies of all processors and feedback processors.
       virtual void updateAllProcessors();
 
+      // Makes room for every copy we hold to go stale, so dropping them
+      // never grows stale_processors_ while processing.
+      void reserveStaleProcessors();
+
       // Returns the ancestor of _processor_ which is a child of _this_.
       // Returns null if _processor_ is not a descendant of _this_.
       const Processor* getContext(const Processor* processor) const;
@@ -82,6 +106,7 @@ namespace mopo {
       std::vector<Processor*> local_order_;
       std::map<const Processor*, Processor*> processors_;
       std::vector<Processor*> idle_processors_;
+      std::vector<Processor*> stale_processors_;
 
       std::vector<const Feedback*>* global_feedback_order_;
       std::vector<Feedback*> local_feedback_order_;
@@ -0,0 +1,195 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "profiler.h"
+
+#if MOPO_PROFILE
+
+#include <algorithm>
+
+#define FIRST_BUCKET_BITS 8
+#define BLOCK_SECTION_NAME "block"
+
+namespace mopo {
+
+  namespace {
+    // The relaxed load then store pairs below are safe with one writer and
+    // are cheaper than read modify write instructions.
+    template<class T>
+    void increment(std::atomic<T>& value, T amount) {
+      value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    template<class T>
+    void raise(std::atomic<T>& value, T amount) {
+      if (amount > value.load(std::memory_order_relaxed))
+        value.store(amount, std::memory_order_relaxed);
+    }
+
+    int bucketIndex(long long nanoseconds) {
+      int index = 0;
+      for (long long bound = 1LL << FIRST_BUCKET_BITS; nanoseconds >= bound; bound <<= 1)
+        index++;
+      return std::min(index, NUM_PROFILE_BUCKETS - 1);
+    }
+
+    double microseconds(long long nanoseconds) {
+      return nanoseconds / 1000.0;
+    }
+
+    double averageMicroseconds(const ProfileSection& section) {
+      long long count = section.count();
+      return count ? microseconds(section.totalNanoseconds()) / count : 0.0;
+    }
+  } // namespace
+
+  ProfileSection::ProfileSection() {
+    reset();
+  }
+
+  void ProfileSection::record(long long nanoseconds) {
+    increment(count_, 1LL);
+    increment(total_, nanoseconds);
+    raise(max_, nanoseconds);
+    increment(buckets_[bucketIndex(nanoseconds)], 1LL);
+  }
+
+  void ProfileSection::reset() {
+    count_ = 0;
+    total_ = 0;
+    max_ = 0;
+    for (int i = 0; i < NUM_PROFILE_BUCKETS; ++i)
+      buckets_[i] = 0;
+  }
+
+  long long ProfileSection::percentileNanoseconds(double fraction) const {
+    long long target = fraction * count();
+    long long seen = 0;
+    for (int i = 0; i < NUM_PROFILE_BUCKETS - 1; ++i) {
+      seen += bucket(i);
+      if (seen > target)
+        return 1LL << (i + FIRST_BUCKET_BITS);
+    }
+    return maxNanoseconds();
+  }
+
+  Profiler::Profiler() : num_sections_(0), voice_bytes_(0), instance_bytes_(0) {
+    block_section_ = section(BLOCK_SECTION_NAME);
+    reset();
+  }
+
+  ProfileSection* Profiler::section(const std::string& name) {
+    int num_sections = numSections();
+    for (int i = 0; i < num_sections; ++i) {
+      if (sections_[i].name_ == name)
+        return &sections_[i];
+    }
+
+    if (num_sections >= MAX_PROFILE_SECTIONS)
+      return nullptr;
+
+    sections_[num_sections].name_ = name;
+    num_sections_.store(num_sections + 1, std::memory_order_release);
+    return &sections_[num_sections];
+  }
+
+  void Profiler::beginBlock() {
+    block_start_ = std::chrono::steady_clock::now();
+  }
+
+  void Profiler::endBlock(int num_samples, int sample_rate) {
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - block_start_;
+    block_section_->record(elapsed.count());
+
+    long long deadline = (1000000000LL * num_samples) / sample_rate;
+    increment(blocks_, 1LL);
+    if (elapsed.count() > deadline)
+      increment(misses_, 1LL);
+  }
+
+  void Profiler::setActiveVoices(int active_voices) {
+    active_voices_.store(active_voices, std::memory_order_relaxed);
+    raise(max_active_voices_, active_voices);
+  }
+
+  void Profiler::setVoiceBytes(size_t voice_bytes) {
+    voice_bytes_.store(voice_bytes, std::memory_order_relaxed);
+  }
+
+  void Profiler::setInstanceBytes(size_t instance_bytes) {
+    instance_bytes_.store(instance_bytes, std::memory_order_relaxed);
+  }
+
+  void Profiler::reset() {
+    for (int i = 0; i < numSections(); ++i)
+      sections_[i].reset();
+
+    blocks_ = 0;
+    misses_ = 0;
+    active_voices_ = 0;
+    max_active_voices_ = 0;
+  }
+
+  void Profiler::writeJson(std::ostream& stream) const {
+    stream << "{\n";
+    stream << "  \"blocks\": " << blocks() << ",\n";
+    stream << "  \"deadline_misses\": " << deadlineMisses() << ",\n";
+    stream << "  \"active_voices\": " << activeVoices() << ",\n";
+    stream << "  \"max_active_voices\": " << maxActiveVoices() << ",\n";
+    stream << "  \"voice_bytes\": " << voiceBytes() << ",\n";
+    stream << "  \"instance_bytes\": " << instanceBytes() << ",\n";
+    stream << "  \"sections\": [";
+
+    int num_sections = numSections();
+    for (int i = 0; i < num_sections; ++i) {
+      const ProfileSection& section = sections_[i];
+      stream << (i ? ",\n" : "\n");
+      stream << "    {\"name\": \"" << section.name() << "\"";
+      stream << ", \"count\": " << section.count();
+      stream << ", \"total_us\": " << microseconds(section.totalNanoseconds());
+      stream << ", \"mean_us\": " << averageMicroseconds(section);
+      stream << ", \"p99_us\": " << microseconds(section.percentileNanoseconds(0.99));
+      stream << ", \"max_us\": " << microseconds(section.maxNanoseconds());
+      stream << ", \"buckets\": [";
+      for (int b = 0; b < NUM_PROFILE_BUCKETS; ++b)
+        stream << (b ? ", " : "") << section.bucket(b);
+      stream << "]}";
+    }
+    stream << "\n  ]\n}\n";
+  }
+
+  void Profiler::writeCsv(std::ostream& stream) const {
+    stream << "section,count,total_us,mean_us,p99_us,max_us";
+    for (int b = 0; b < NUM_PROFILE_BUCKETS; ++b)
+      stream << ",bucket_" << b;
+    stream << "\n";
+
+    int num_sections = numSections();
+    for (int i = 0; i < num_sections; ++i) {
+      const ProfileSection& section = sections_[i];
+      stream << section.name() << "," << section.count() << ","
+             << microseconds(section.totalNanoseconds()) << ","
+             << averageMicroseconds(section) << ","
+             << microseconds(section.percentileNanoseconds(0.99)) << ","
+             << microseconds(section.maxNanoseconds());
+      for (int b = 0; b < NUM_PROFILE_BUCKETS; ++b)
+        stream << "," << section.bucket(b);
+      stream << "\n";
+    }
+  }
+} // namespace mopo
+
+#endif // MOPO_PROFILE
@@ -0,0 +1,189 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+#if MOPO_PROFILE
+#include <atomic>
+#include <chrono>
+#endif
+
+#define MAX_PROFILE_SECTIONS 16
+#define NUM_PROFILE_BUCKETS 20
+
+namespace mopo {
+
+  // Per instance timing of an engine. Built with MOPO_PROFILE, Processors
+  // tagged with a ProfileSection are timed every time their router runs
+  // them and the engine counts blocks that took longer than they last.
+  // Without it everything here compiles to nothing.
+  //
+  // The audio thread is the only writer. Counters are relaxed atomics so
+  // any thread can read them while it runs, a reader may see one block
+  // counted in one field and not yet in another.
+  //
+  // Bucket 0 of a histogram holds runs under 256ns, bucket i runs between
+  // 2^(i + 7) and 2^(i + 8) nanoseconds and the last one everything longer.
+  class ProfileSection {
+    public:
+#if MOPO_PROFILE
+      ProfileSection();
+
+      void record(long long nanoseconds);
+      void reset();
+
+      const std::string& name() const { return name_; }
+      long long count() const { return count_.load(std::memory_order_relaxed); }
+      long long totalNanoseconds() const { return total_.load(std::memory_order_relaxed); }
+      long long maxNanoseconds() const { return max_.load(std::memory_order_relaxed); }
+      long long bucket(int index) const {
+        return buckets_[index].load(std::memory_order_relaxed);
+      }
+
+      // Upper bound of the bucket below which _fraction_ of the runs fall.
+      long long percentileNanoseconds(double fraction) const;
+
+    private:
+      friend class Profiler;
+
+      std::string name_;
+      std::atomic<long long> count_;
+      std::atomic<long long> total_;
+      std::atomic<long long> max_;
+      std::atomic<long long> buckets_[NUM_PROFILE_BUCKETS];
+#else
+      void record(long long) { }
+      void reset() { }
+
+      const std::string& name() const { static const std::string none; return none; }
+      long long count() const { return 0; }
+      long long totalNanoseconds() const { return 0; }
+      long long maxNanoseconds() const { return 0; }
+      long long bucket(int) const { return 0; }
+      long long percentileNanoseconds(double) const { return 0; }
+#endif
+  };
+
+  // Times its section while alive. A null section is not timed.
+  class ProfileScope {
+    public:
+#if MOPO_PROFILE
+      ProfileScope(ProfileSection* section) : section_(section) {
+        if (section_)
+          start_ = std::chrono::steady_clock::now();
+      }
+
+      ~ProfileScope() {
+        if (section_) {
+          std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start_;
+          section_->record(elapsed.count());
+        }
+      }
+#else
+      ProfileScope(ProfileSection*) { }
+#endif
+
+      ProfileScope(const ProfileScope&) = delete;
+      ProfileScope& operator=(const ProfileScope&) = delete;
+
+#if MOPO_PROFILE
+    private:
+      ProfileSection* section_;
+      std::chrono::steady_clock::time_point start_;
+#endif
+  };
+
+  class Profiler {
+    public:
+#if MOPO_PROFILE
+      Profiler();
+
+      // Not realtime safe. Asking twice for a name returns the same section,
+      // nullptr once every section is taken.
+      ProfileSection* section(const std::string& name);
+
+      int numSections() const { return num_sections_.load(std::memory_order_acquire); }
+      const ProfileSection* getSection(int index) const { return &sections_[index]; }
+
+      // Call around a block of _num_samples_. The block is timed under
+      // "block" and counted as a miss when it took longer than it lasts.
+      void beginBlock();
+      void endBlock(int num_samples, int sample_rate);
+
+      void setActiveVoices(int active_voices);
+      void setVoiceBytes(size_t voice_bytes);
+      void setInstanceBytes(size_t instance_bytes);
+
+      long long blocks() const { return blocks_.load(std::memory_order_relaxed); }
+      long long deadlineMisses() const { return misses_.load(std::memory_order_relaxed); }
+      int activeVoices() const { return active_voices_.load(std::memory_order_relaxed); }
+      int maxActiveVoices() const { return max_active_voices_.load(std::memory_order_relaxed); }
+      size_t voiceBytes() const { return voice_bytes_.load(std::memory_order_relaxed); }
+      size_t instanceBytes() const { return instance_bytes_.load(std::memory_order_relaxed); }
+
+      // Clears every count, keeping the sections.
+      void reset();
+
+      void writeJson(std::ostream& stream) const;
+      void writeCsv(std::ostream& stream) const;
+
+    private:
+      ProfileSection sections_[MAX_PROFILE_SECTIONS];
+      std::atomic<int> num_sections_;
+      ProfileSection* block_section_;
+      std::chrono::steady_clock::time_point block_start_;
+
+      std::atomic<long long> blocks_;
+      std::atomic<long long> misses_;
+      std::atomic<int> active_voices_;
+      std::atomic<int> max_active_voices_;
+      std::atomic<size_t> voice_bytes_;
+      std::atomic<size_t> instance_bytes_;
+#else
+      ProfileSection* section(const std::string&) { return nullptr; }
+
+      int numSections() const { return 0; }
+      const ProfileSection* getSection(int) const { return nullptr; }
+
+      void beginBlock() { }
+      void endBlock(int, int) { }
+
+      void setActiveVoices(int) { }
+      void setVoiceBytes(size_t) { }
+      void setInstanceBytes(size_t) { }
+
+      long long blocks() const { return 0; }
+      long long deadlineMisses() const { return 0; }
+      int activeVoices() const { return 0; }
+      int maxActiveVoices() const { return 0; }
+      size_t voiceBytes() const { return 0; }
+      size_t instanceBytes() const { return 0; }
+
+      void reset() { }
+
+      void writeJson(std::ostream&) const { }
+      void writeCsv(std::ostream&) const { }
+#endif
+  };
+} // namespace mopo
+
+#endif // PROFILER_H
@@ -0,0 +1,104 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef RANDOM_GENERATOR_H
+#define RANDOM_GENERATOR_H
+
+#include "common.h"
+
+#include <cstdint>
+
+namespace mopo {
+
+  // Counter based random numbers. The nth value of a stream is a keyed hash
+  // of n, so values don't depend on each other: a block fills in one
+  // vectorizable loop and seeding is just setting the key. Every copy of a
+  // processor keeps its own stream, nothing is shared between threads.
+  class RandomGenerator {
+    public:
+      // Spreads _seed_ and _stream_ over 64 bits, for seeding many streams
+      // from one seed.
+      static uint64_t mix(uint64_t seed, uint64_t stream = 0) {
+        uint64_t value = seed + (stream + 1) * 0x9e3779b97f4a7c15ULL;
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+      }
+
+      RandomGenerator(uint64_t seed = 0) { setSeed(seed); }
+
+      void setSeed(uint64_t seed) {
+        uint64_t key = mix(seed);
+        key1_ = static_cast<uint32_t>(key);
+        key2_ = static_cast<uint32_t>(key >> 32);
+        counter_ = 0;
+      }
+
+      inline uint32_t next() {
+        return hash(counter_++);
+      }
+
+      // In [-1, 1).
+      inline mopo_float nextBipolar() {
+        return toBipolar(next());
+      }
+
+      // In [0, 1).
+      inline mopo_float nextUnipolar() {
+        return next() * (1.0 / 4294967296.0);
+      }
+
+      void fillBipolar(mopo_float* dest, int size) {
+        uint32_t counter = counter_;
+        VECTORIZE_LOOP
+        for (int i = 0; i < size; ++i)
+          dest[i] = toBipolar(hash(counter + i));
+        counter_ += size;
+      }
+
+      void fillBipolar(float* dest, int size) {
+        uint32_t counter = counter_;
+        VECTORIZE_LOOP
+        for (int i = 0; i < size; ++i)
+          dest[i] = static_cast<float>(toBipolar(hash(counter + i)));
+        counter_ += size;
+      }
+
+    private:
+      static inline uint32_t scramble(uint32_t value) {
+        value = (value ^ (value >> 16)) * 0x21f0aaadU;
+        value = (value ^ (value >> 15)) * 0x735a2d97U;
+        return value ^ (value >> 15);
+      }
+
+      // Two keyed rounds, so different keys give unrelated streams rather
+      // than one stream at different offsets.
+      inline uint32_t hash(uint32_t counter) const {
+        return scramble(scramble(counter * 0x9e3779b9U + key1_) ^ key2_);
+      }
+
+      static inline mopo_float toBipolar(uint32_t value) {
+        return static_cast<int32_t>(value) * (1.0 / 2147483648.0);
+      }
+
+      uint32_t key1_;
+      uint32_t key2_;
+      uint32_t counter_;
+  };
+} // namespace mopo
+
+#endif // RANDOM_GENERATOR_H
@@ -0,0 +1,350 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "realtime_audit.h"
+
+#if MOPO_REALTIME_AUDIT
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#include <unistd.h>
+#define AUDIT_BACKTRACE 1
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#if defined(__GLIBC__)
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#endif
+
+// Initial exec TLS never allocates, the default model can from malloc.
+#if defined(__GNUC__)
+#define AUDIT_THREAD_LOCAL __attribute__((tls_model("initial-exec"))) thread_local
+#else
+#define AUDIT_THREAD_LOCAL thread_local
+#endif
+
+#define MAX_RECORDS 32
+#define MAX_FRAMES 24
+
+namespace mopo {
+
+  namespace realtime_audit {
+
+    namespace {
+      struct Record {
+        Violation violation;
+        size_t size;
+        int num_frames;
+        void* frames[MAX_FRAMES];
+      };
+
+      AUDIT_THREAD_LOCAL int realtime_depth = 0;
+      AUDIT_THREAD_LOCAL bool in_hook = false;
+
+      std::atomic<bool> abort_enabled(false);
+      std::atomic<int> counts[kNumViolations];
+      std::atomic<int> num_records(0);
+      Record records[MAX_RECORDS];
+
+#if defined(__GLIBC__)
+      typedef int (*LockFunction)(pthread_mutex_t*);
+
+      // dlsym can allocate, install() resolves it before any audit.
+      LockFunction realLock() {
+        static std::atomic<LockFunction> real_lock(nullptr);
+        LockFunction lock = real_lock.load(std::memory_order_relaxed);
+        if (lock == nullptr) {
+          lock = reinterpret_cast<LockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+          real_lock.store(lock, std::memory_order_relaxed);
+        }
+        return lock;
+      }
+#endif
+
+      const char* violationName(Violation violation) {
+        switch (violation) {
+          case kAllocation:
+            return "allocation";
+          case kFree:
+            return "free";
+          case kLock:
+            return "mutex lock";
+          default:
+            return "unknown";
+        }
+      }
+
+      int captureStack(void** frames, int max_frames) {
+#if AUDIT_BACKTRACE
+        return backtrace(frames, max_frames);
+#elif defined(_WIN32)
+        return CaptureStackBackTrace(0, max_frames, frames, nullptr);
+#else
+        return 0;
+#endif
+      }
+
+      // Nothing here allocates, it can run from inside a hook.
+      void printRecord(const Record& record) {
+        fprintf(stderr, "Realtime audit: %s", violationName(record.violation));
+        if (record.size)
+          fprintf(stderr, " of %zu bytes", record.size);
+        fprintf(stderr, "\n");
+
+#if AUDIT_BACKTRACE
+        backtrace_symbols_fd(record.frames, record.num_frames, STDERR_FILENO);
+#else
+        for (int i = 0; i < record.num_frames; ++i)
+          fprintf(stderr, "  %p\n", record.frames[i]);
+#endif
+      }
+
+      void note(Violation violation, size_t size) {
+        if (realtime_depth == 0 || in_hook)
+          return;
+
+        // The stack walker and stderr may allocate or lock themselves.
+        in_hook = true;
+        counts[violation]++;
+
+        int index = num_records++;
+        bool aborting = abort_enabled;
+        if (index < MAX_RECORDS || aborting) {
+          Record aborted;
+          Record* record = index < MAX_RECORDS ? &records[index] : &aborted;
+          record->violation = violation;
+          record->size = size;
+          record->num_frames = captureStack(record->frames, MAX_FRAMES);
+
+          if (aborting) {
+            printRecord(*record);
+            std::abort();
+          }
+        }
+        in_hook = false;
+      }
+    } // namespace
+
+    void install() {
+      void* frames[MAX_FRAMES];
+      captureStack(frames, MAX_FRAMES);
+#if defined(__GLIBC__)
+      realLock();
+#endif
+    }
+
+    void setAbortOnViolation(bool abort_on_violation) {
+      abort_enabled = abort_on_violation;
+    }
+
+    void enter() {
+      realtime_depth++;
+    }
+
+    void leave() {
+      realtime_depth--;
+    }
+
+    int count(Violation violation) {
+      return counts[violation];
+    }
+
+    int total() {
+      int total = 0;
+      for (int i = 0; i < kNumViolations; ++i)
+        total += counts[i];
+      return total;
+    }
+
+    void reset() {
+      for (int i = 0; i < kNumViolations; ++i)
+        counts[i] = 0;
+      num_records = 0;
+    }
+
+    void report() {
+      fprintf(stderr, "Realtime audit: %d allocations, %d frees, %d mutex locks\n",
+              count(kAllocation), count(kFree), count(kLock));
+
+      int num = num_records;
+      if (num > MAX_RECORDS)
+        num = MAX_RECORDS;
+      for (int i = 0; i < num; ++i)
+        printRecord(records[i]);
+    }
+  } // namespace realtime_audit
+} // namespace mopo
+
+#if defined(__GLIBC__)
+
+// glibc exports its allocator under these names, so the usual ones can be
+// replaced and forward to them. operator new goes through malloc here.
+extern "C" {
+  void* __libc_malloc(size_t size);
+  void __libc_free(void* pointer);
+  void* __libc_calloc(size_t num, size_t size);
+  void* __libc_realloc(void* pointer, size_t size);
+  void* __libc_memalign(size_t alignment, size_t size);
+
+  void* malloc(size_t size) noexcept {
+    mopo::realtime_audit::note(mopo::realtime_audit::kAllocation, size);
+    return __libc_malloc(size);
+  }
+
+  void free(void* pointer) noexcept {
+    if (pointer)
+      mopo::realtime_audit::note(mopo::realtime_audit::kFree, 0);
+    __libc_free(pointer);
+  }
+
+  void* calloc(size_t num, size_t size) noexcept {
+    mopo::realtime_audit::note(mopo::realtime_audit::kAllocation, num * size);
+    return __libc_calloc(num, size);
+  }
+
+  void* realloc(void* pointer, size_t size) noexcept {
+    mopo::realtime_audit::note(mopo::realtime_audit::kAllocation, size);
+    return __libc_realloc(pointer, size);
+  }
+
+  void* memalign(size_t alignment, size_t size) noexcept {
+    mopo::realtime_audit::note(mopo::realtime_audit::kAllocation, size);
+    return __libc_memalign(alignment, size);
+  }
+
+  void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    return memalign(alignment, size);
+  }
+
+  int posix_memalign(void** result, size_t alignment, size_t size) noexcept {
+    if (alignment % sizeof(void*) || (alignment & (alignment - 1)))
+      return EINVAL;
+
+    void* pointer = memalign(alignment, size);
+    if (pointer == nullptr)
+      return ENOMEM;
+    *result = pointer;
+    return 0;
+  }
+
+  int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept {
+    mopo::realtime_audit::note(mopo::realtime_audit::kLock, 0);
+    return mopo::realtime_audit::realLock()(mutex);
+  }
+}
+
+#else
+
+namespace {
+  void* allocate(size_t size) noexcept {
+    mopo::realtime_audit::note(mopo::realtime_audit::kAllocation, size);
+    return std::malloc(size ? size : 1);
+  }
+
+  void* allocateAligned(size_t size, std::align_val_t alignment) noexcept {
+    mopo::realtime_audit::note(mopo::realtime_audit::kAllocation, size);
+    size_t align = static_cast<size_t>(alignment);
+#if defined(_WIN32)
+    return _aligned_malloc(size ? size : 1, align);
+#else
+    size_t rounded = (size + align - 1) / align * align;
+    return std::aligned_alloc(align, rounded ? rounded : align);
+#endif
+  }
+
+  void deallocate(void* pointer) noexcept {
+    if (pointer == nullptr)
+      return;
+    mopo::realtime_audit::note(mopo::realtime_audit::kFree, 0);
+    std::free(pointer);
+  }
+
+  void deallocateAligned(void* pointer) noexcept {
+    if (pointer == nullptr)
+      return;
+    mopo::realtime_audit::note(mopo::realtime_audit::kFree, 0);
+#if defined(_WIN32)
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+  }
+
+  void* allocateOrThrow(size_t size) {
+    if (void* pointer = allocate(size))
+      return pointer;
+    throw std::bad_alloc();
+  }
+
+  void* allocateAlignedOrThrow(size_t size, std::align_val_t alignment) {
+    if (void* pointer = allocateAligned(size, alignment))
+      return pointer;
+    throw std::bad_alloc();
+  }
+} // namespace
+
+void* operator new(size_t size) { return allocateOrThrow(size); }
+void* operator new[](size_t size) { return allocateOrThrow(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  return allocateAlignedOrThrow(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return allocateAlignedOrThrow(size, alignment);
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return allocateAligned(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return allocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, size_t) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { deallocate(pointer); }
+
+void operator delete(void* pointer, std::align_val_t) noexcept { deallocateAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { deallocateAligned(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+  deallocateAligned(pointer);
+}
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept {
+  deallocateAligned(pointer);
+}
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+  deallocateAligned(pointer);
+}
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+  deallocateAligned(pointer);
+}
+
+#endif // __GLIBC__
+
+#endif // MOPO_REALTIME_AUDIT
@@ -0,0 +1,80 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef REALTIME_AUDIT_H
+#define REALTIME_AUDIT_H
+
+namespace mopo {
+
+  // Finds heap and lock use on the audio thread. Built with
+  // MOPO_REALTIME_AUDIT, every allocation, free and mutex lock made while a
+  // RealtimeScope is alive on the calling thread is counted and its stack
+  // is kept for report(). Without it everything here compiles to nothing.
+  //
+  // On glibc malloc, free and pthread_mutex_lock are interposed, so C
+  // allocations and locks are seen too. Elsewhere only operator new and
+  // delete are. Interposing only works for executables, like the
+  // standalone app or a render harness, not for plugins a host loads.
+  namespace realtime_audit {
+    enum Violation {
+      kAllocation,
+      kFree,
+      kLock,
+      kNumViolations
+    };
+
+#if MOPO_REALTIME_AUDIT
+    // Call from a normal thread before auditing. The stack walker
+    // allocates the first time it runs.
+    void install();
+    void setAbortOnViolation(bool abort_on_violation);
+
+    void enter();
+    void leave();
+
+    int count(Violation violation);
+    int total();
+    void reset();
+
+    // Counts and stacks of the first violations, written to stderr.
+    void report();
+#else
+    inline void install() { }
+    inline void setAbortOnViolation(bool) { }
+
+    inline void enter() { }
+    inline void leave() { }
+
+    inline int count(Violation) { return 0; }
+    inline int total() { return 0; }
+    inline void reset() { }
+    inline void report() { }
+#endif
+  } // namespace realtime_audit
+
+  // Marks the calling thread as realtime while alive. Scopes nest.
+  class RealtimeScope {
+    public:
+      RealtimeScope() { realtime_audit::enter(); }
+      ~RealtimeScope() { realtime_audit::leave(); }
+
+      RealtimeScope(const RealtimeScope&) = delete;
+      RealtimeScope& operator=(const RealtimeScope&) = delete;
+  };
+} // namespace mopo
+
+#endif // REALTIME_AUDIT_H
@@ -48,7 +48,7 @@ namespace mopo {
 
     VariableAdd* left_comb_total = new VariableAdd(NUM_COMB);
     for (int i = 0; i < NUM_COMB; ++i) {
-      ReverbComb* comb = new ReverbComb(1 + mopo::MAX_SAMPLE_RATE * COMB_TUNINGS[i]);
+      ReverbComb* comb = new ReverbComb(COMB_TUNINGS[i]);
       Value* time = new cr::Value(COMB_TUNINGS[i]);
       addIdleProcessor(time);
       cr::TimeToSamples* samples = new cr::TimeToSamples();
@@ -66,7 +66,7 @@ namespace mopo {
     VariableAdd* right_comb_total = new VariableAdd(NUM_COMB);
     for (int i = 0; i < NUM_COMB; ++i) {
       mopo_float tuning = COMB_TUNINGS[i] + STEREO_SPREAD;
-      ReverbComb* comb = new ReverbComb(1 + mopo::MAX_SAMPLE_RATE * tuning);
+      ReverbComb* comb = new ReverbComb(tuning);
       Value* time = new cr::Value(tuning);
       addIdleProcessor(time);
       cr::TimeToSamples* samples = new cr::TimeToSamples();
@@ -86,7 +86,7 @@ namespace mopo {
 
     reverb_wet_left_ = left_comb_total;
     for (int i = 0; i < NUM_ALL_PASS; ++i) {
-      ReverbAllPass* all_pass = new ReverbAllPass(1 + mopo::MAX_SAMPLE_RATE * ALL_PASS_TUNINGS[i]);
+      ReverbAllPass* all_pass = new ReverbAllPass(ALL_PASS_TUNINGS[i]);
       Value* time = new cr::Value(ALL_PASS_TUNINGS[i]);
       addIdleProcessor(time);
       cr::TimeToSamples* samples = new cr::TimeToSamples();
@@ -104,7 +104,7 @@ namespace mopo {
     reverb_wet_right_ = right_comb_total;
     for (int i = 0; i < NUM_ALL_PASS; ++i) {
       mopo_float tuning = ALL_PASS_TUNINGS[i] + STEREO_SPREAD;
-      ReverbAllPass* all_pass = new ReverbAllPass(1 + mopo::MAX_SAMPLE_RATE * tuning);
+      ReverbAllPass* all_pass = new ReverbAllPass(tuning);
       Value* time = new cr::Value(tuning);
       addIdleProcessor(time);
       cr::TimeToSamples* samples = new cr::TimeToSamples();
@@ -18,18 +18,25 @@
 
 namespace mopo {
 
-  ReverbAllPass::ReverbAllPass(int size) : Processor(ReverbAllPass::kNumInputs, 1) {
-    memory_ = new Memory(size);
+  ReverbAllPass::ReverbAllPass(mopo_float max_seconds) :
+      Processor(ReverbAllPass::kNumInputs, 1), max_seconds_(max_seconds) {
+    memory_ = new Memory(1 + max_seconds_ * sample_rate_);
   }
 
   ReverbAllPass::ReverbAllPass(const ReverbAllPass& other) : Processor(other) {
     this->memory_ = new Memory(*other.memory_);
+    this->max_seconds_ = other.max_seconds_;
   }
 
   ReverbAllPass::~ReverbAllPass() {
     delete memory_;
   }
 
+  void ReverbAllPass::setSampleRate(int sample_rate) {
+    Processor::setSampleRate(sample_rate);
+    memory_->resize(1 + max_seconds_ * sample_rate_);
+  }
+
   void ReverbAllPass::process() {
     MOPO_ASSERT(inputMatchesBufferSize(kAudio));
     MOPO_ASSERT(inputMatchesBufferSize(kFeedback));
@@ -40,7 +47,43 @@ namespace mopo {
     const mopo_float* feedback_buffer = input(kFeedback)->source->buffer;
     int period = input(kSampleDelay)->at(0);
 
-    for (int i = 0; i < buffer_size_; ++i)
-      tick(i, dest, period, audio_buffer, feedback_buffer);
+    if (period < 1) {
+      for (int i = 0; i < buffer_size_; ++i)
+        tick(i, dest, period, audio_buffer, feedback_buffer);
+      return;
+    }
+
+    int block = utils::imin(period, buffer_size_);
+    for (int i = 0; i < buffer_size_; i += block) {
+      int num = utils::imin(block, buffer_size_ - i);
+      tickBlock(i, num, dest, period, audio_buffer, feedback_buffer);
+    }
+  }
+
+  void ReverbAllPass::tickBlock(int start, int num, mopo_float* dest, int period,
+                                const mopo_float* audio_buffer,
+                                const mopo_float* feedback_buffer) {
+    Memory::Spans spans = memory_->getSpans(period, num);
+    const mopo_float* reads[] = { spans.first, spans.second };
+    int sizes[] = { spans.first_size, spans.second_size };
+
+    mopo_float write[MAX_BUFFER_SIZE];
+    int i = start;
+    for (int r = 0; r < 2; ++r) {
+      const mopo_float* read = reads[r];
+      const mopo_float* audio = audio_buffer + i;
+      const mopo_float* feedback = feedback_buffer + i;
+      mopo_float* run_write = write + i - start;
+      mopo_float* run_dest = dest + i;
+
+      VECTORIZE_LOOP
+      for (int s = 0; s < sizes[r]; ++s) {
+        run_write[s] = audio[s] + read[s] * feedback[s];
+        run_dest[s] = read[s] - audio[s];
+      }
+      i += sizes[r];
+    }
+
+    memory_->pushBlock(write, num);
   }
 } // namespace mopo
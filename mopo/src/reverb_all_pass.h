@@ -33,7 +33,8 @@ namespace mopo {
         kNumInputs
       };
 
-      ReverbAllPass(int size);
+      // Holds delays of up to _max_seconds_ at the current sample rate.
+      ReverbAllPass(mopo_float max_seconds);
       ReverbAllPass(const ReverbAllPass& other);
       virtual ~ReverbAllPass();
 
@@ -41,6 +42,12 @@ namespace mopo {
         return new ReverbAllPass(*this);
       }
 
+      virtual size_t allocatedBytes() const override {
+        return memory_->getSize() * sizeof(mopo_float);
+      }
+
+      virtual void setSampleRate(int sample_rate) override;
+
       virtual void process() override;
 
       void tick(int i, mopo_float* dest, int period,
@@ -53,8 +60,14 @@ namespace mopo {
         dest[i] = read - audio;
       }
 
+      // Reads all _num_ samples before pushing any, so _num_ can't be
+      // larger than _period_.
+      void tickBlock(int start, int num, mopo_float* dest, int period,
+                     const mopo_float* audio_buffer, const mopo_float* feedback_buffer);
+
     protected:
       Memory* memory_;
+      mopo_float max_seconds_;
   };
 } // namespace mopo
 
@@ -18,13 +18,15 @@
 
 namespace mopo {
 
-  ReverbComb::ReverbComb(int size) : Processor(ReverbComb::kNumInputs, 1) {
-    memory_ = new Memory(size);
+  ReverbComb::ReverbComb(mopo_float max_seconds) :
+      Processor(ReverbComb::kNumInputs, 1), max_seconds_(max_seconds) {
+    memory_ = new Memory(1 + max_seconds_ * sample_rate_);
     filtered_sample_ = 0.0;
   }
 
   ReverbComb::ReverbComb(const ReverbComb& other) : Processor(other) {
     this->memory_ = new Memory(*other.memory_);
+    this->max_seconds_ = other.max_seconds_;
     this->filtered_sample_ = 0.0;
   }
 
@@ -32,6 +34,11 @@ namespace mopo {
     delete memory_;
   }
 
+  void ReverbComb::setSampleRate(int sample_rate) {
+    Processor::setSampleRate(sample_rate);
+    memory_->resize(1 + max_seconds_ * sample_rate_);
+  }
+
   void ReverbComb::process() {
     MOPO_ASSERT(inputMatchesBufferSize(kAudio));
     MOPO_ASSERT(inputMatchesBufferSize(kFeedback));
@@ -43,7 +50,40 @@ namespace mopo {
     const mopo_float* feedback_buffer = input(kFeedback)->source->buffer;
     const mopo_float* damping_buffer = input(kDamping)->source->buffer;
 
-    for (int i = 0; i < buffer_size_; ++i)
-      tick(i, dest, period, audio_buffer, feedback_buffer, damping_buffer);
+    if (period < 1) {
+      for (int i = 0; i < buffer_size_; ++i)
+        tick(i, dest, period, audio_buffer, feedback_buffer, damping_buffer);
+      return;
+    }
+
+    int block = utils::imin(period, buffer_size_);
+    for (int i = 0; i < buffer_size_; i += block) {
+      int num = utils::imin(block, buffer_size_ - i);
+      tickBlock(i, num, dest, period, audio_buffer, feedback_buffer, damping_buffer);
+    }
+  }
+
+  void ReverbComb::tickBlock(int start, int num, mopo_float* dest, int period,
+                             const mopo_float* audio_buffer,
+                             const mopo_float* feedback_buffer,
+                             const mopo_float* damping_buffer) {
+    Memory::Spans spans = memory_->getSpans(period, num);
+    const mopo_float* reads[] = { spans.first, spans.second };
+    int sizes[] = { spans.first_size, spans.second_size };
+
+    mopo_float write[MAX_BUFFER_SIZE];
+    mopo_float filtered_sample = filtered_sample_;
+    int i = start;
+    for (int r = 0; r < 2; ++r) {
+      const mopo_float* read = reads[r];
+      for (int s = 0; s < sizes[r]; ++s, ++i) {
+        filtered_sample = utils::interpolate(read[s], filtered_sample, damping_buffer[i]);
+        write[i - start] = audio_buffer[i] + filtered_sample * feedback_buffer[i];
+        dest[i] = read[s];
+      }
+    }
+
+    filtered_sample_ = filtered_sample;
+    memory_->pushBlock(write, num);
   }
 } // namespace mopo
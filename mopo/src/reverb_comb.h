@@ -34,7 +34,8 @@ namespace mopo {
         kNumInputs
       };
 
-      ReverbComb(int size);
+      // Holds delays of up to _max_seconds_ at the current sample rate.
+      ReverbComb(mopo_float max_seconds);
       ReverbComb(const ReverbComb& other);
       virtual ~ReverbComb();
 
@@ -42,6 +43,12 @@ namespace mopo {
         return new ReverbComb(*this);
       }
 
+      virtual size_t allocatedBytes() const override {
+        return memory_->getSize() * sizeof(mopo_float);
+      }
+
+      virtual void setSampleRate(int sample_rate) override;
+
       virtual void process() override;
 
       void tick(int i, mopo_float* dest, int period,
@@ -60,8 +67,16 @@ namespace mopo {
         dest[i] = read;
       }
 
+      // Reads all _num_ samples before pushing any, so _num_ can't be
+      // larger than _period_.
+      void tickBlock(int start, int num, mopo_float* dest, int period,
+                     const mopo_float* audio_buffer,
+                     const mopo_float* feedback_buffer,
+                     const mopo_float* damping_buffer);
+
     protected:
       Memory* memory_;
+      mopo_float max_seconds_;
       mopo_float filtered_sample_;
   };
 } // namespace mopo
@@ -52,14 +52,36 @@ namespace mopo {
     if (input(kReset)->source->triggered) {
       int trigger_offset = input(kReset)->source->trigger_offset;
 
-      for (; i < trigger_offset; ++i)
-        tick(i, dest, audio, period, feedback);
+      tickBlock(0, trigger_offset, dest, audio, period, feedback);
+      i = trigger_offset;
 
       int clear_samples = std::min(MAX_CLEAR_SAMPLES, ((int)period[i]) + 1);
       memory_->pushZero(clear_samples);
     }
 
-    for (int i = 0; i < buffer_size_; ++i)
-      tick(i, dest, audio, period, feedback);
+    tickBlock(i, buffer_size_, dest, audio, period, feedback);
+  }
+
+  void SimpleDelay::tickBlock(int start, int end, mopo_float* dest,
+                              const mopo_float* audio,
+                              const mopo_float* period,
+                              const mopo_float* feedback) {
+    mopo_float read[MAX_BUFFER_SIZE];
+    int i = start;
+    while (i < end) {
+      int num = memory_->readBlock(read, period + i, end - i);
+      if (num == 0) {
+        tick(i, dest, audio, period, feedback);
+        i++;
+        continue;
+      }
+
+      for (int s = 0; s < num; ++s) {
+        dest[i + s] = audio[i + s] + read[s] * feedback[i + s];
+        MOPO_ASSERT(std::isfinite(dest[i + s]));
+      }
+      memory_->pushBlock(dest + i, num);
+      i += num;
+    }
   }
 } // namespace mopo
@@ -43,6 +43,10 @@ namespace mopo {
         return new SimpleDelay(*this);
       }
 
+      virtual size_t allocatedBytes() const override {
+        return memory_->getSize() * sizeof(mopo_float);
+      }
+
       virtual void process() override;
 
       inline void tick(int i, mopo_float* dest,
@@ -56,6 +60,13 @@ namespace mopo {
         MOPO_ASSERT(std::isfinite(value));
       }
 
+      // Runs blocks as long as the delays allow, reading each one before it
+      // is pushed. Falls back to tick() for delays under a sample.
+      void tickBlock(int start, int end, mopo_float* dest,
+                     const mopo_float* audio,
+                     const mopo_float* period,
+                     const mopo_float* feedback);
+
     protected:
       Memory* memory_;
   };
@@ -50,7 +50,10 @@ namespace mopo {
         decay = std::pow(0.5, samples_to_process_ / (half_life * sample_rate_));
 
       mopo_float target = input(kTarget)->at(0);
-      last_value_ = utils::interpolate(target, last_value_, decay);
+      if (input(kReset)->source->triggered)
+        last_value_ = target;
+      else
+        last_value_ = utils::interpolate(target, last_value_, decay);
       output(0)->buffer[0] = last_value_;
     }
   }
@@ -43,11 +43,13 @@ namespace mopo {
   };
 
   namespace cr {
+    // Jumps straight to the target when _kReset_ triggers, e.g. on a new note.
     class SmoothFilter : public Processor {
       public:
         enum Inputs {
           kTarget,
           kHalfLife,
+          kReset,
           kNumInputs
         };
 
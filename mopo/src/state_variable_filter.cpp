@@ -15,6 +15,7 @@
  */
 
 #include "state_variable_filter.h"
+#include "frequency_response.h"
 #include "utils.h"
 
 #include <cmath>
@@ -153,79 +154,120 @@ namespace mopo {
     utils::copyBuffer(dest, audio_buffer, buffer_size_);
   }
 
-  void StateVariableFilter::computePassCoefficients(mopo_float blend,
-                                                    mopo_float cutoff,
-                                                    mopo_float resonance,
-                                                    bool db24) {
+  StateVariableFilter::Coefficients StateVariableFilter::computePassCoefficients(
+      mopo_float blend, mopo_float cutoff, mopo_float resonance, bool db24, int sample_rate) {
     MOPO_ASSERT(resonance > 0.0);
     MOPO_ASSERT(cutoff > 0.0);
 
     if (db24)
       resonance = sqrt(resonance);
 
-    mopo_float g = tan(PI * utils::min(cutoff / sample_rate_, 0.5));
-    mopo_float k = 1.0 / resonance;
+    Coefficients c;
+    c.g = tan(PI * utils::min(cutoff / sample_rate, 0.5));
+    c.k = 1.0 / resonance;
 
     mopo_float low_pass_amount = sqrt(utils::clamp(1.0 - blend, 0.0, 1.0));
     mopo_float band_pass_amount = sqrt(utils::clamp(1.0 - fabs(blend - 1.0), 0.0, 1.0));
     mopo_float high_pass_amount = sqrt(utils::clamp(blend - 1.0, 0.0, 1.0));
 
-    target_m0_ = 0.0;
-    target_m1_ = band_pass_amount;
-    target_m2_ = low_pass_amount;
-
-    target_m0_ += high_pass_amount;
-    target_m1_ += -k * high_pass_amount;
-    target_m2_ += -high_pass_amount;
-    
-    a1_ = 1.0 / (1.0 + g * (g + k));
-    a2_ = g * a1_;
-    a3_ = g * a2_;
+    c.m0 = 0.0;
+    c.m1 = band_pass_amount;
+    c.m2 = low_pass_amount;
+
+    c.m0 += high_pass_amount;
+    c.m1 += -c.k * high_pass_amount;
+    c.m2 += -high_pass_amount;
+    return c;
   }
 
-  void StateVariableFilter::computeShelfCoefficients(Shelves choice,
-                                                     mopo_float cutoff,
-                                                     mopo_float gain) {
+  StateVariableFilter::Coefficients StateVariableFilter::computeShelfCoefficients(
+      Shelves choice, mopo_float cutoff, mopo_float gain, int sample_rate) {
     MOPO_ASSERT(gain >= 0.0);
     MOPO_ASSERT(cutoff > 0.0);
 
     gain = sqrt(gain);
 
-    mopo_float g = tan(PI * utils::min(cutoff / sample_rate_, 0.5));
-    mopo_float k = 1.0;
+    Coefficients c;
+    c.g = tan(PI * utils::min(cutoff / sample_rate, 0.5));
+    c.k = 1.0;
 
     switch(choice) {
       case kLowShelf: {
-        g /= sqrt(gain);
-        target_m0_ = 1.0;
-        target_m1_ = k * (gain - 1.0);
-        target_m2_ = gain * gain - 1.0;
+        c.g /= sqrt(gain);
+        c.m0 = 1.0;
+        c.m1 = c.k * (gain - 1.0);
+        c.m2 = gain * gain - 1.0;
         break;
       }
       case kBandShelf: {
-        k /= gain;
-        target_m0_ = 1.0;
-        target_m1_ = k * (gain * gain - 1.0);
-        target_m2_ = 0.0;
+        c.k /= gain;
+        c.m0 = 1.0;
+        c.m1 = c.k * (gain * gain - 1.0);
+        c.m2 = 0.0;
         break;
       }
       case kHighShelf: {
-        g *= sqrt(gain);
-        target_m0_ = gain * gain;
-        target_m1_ = k * gain * (1.0 - gain);
-        target_m2_ = 1.0 - gain * gain;
+        c.g *= sqrt(gain);
+        c.m0 = gain * gain;
+        c.m1 = c.k * gain * (1.0 - gain);
+        c.m2 = 1.0 - gain * gain;
         break;
       }
       default: {
-        target_m0_ = 0.0;
-        target_m1_ = 0.0;
-        target_m2_ = 0.0;
+        c.m0 = 0.0;
+        c.m1 = 0.0;
+        c.m2 = 0.0;
       }
     }
+    return c;
+  }
+
+  void StateVariableFilter::getResponse(Styles style, mopo_float blend, Shelves shelf,
+                                        mopo_float cutoff, mopo_float resonance,
+                                        mopo_float gain, mopo_float drive,
+                                        FrequencyResponse* response) {
+    int sample_rate = response->grid()->sampleRate();
+    cutoff = utils::clamp(cutoff, MIN_CUTTOFF, sample_rate);
+    resonance = utils::clamp(resonance, MIN_RESONANCE, MAX_RESONANCE);
+
+    Coefficients c;
+    if (style == kShelf)
+      c = computeShelfCoefficients(shelf, cutoff, gain, sample_rate);
+    else
+      c = computePassCoefficients(blend, cutoff, resonance, style == k24dB, sample_rate);
+
+    // The trapezoidal integrators make each section the bilinear transform
+    // of m0 + (m1 g s + m2 g^2) / (s^2 + k g s + g^2), s = (1 - z^-1) / (1 + z^-1).
+    mopo_float g2 = c.g * c.g;
+    mopo_float den_0 = 1.0 + c.k * c.g + g2;
+    mopo_float den_1 = 2.0 * g2 - 2.0;
+    mopo_float den_2 = 1.0 - c.k * c.g + g2;
+
+    BiquadFilter::Coefficients section;
+    section.in_0 = (c.m0 * den_0 + c.m1 * c.g + c.m2 * g2) / den_0;
+    section.in_1 = (c.m0 * den_1 + 2.0 * c.m2 * g2) / den_0;
+    section.in_2 = (c.m0 * den_2 - c.m1 * c.g + c.m2 * g2) / den_0;
+    section.out_1 = den_1 / den_0;
+    section.out_2 = den_2 / den_0;
+
+    // Both paths saturate once, before the section or between the two.
+    response->multiplyBiquad(section);
+    if (style == k24dB)
+      response->multiplyBiquad(section);
+    response->scale(QUICK_TANH_SLOPE * drive);
+  }
 
-    a1_ = 1.0 / (1.0 + g * (g + k));
-    a2_ = g * a1_;
-    a3_ = g * a2_;
+  void StateVariableFilter::computePassCoefficients(mopo_float blend,
+                                                    mopo_float cutoff,
+                                                    mopo_float resonance,
+                                                    bool db24) {
+    setCoefficients(computePassCoefficients(blend, cutoff, resonance, db24, sample_rate_));
+  }
+
+  void StateVariableFilter::computeShelfCoefficients(Shelves choice,
+                                                     mopo_float cutoff,
+                                                     mopo_float gain) {
+    setCoefficients(computeShelfCoefficients(choice, cutoff, gain, sample_rate_));
 
     if (last_shelf_ != choice) {
       reset();
@@ -233,6 +275,16 @@ namespace mopo {
     }
   }
 
+  void StateVariableFilter::setCoefficients(const Coefficients& coefficients) {
+    target_m0_ = coefficients.m0;
+    target_m1_ = coefficients.m1;
+    target_m2_ = coefficients.m2;
+
+    a1_ = 1.0 / (1.0 + coefficients.g * (coefficients.g + coefficients.k));
+    a2_ = coefficients.g * a1_;
+    a3_ = coefficients.g * a2_;
+  }
+
   inline void StateVariableFilter::tick(int i, mopo_float* dest, const mopo_float* audio_buffer) {
     mopo_float audio = utils::quickTanh(drive_ * audio_buffer[i]);
 
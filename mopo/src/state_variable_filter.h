@@ -25,6 +25,8 @@
 
 namespace mopo {
 
+  class FrequencyResponse;
+
   class StateVariableFilter : public Processor {
     public:
       enum Inputs {
@@ -55,6 +57,32 @@ namespace mopo {
         kNumShelves
       };
 
+      // Integrator gain _g_, damping _k_ and the input, band and low pass
+      // mix amounts of one section.
+      struct Coefficients {
+        mopo_float g, k;
+        mopo_float m0, m1, m2;
+      };
+
+      static Coefficients computePassCoefficients(mopo_float blend,
+                                                  mopo_float cutoff,
+                                                  mopo_float resonance,
+                                                  bool db24,
+                                                  int sample_rate);
+
+      static Coefficients computeShelfCoefficients(Shelves choice,
+                                                   mopo_float cutoff,
+                                                   mopo_float gain,
+                                                   int sample_rate);
+
+      // Multiplies _response_ by the filter with these settings, clamped the
+      // way process() clamps its inputs. Drive is taken as the small signal
+      // gain of the saturation, so loud input will sound duller than this.
+      static void getResponse(Styles style, mopo_float blend, Shelves shelf,
+                              mopo_float cutoff, mopo_float resonance,
+                              mopo_float gain, mopo_float drive,
+                              FrequencyResponse* response);
+
       StateVariableFilter();
       virtual ~StateVariableFilter() { }
 
@@ -77,6 +105,7 @@ namespace mopo {
       inline void tick24db(int i, mopo_float* dest, const mopo_float* audio_buffer);
 
     private:
+      void setCoefficients(const Coefficients& coefficients);
       void reset();
 
       mopo_float a1_, a2_, a3_;
@@ -30,9 +30,10 @@ namespace mopo {
     }
   } // namespace
 
-  Stutter::Stutter(int size) : Processor(Stutter::kNumInputs, 1),
-      memory_(nullptr), size_(size), offset_(0.0), memory_offset_(0.0), resample_countdown_(0.0),
+  Stutter::Stutter(mopo_float max_seconds) : Processor(Stutter::kNumInputs, 1),
+      max_seconds_(max_seconds), offset_(0.0), memory_offset_(0.0), resample_countdown_(0.0),
       last_stutter_period_(0.0), last_amplitude_(0.0), resampling_(true) {
+    memory_ = nullptr;
   }
 
   Stutter::~Stutter() {
@@ -40,8 +41,8 @@ namespace mopo {
   }
 
   Stutter::Stutter(const Stutter& other) : Processor(other) {
-    this->memory_ = nullptr;
-    this->size_ = other.size_;
+    this->memory_ = other.memory_ ? new Memory(*other.memory_) : nullptr;
+    this->max_seconds_ = other.max_seconds_;
     this->offset_ = other.offset_;
     this->memory_offset_ = 0.0;
     this->resample_countdown_ = other.resample_countdown_;
@@ -50,12 +51,28 @@ namespace mopo {
     this->resampling_ = other.resampling_;
   }
 
+  void Stutter::setSampleRate(int sample_rate) {
+    Processor::setSampleRate(sample_rate);
+    if (memory_)
+      memory_->resize(getMemorySize());
+  }
+
+  Memory* Stutter::swapMemory(Memory* memory) {
+    Memory* old_memory = memory_;
+    memory_ = memory;
+    last_stutter_period_ = 0.0;
+    last_amplitude_ = 0.0;
+    startResampling(0.0);
+    return old_memory;
+  }
+
   void Stutter::process() {
     MOPO_ASSERT(inputMatchesBufferSize(kAudio));
 
-    // A hack to save memory until stutter is used.
-    if (memory_ == nullptr)
-      memory_ = new Memory(size_);
+    if (memory_ == nullptr) {
+      utils::copyBuffer(output()->buffer, input(kAudio)->source->buffer, buffer_size_);
+      return;
+    }
 
     mopo_float max_memory_write = memory_->getSize();
     const mopo_float* audio = input(kAudio)->source->buffer;
@@ -124,10 +141,20 @@ namespace mopo {
         }
       }
       else {
+        // Playback walks forward through memory at a fixed fraction. Reads
+        // under a sample behind the newest one fall back to get().
+        mopo_float past = memory_offset_ - offset_;
+        int block = utils::imin(num_samples, utils::imax(past, 0));
+        mopo_float read[MAX_BUFFER_SIZE];
+        if (block > 0)
+          memory_->readBlock(read, past, block);
+        for (int s = block; s < num_samples; ++s)
+          read[s] = memory_->get(past - s);
+
         mopo_float* playback_dest = dest + i;
         for (int s = 0; s < num_samples; ++s) {
           amplitude += amplitude_diff;
-          playback_dest[s] = amplitude * memory_->get(memory_offset_ - offset_ - s);
+          playback_dest[s] = amplitude * read[s];
         }
       }
 
@@ -37,13 +37,31 @@ namespace mopo {
         kNumInputs
       };
 
-      Stutter(int size);
+      // Keeps up to _max_seconds_ of audio at the current sample rate, once
+      // it's handed memory. Until then audio passes through untouched.
+      Stutter(mopo_float max_seconds);
       Stutter(const Stutter& other);
       virtual ~Stutter();
 
       virtual Processor* clone() const override { return new Stutter(*this); }
+
+      virtual size_t allocatedBytes() const override {
+        return memory_ ? memory_->getSize() * sizeof(mopo_float) : 0;
+      }
+
+      virtual void setSampleRate(int sample_rate) override;
+
       virtual void process() override;
 
+      // Samples of memory needed at the current sample rate.
+      int getMemorySize() const { return 1 + max_seconds_ * sample_rate_; }
+      bool hasMemory() const { return memory_ != nullptr; }
+
+      // Takes _memory_, which can be null, and returns the memory it held.
+      // Doesn't allocate or free, so make and delete memory off the audio
+      // thread and only swap it while processing is held off.
+      Memory* swapMemory(Memory* memory);
+
     protected:
       void startResampling(mopo_float sample_period) {
         resampling_ = true;
@@ -53,7 +71,7 @@ namespace mopo {
       }
 
       Memory* memory_;
-      int size_;
+      mopo_float max_seconds_;
       mopo_float offset_;
       mopo_float memory_offset_;
       mopo_float resample_countdown_;
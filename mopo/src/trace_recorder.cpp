@@ -0,0 +1,258 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "trace_recorder.h"
+
+#if MOPO_PROFILE
+
+#include "processor.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#define TRACE_THREAD_LOCAL __attribute__((tls_model("initial-exec"))) thread_local
+#else
+#define TRACE_THREAD_LOCAL thread_local
+#endif
+
+#define READ_EVENTS 4096
+#define IDLE_MILLISECONDS 1
+#define PROCESS_ID 1
+
+namespace mopo {
+
+  namespace {
+    TRACE_THREAD_LOCAL TraceRecorder* current_recorder = nullptr;
+    TRACE_THREAD_LOCAL const void* current_voice = nullptr;
+
+    std::string typeName(const std::type_info* type) {
+#if defined(__GNUC__)
+      int status = 0;
+      char* demangled = abi::__cxa_demangle(type->name(), nullptr, nullptr, &status);
+      if (status == 0 && demangled) {
+        std::string name = demangled;
+        std::free(demangled);
+        return name;
+      }
+#endif
+      return type->name();
+    }
+
+    std::string eventName(const TraceEvent& event) {
+      if (event.section)
+        return event.section->name();
+      if (event.type)
+        return typeName(event.type);
+      return event.label;
+    }
+  } // namespace
+
+  TraceRecorder::TraceRecorder() :
+      mask_(0), write_(0), read_(0), recording_(false), dropped_(0),
+      depth_(0), block_open_(false), block_(0) { }
+
+  void TraceRecorder::start(int num_events) {
+    if (events_.empty()) {
+      unsigned int size = 1;
+      while (size < static_cast<unsigned int>(num_events))
+        size <<= 1;
+      events_.resize(size);
+      mask_ = size - 1;
+    }
+
+    read_.store(write_.load(std::memory_order_acquire), std::memory_order_release);
+    dropped_ = 0;
+    block_ = 0;
+    start_time_ = std::chrono::steady_clock::now();
+    recording_.store(true, std::memory_order_release);
+  }
+
+  void TraceRecorder::stop() {
+    recording_.store(false, std::memory_order_release);
+  }
+
+  void TraceRecorder::beginBlock() {
+    if (!recording())
+      return;
+
+    current_recorder = this;
+    block_start_ = std::chrono::steady_clock::now();
+    block_open_ = begin("block");
+  }
+
+  void TraceRecorder::endBlock(int num_samples, int sample_rate) {
+    if (current_recorder != this)
+      return;
+
+    if (block_open_) {
+      end();
+
+      std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+      std::chrono::nanoseconds elapsed = now - block_start_;
+      if (elapsed.count() * sample_rate > 1000000000LL * num_samples) {
+        std::chrono::nanoseconds time = now - start_time_;
+        push({ "deadline miss", nullptr, nullptr, nullptr, block_, time.count(),
+               TraceEvent::kDeadlineMiss });
+      }
+    }
+
+    block_++;
+    current_recorder = nullptr;
+  }
+
+  TraceRecorder* TraceRecorder::current() {
+    return current_recorder;
+  }
+
+  const void* TraceRecorder::currentVoice() {
+    return current_voice;
+  }
+
+  void TraceRecorder::setCurrentVoice(const void* voice) {
+    current_voice = voice;
+  }
+
+  bool TraceRecorder::begin(const char* label, const Processor* processor) {
+    // Keeps room for the end of every open node and a deadline miss.
+    unsigned int used = write_.load(std::memory_order_relaxed) -
+                        read_.load(std::memory_order_acquire);
+    if (depth_ >= MAX_TRACE_DEPTH || used + MAX_TRACE_DEPTH + 2 > events_.size()) {
+      dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    TraceEvent event;
+    event.label = label;
+    event.type = processor ? &typeid(*processor) : nullptr;
+    event.section = processor ? processor->profileSection() : nullptr;
+    event.voice = current_voice;
+    event.block = block_;
+    event.phase = TraceEvent::kBegin;
+    event.nanoseconds = (std::chrono::steady_clock::now() - start_time_).count();
+    depth_++;
+    push(event);
+    return true;
+  }
+
+  void TraceRecorder::end() {
+    std::chrono::nanoseconds time = std::chrono::steady_clock::now() - start_time_;
+    depth_--;
+    push({ nullptr, nullptr, nullptr, current_voice, block_, time.count(), TraceEvent::kEnd });
+  }
+
+  void TraceRecorder::push(const TraceEvent& event) {
+    unsigned int write = write_.load(std::memory_order_relaxed);
+    events_[write & mask_] = event;
+    write_.store(write + 1, std::memory_order_release);
+  }
+
+  int TraceRecorder::read(TraceEvent* events, int max_events) {
+    unsigned int read = read_.load(std::memory_order_relaxed);
+    unsigned int available = write_.load(std::memory_order_acquire) - read;
+    int num = std::min<unsigned int>(available, max_events);
+    for (int i = 0; i < num; ++i)
+      events[i] = events_[(read + i) & mask_];
+
+    read_.store(read + num, std::memory_order_release);
+    return num;
+  }
+
+  TraceWriter::TraceWriter() : recorder_(nullptr), stopping_(false) { }
+
+  TraceWriter::~TraceWriter() {
+    stop();
+  }
+
+  bool TraceWriter::start(TraceRecorder* recorder, const std::string& path) {
+    stop();
+
+    std::ofstream test(path);
+    if (!test)
+      return false;
+    test.close();
+
+    recorder_ = recorder;
+    recorder_->start();
+    stopping_ = false;
+    thread_ = std::thread(&TraceWriter::run, this, path);
+    return true;
+  }
+
+  void TraceWriter::stop() {
+    if (!thread_.joinable())
+      return;
+
+    recorder_->stop();
+    stopping_ = true;
+    thread_.join();
+  }
+
+  void TraceWriter::run(const std::string& path) {
+    std::ofstream file(path);
+    file << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    file << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << PROCESS_ID
+         << ", \"tid\": 0, \"args\": {\"name\": \"mopo audio\"}}";
+
+    // Track 0 is the audio thread outside of voices, voices are numbered
+    // as they first show up.
+    std::map<const void*, int> tracks;
+    tracks[nullptr] = 0;
+
+    std::vector<TraceEvent> events(READ_EVENTS);
+    while (true) {
+      // A last read after stopping picks up what the final block wrote.
+      bool last = stopping_.load(std::memory_order_acquire);
+      int num = recorder_->read(events.data(), READ_EVENTS);
+
+      for (int i = 0; i < num; ++i) {
+        const TraceEvent& event = events[i];
+        auto track = tracks.find(event.voice);
+        if (track == tracks.end()) {
+          int id = tracks.size();
+          track = tracks.emplace(event.voice, id).first;
+          file << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << PROCESS_ID
+               << ", \"tid\": " << id << ", \"args\": {\"name\": \"voice " << id << "\"}}";
+        }
+
+        file << ",\n{\"pid\": " << PROCESS_ID << ", \"tid\": " << track->second
+             << ", \"ts\": " << event.nanoseconds / 1000.0;
+        if (event.phase == TraceEvent::kEnd)
+          file << ", \"ph\": \"E\"}";
+        else if (event.phase == TraceEvent::kDeadlineMiss)
+          file << ", \"ph\": \"i\", \"s\": \"g\", \"name\": \"deadline miss\"}";
+        else {
+          file << ", \"ph\": \"B\", \"name\": \"" << eventName(event)
+               << "\", \"args\": {\"block\": " << event.block << "}}";
+        }
+      }
+
+      if (last && num == 0)
+        break;
+      if (num == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MILLISECONDS));
+    }
+
+    file << "\n]}\n";
+  }
+} // namespace mopo
+
+#endif // MOPO_PROFILE
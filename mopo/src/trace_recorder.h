@@ -0,0 +1,210 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <string>
+
+#if MOPO_PROFILE
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+#endif
+
+#define DEFAULT_TRACE_EVENTS (1 << 17)
+#define MAX_TRACE_DEPTH 64
+
+namespace mopo {
+
+  class Processor;
+  class ProfileSection;
+
+  // A timeline of what the audio thread ran, for chrome://tracing or
+  // Perfetto. Built with MOPO_PROFILE, while recording every Processor a
+  // router runs writes a begin and an end event into a ring buffer, as do
+  // voices and whole blocks. A TraceWriter drains it to a Chrome trace
+  // JSON file from its own thread. Without it everything here compiles to
+  // nothing.
+  //
+  // The audio thread never waits. When the ring is too full to hold a
+  // begin, its whole node is dropped and counted instead.
+  struct TraceEvent {
+    enum Phase {
+      kBegin,
+      kEnd,
+      kDeadlineMiss
+    };
+
+#if MOPO_PROFILE
+    const char* label;
+    const std::type_info* type;
+    const ProfileSection* section;
+    const void* voice;
+    long long block;
+    long long nanoseconds;
+    Phase phase;
+#endif
+  };
+
+  class TraceRecorder {
+    public:
+#if MOPO_PROFILE
+      TraceRecorder();
+
+      // Not realtime safe. The first start() sizes the ring, later ones
+      // reuse it so a block still finishing never sees it move.
+      void start(int num_events = DEFAULT_TRACE_EVENTS);
+      void stop();
+      bool recording() const { return recording_.load(std::memory_order_acquire); }
+      long long dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+      // Call around a block on the audio thread. Routers running in between
+      // record into this recorder.
+      void beginBlock();
+      void endBlock(int num_samples, int sample_rate);
+
+      // The recorder of the block running on the calling thread, if any.
+      static TraceRecorder* current();
+      static const void* currentVoice();
+      static void setCurrentVoice(const void* voice);
+
+      // Returns false if there was no room and end() must not be called.
+      bool begin(const char* label, const Processor* processor = nullptr);
+      void end();
+
+      // Moves up to _max_events_ recorded events into _events_. Only one
+      // thread may read.
+      int read(TraceEvent* events, int max_events);
+
+    private:
+      void push(const TraceEvent& event);
+
+      std::vector<TraceEvent> events_;
+      unsigned int mask_;
+      std::atomic<unsigned int> write_;
+      std::atomic<unsigned int> read_;
+      std::atomic<bool> recording_;
+      std::atomic<long long> dropped_;
+
+      int depth_;
+      bool block_open_;
+      long long block_;
+      std::chrono::steady_clock::time_point start_time_;
+      std::chrono::steady_clock::time_point block_start_;
+#else
+      void start(int = DEFAULT_TRACE_EVENTS) { }
+      void stop() { }
+      bool recording() const { return false; }
+      long long dropped() const { return 0; }
+
+      void beginBlock() { }
+      void endBlock(int, int) { }
+#endif
+  };
+
+  // Records the Processor while alive, when a block is being traced.
+  class TraceScope {
+    public:
+#if MOPO_PROFILE
+      TraceScope(const Processor* processor) : recorder_(TraceRecorder::current()) {
+        if (recorder_ && !recorder_->begin(nullptr, processor))
+          recorder_ = nullptr;
+      }
+
+      ~TraceScope() {
+        if (recorder_)
+          recorder_->end();
+      }
+#else
+      TraceScope(const Processor*) { }
+#endif
+
+      TraceScope(const TraceScope&) = delete;
+      TraceScope& operator=(const TraceScope&) = delete;
+
+#if MOPO_PROFILE
+    private:
+      TraceRecorder* recorder_;
+#endif
+  };
+
+  // Puts everything traced while alive on _voice_'s track.
+  class TraceVoiceScope {
+    public:
+#if MOPO_PROFILE
+      TraceVoiceScope(const void* voice) : recorder_(TraceRecorder::current()) {
+        if (recorder_ == nullptr)
+          return;
+
+        TraceRecorder::setCurrentVoice(voice);
+        if (!recorder_->begin("voice"))
+          recorder_ = nullptr;
+      }
+
+      ~TraceVoiceScope() {
+        if (recorder_)
+          recorder_->end();
+        TraceRecorder::setCurrentVoice(nullptr);
+      }
+#else
+      TraceVoiceScope(const void*) { }
+#endif
+
+      TraceVoiceScope(const TraceVoiceScope&) = delete;
+      TraceVoiceScope& operator=(const TraceVoiceScope&) = delete;
+
+#if MOPO_PROFILE
+    private:
+      TraceRecorder* recorder_;
+#endif
+  };
+
+  // Drains a TraceRecorder into a Chrome trace event JSON file, which
+  // Perfetto opens too. Each voice gets its own track.
+  class TraceWriter {
+    public:
+#if MOPO_PROFILE
+      TraceWriter();
+      ~TraceWriter();
+
+      // Starts _recorder_ and the writing thread. Returns false if _path_
+      // can't be written.
+      bool start(TraceRecorder* recorder, const std::string& path);
+
+      // Stops recording and finishes the file.
+      void stop();
+      bool running() const { return thread_.joinable(); }
+
+    private:
+      void run(const std::string& path);
+
+      TraceRecorder* recorder_;
+      std::atomic<bool> stopping_;
+      std::thread thread_;
+#else
+      bool start(TraceRecorder*, const std::string&) { return false; }
+      void stop() { }
+      bool running() const { return false; }
+#endif
+  };
+} // namespace mopo
+
+#endif // TRACE_RECORDER_H
@@ -43,6 +43,9 @@ namespace mopo {
     const int MAX_CENTS = MIDI_SIZE * CENTS_PER_NOTE;
     const mopo_float MAX_Q_POW = 4.0;
     const mopo_float MIN_Q_POW = -1.0;
+
+    // Gain utils::quickTanh applies to small signals.
+    const mopo_float QUICK_TANH_SLOPE = 2.45550750702956 / 2.44506634652299;
   }
 
   namespace utils {
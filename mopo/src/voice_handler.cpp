@@ -16,12 +16,29 @@
 
 #include "voice_handler.h"
 
+#include "envelope.h"
+#include "random_generator.h"
+#include "trace_recorder.h"
 #include "utils.h"
 
+#include <algorithm>
+#include <chrono>
+
 namespace mopo {
 
+  namespace {
+    // Streams split from the handler's seed.
+    enum SeedStream {
+      kRouterSeed,
+      kGlobalSeed,
+      kFirstVoiceSeed
+    };
+  } // namespace
+
   Voice::Voice(Processor* processor) : event_sample_(-1),
-      aftertouch_sample_(-1), aftertouch_(0.0), processor_(processor) {
+      aftertouch_sample_(-1), aftertouch_(0.0), quiet_samples_(0),
+      lifetime_samples_(0), released_samples_(0), level_(0.0), cost_(1.0),
+      seconds_(0.0), processor_(processor) {
     state_.event = kVoiceOff;
     state_.note = 0;
     state_.velocity = 0;
@@ -29,6 +46,17 @@ namespace mopo {
     state_.note_pressed = 0;
     state_.channel = 0;
     key_state_ = kReleased;
+
+    for (int i = 0; i < kNumExpressions; ++i) {
+      expression_samples_[i] = -1;
+      expressions_[i] = 0.0;
+    }
+
+    for (int i = 0; i < kNumLinks; ++i) {
+      next_[i] = nullptr;
+      previous_[i] = nullptr;
+      lists_[i] = nullptr;
+    }
   }
 
   Voice::~Voice() {
@@ -37,11 +65,26 @@ namespace mopo {
 
   VoiceHandler::VoiceHandler(size_t polyphony) :
       ProcessorRouter(kNumInputs, 0), polyphony_(0), sustain_(false),
-      legato_(false), voice_killer_(0), last_played_note_(-1.0) {
+      legato_(false), voice_killer_(0), voice_cost_(0), voice_envelope_(0),
+      last_played_note_(-1.0), last_num_voices_(0), mpe_(false),
+      steal_policy_(kStealOldest), same_note_reuse_(true), cpu_budget_(0.0),
+      projected_load_(0.0), budget_kills_(0), num_budget_candidates_(0),
+      random_seed_(0) {
     pressed_notes_.reserve(MIDI_SIZE);
     all_voices_.reserve(MAX_POLYPHONY);
     free_voices_.reserve(MAX_POLYPHONY);
-    active_voices_.reserve(MAX_POLYPHONY);
+
+    for (int i = 0; i < Voice::kNumStates; ++i) {
+      state_voices_[i].setLink(Voice::kStateLink);
+      steal_candidates_[i] = nullptr;
+    }
+    for (int i = 0; i < MIDI_SIZE; ++i)
+      note_voices_[i] = nullptr;
+    for (int i = 0; i < NUM_MIDI_CHANNELS; ++i) {
+      channel_voices_[i] = nullptr;
+      for (int e = 0; e < Voice::kNumExpressions; ++e)
+        channel_expressions_[i][e] = 0.0;
+    }
 
     setPolyphony(polyphony);
     voice_router_.router(this);
@@ -86,11 +129,53 @@ namespace mopo {
     if (voice->hasNewAftertouch())
       aftertouch_.trigger(voice->aftertouch(), voice->aftertouch_sample());
 
+    for (int i = 0; i < Voice::kNumExpressions; ++i) {
+      Voice::Expression lane = static_cast<Voice::Expression>(i);
+      expressions_[i].clearTrigger();
+      if (voice->hasNewExpression(lane))
+        expressions_[i].trigger(voice->expression(lane), voice->expression_sample(lane));
+    }
+
     voice->clearEvents();
   }
 
   void VoiceHandler::processVoice(Voice* voice) {
-    voice->processor()->process();
+    TraceVoiceScope trace(voice);
+    if (cpu_budget_ > 0.0) {
+      auto start = std::chrono::steady_clock::now();
+      voice->processor()->process();
+      std::chrono::duration<mopo_float> elapsed = std::chrono::steady_clock::now() - start;
+      voice->measure(elapsed.count());
+    }
+    else
+      voice->processor()->process();
+
+    voice->advance(buffer_size_);
+
+    if (voice_cost_)
+      voice->setCost(voice_cost_->buffer[0]);
+    if (voice_killer_ && steal_policy_ == kStealQuietest)
+      voice->setLevel(utils::peak(voice_killer_->buffer, buffer_size_, 1));
+  }
+
+  bool VoiceHandler::shouldRetire(Voice* voice) {
+    if (voice->state().event == kVoiceOn)
+      return false;
+
+    if (voice_envelope_) {
+      mopo_float phase = voice_envelope_->output(Envelope::kPhase)->buffer[0];
+      mopo_float value = voice_envelope_->output(Envelope::kValue)->buffer[0];
+      if (retirement_.envelopeFinished(phase, value)) {
+        retirement_.recordRetirement(voice, true);
+        return true;
+      }
+    }
+
+    if (voice_killer_ && retirement_.shouldRetire(voice, voice_killer_->buffer, buffer_size_)) {
+      retirement_.recordRetirement(voice, false);
+      return true;
+    }
+    return false;
   }
 
   void VoiceHandler::clearAccumulatedOutputs() {
@@ -147,37 +232,105 @@ namespace mopo {
     setPolyphony(utils::iclamp(polyphony, 1, polyphony));
     clearAccumulatedOutputs();
 
-    auto iter = active_voices_.begin();
-    while (iter != active_voices_.end()) {
-      Voice* voice = *iter;
+    for (int i = 0; i < Voice::kNumStates; ++i)
+      steal_candidates_[i] = nullptr;
+    num_budget_candidates_ = 0;
+
+    mopo_float projected_seconds = 0.0;
+    Voice* voice = active_voices_.front();
+    while (voice) {
+      Voice* next = voice->next(Voice::kActiveLink);
       prepareVoiceTriggers(voice);
       processVoice(voice);
       accumulateOutputs();
 
-      // Remove voice if the right processor has a full silent buffer.
-      if (voice_killer_ && voice->state().event != kVoiceOn &&
-          utils::isSilent(voice_killer_->buffer, buffer_size_)) {
+      // Remove voice once the retirement policy considers it inaudible.
+      if (shouldRetire(voice)) {
+        removeActiveVoice(voice);
         free_voices_.push_back(voice);
-        iter = active_voices_.erase(iter);
       }
-      else
-        iter++;
+      else {
+        Voice*& candidate = steal_candidates_[voice->key_state()];
+        if (candidate == nullptr || isBetterVictim(voice, candidate))
+          candidate = voice;
+
+        if (voice->state().event != kVoiceKill) {
+          projected_seconds += voice->seconds();
+
+          int age = num_budget_candidates_;
+          if (cpu_budget_ > 0.0 && age < MAX_POLYPHONY) {
+            budget_candidates_[age] = { voice, age };
+            num_budget_candidates_++;
+          }
+        }
+      }
+      voice = next;
     }
 
     if (active_voices_.size())
       writeNonaccumulatedOutputs();
 
+    mopo_float deadline = (1.0 * buffer_size_) / sample_rate_;
+    projected_load_ = projected_seconds / deadline;
+    if (cpu_budget_ > 0.0 && projected_load_ > cpu_budget_)
+      enforceCpuBudget();
+
     last_num_voices_ = num_voices;
   }
 
   void VoiceHandler::setSampleRate(int sample_rate) {
     ProcessorRouter::setSampleRate(sample_rate);
+    retirement_.setSampleRate(sample_rate);
     voice_router_.setSampleRate(sample_rate);
     global_router_.setSampleRate(sample_rate);
     for (int i = 0; i < all_voices_.size(); ++i)
       all_voices_[i]->processor()->setSampleRate(sample_rate);
   }
 
+  size_t VoiceHandler::allocatedBytes() const {
+    size_t bytes = ProcessorRouter::allocatedBytes();
+    bytes += voice_router_.allocatedBytes();
+    bytes += global_router_.allocatedBytes();
+    for (int i = 0; i < all_voices_.size(); ++i)
+      bytes += all_voices_[i]->processor()->allocatedBytes();
+    return bytes;
+  }
+
+  std::vector<Processor*> VoiceHandler::getVoiceCopies(const Processor* processor) const {
+    std::vector<Processor*> copies;
+    for (int i = 0; i < all_voices_.size(); ++i) {
+      ProcessorRouter* router = dynamic_cast<ProcessorRouter*>(all_voices_[i]->processor());
+      Processor* copy = router ? router->getLocalProcessor(processor) : nullptr;
+      if (copy)
+        copies.push_back(copy);
+    }
+    return copies;
+  }
+
+  void VoiceHandler::setRandomSeed(uint64_t seed) {
+    random_seed_ = seed;
+    ProcessorRouter::setRandomSeed(RandomGenerator::mix(seed, kRouterSeed));
+    global_router_.setRandomSeed(RandomGenerator::mix(seed, kGlobalSeed));
+
+    for (int i = 0; i < all_voices_.size(); ++i)
+      all_voices_[i]->processor()->setRandomSeed(getVoiceSeed(i));
+  }
+
+  void VoiceHandler::freeStaleProcessors() {
+    ProcessorRouter::freeStaleProcessors();
+    voice_router_.freeStaleProcessors();
+    global_router_.freeStaleProcessors();
+    for (int i = 0; i < all_voices_.size(); ++i) {
+      ProcessorRouter* voice = dynamic_cast<ProcessorRouter*>(all_voices_[i]->processor());
+      if (voice)
+        voice->freeStaleProcessors();
+    }
+  }
+
+  uint64_t VoiceHandler::getVoiceSeed(int index) const {
+    return RandomGenerator::mix(random_seed_, kFirstVoiceSeed + index);
+  }
+
   void VoiceHandler::setBufferSize(int buffer_size) {
     ProcessorRouter::setBufferSize(buffer_size);
     voice_router_.setBufferSize(buffer_size);
@@ -186,12 +339,18 @@ namespace mopo {
       all_voices_[i]->processor()->setBufferSize(buffer_size);
   }
 
+  void VoiceHandler::addReaders(reader_map* readers) const {
+    ProcessorRouter::addReaders(readers);
+    voice_router_.addReaders(readers);
+    global_router_.addReaders(readers);
+  }
+
   int VoiceHandler::getNumActiveVoices() {
     return active_voices_.size();
   }
 
   bool VoiceHandler::isNotePlaying(mopo_float note) {
-    for (Voice* voice : active_voices_) {
+    for (Voice* voice = active_voices_.front(); voice; voice = voice->next(Voice::kActiveLink)) {
       if (voice->state().note == note)
         return true;
     }
@@ -204,17 +363,88 @@ namespace mopo {
 
   void VoiceHandler::sustainOff(int sample) {
     sustain_ = false;
-    for (Voice* voice : active_voices_) {
-      if (voice->key_state() == Voice::kSustained)
-        voice->deactivate(sample);
+    Voice* voice = state_voices_[Voice::kSustained].front();
+    while (voice) {
+      Voice* next = voice->next(Voice::kStateLink);
+      deactivateVoice(voice, sample);
+      voice = next;
     }
   }
 
   void VoiceHandler::allNotesOff(int sample) {
     pressed_notes_.clear();
 
-    for (Voice* voice : active_voices_)
-      voice->deactivate(sample);
+    for (Voice* voice = active_voices_.front(); voice; voice = voice->next(Voice::kActiveLink))
+      deactivateVoice(voice, sample);
+  }
+
+  void VoiceHandler::activateVoice(Voice* voice, mopo_float note, mopo_float velocity,
+                                   int note_pressed, int sample, int channel) {
+    voice->activate(note, velocity, last_played_note_, note_pressed, sample, channel);
+    active_voices_.push_back(voice);
+    state_voices_[Voice::kHeld].push_back(voice);
+
+    int note_index = utils::iclamp(note, 0, MIDI_SIZE - 1);
+    note_voices_[note_index] = voice;
+
+    // The channel's expression may have been sent before the note.
+    channel_voices_[channel] = voice;
+    for (int i = 0; i < Voice::kNumExpressions; ++i) {
+      Voice::Expression lane = static_cast<Voice::Expression>(i);
+      voice->setExpression(lane, channel_expressions_[channel][i], sample);
+    }
+  }
+
+  Voice* VoiceHandler::getChannelVoice(int channel) const {
+    Voice* voice = channel_voices_[channel];
+    if (voice && voice->state().channel == channel && active_voices_.contains(voice))
+      return voice;
+    return nullptr;
+  }
+
+  void VoiceHandler::deactivateVoice(Voice* voice, int sample) {
+    if (voice->key_state() != Voice::kReleased) {
+      state_voices_[voice->key_state()].remove(voice);
+      state_voices_[Voice::kReleased].push_back(voice);
+    }
+    voice->deactivate(sample);
+  }
+
+  void VoiceHandler::sustainVoice(Voice* voice) {
+    if (voice->key_state() == Voice::kSustained)
+      return;
+
+    state_voices_[voice->key_state()].remove(voice);
+    state_voices_[Voice::kSustained].push_back(voice);
+    voice->sustain();
+  }
+
+  void VoiceHandler::removeActiveVoice(Voice* voice) {
+    active_voices_.remove(voice);
+    state_voices_[voice->key_state()].remove(voice);
+
+    if (steal_candidates_[voice->key_state()] == voice)
+      steal_candidates_[voice->key_state()] = nullptr;
+  }
+
+  bool VoiceHandler::isBetterVictim(Voice* candidate, Voice* current) const {
+    if (steal_policy_ == kStealQuietest)
+      return candidate->level() < current->level();
+    if (steal_policy_ == kStealCostliest) {
+      if (candidate->cost() != current->cost())
+        return candidate->cost() > current->cost();
+      return candidate->seconds() > current->seconds();
+    }
+    return false;
+  }
+
+  Voice* VoiceHandler::findStealCandidate(Voice::KeyState state) const {
+    // The candidate ranked during the last block is only valid while the
+    // voice is still active in the same key state. Otherwise fall back on age.
+    Voice* candidate = steal_candidates_[state];
+    if (candidate && candidate->key_state() == state && active_voices_.contains(candidate))
+      return candidate;
+    return state_voices_[state].front();
   }
 
   Voice* VoiceHandler::grabVoice() {
@@ -228,93 +458,112 @@ namespace mopo {
       return voice;
     }
 
-    // Next check released voices.
-    for (auto iter = active_voices_.begin(); iter != active_voices_.end(); ++iter) {
-      voice = *iter;
-      if (voice->key_state() == Voice::kReleased) {
-        active_voices_.erase(iter);
+    // Next check released voices, then sustained, then held.
+    static const Voice::KeyState steal_order[] = { Voice::kReleased, Voice::kSustained, Voice::kHeld };
+    for (Voice::KeyState state : steal_order) {
+      voice = findStealCandidate(state);
+      if (voice) {
+        removeActiveVoice(voice);
         return voice;
       }
     }
 
-    // Then check sustained voices.
-    for (auto iter = active_voices_.begin(); iter != active_voices_.end(); ++iter) {
-      voice = *iter;
-      if (voice->key_state() == Voice::kSustained) {
-        active_voices_.erase(iter);
-        return voice;
-      }
-    }
-
-    // If all are active just grab the oldest voice.
-    MOPO_ASSERT(active_voices_.size());
-    voice = active_voices_.front();
-    active_voices_.pop_front();
-    return voice;
+    MOPO_ASSERT(false);
+    return nullptr;
   }
 
   Voice* VoiceHandler::getVoiceToKill() {
     int excess_voices = active_voices_.size() - polyphony_;
-    Voice* oldest_released = 0;
-    Voice* oldest_sustained = 0;
-    Voice* oldest_held = 0;
+    Voice* victims[Voice::kNumStates] = { nullptr, nullptr, nullptr };
 
-    for (auto iter = active_voices_.begin(); iter != active_voices_.end(); ++iter) {
-      Voice* voice = *iter;
+    for (Voice* voice = active_voices_.front(); voice; voice = voice->next(Voice::kActiveLink)) {
       if (voice->state().event == kVoiceKill)
         excess_voices--;
-      else if (oldest_released == 0 && voice->key_state() == Voice::kReleased)
-        oldest_released = voice;
-      else if (oldest_sustained == 0 && voice->key_state() == Voice::kSustained)
-        oldest_sustained = voice;
-      else if (oldest_held == 0)
-        oldest_held = voice;
+      else {
+        Voice*& victim = victims[voice->key_state()];
+        if (victim == nullptr || isBetterVictim(voice, victim))
+          victim = voice;
+      }
     }
 
     // Return null if we've killed enough voices.
     if (excess_voices <= 0)
       return 0;
 
-    // If there were any released notes kill the oldest.
-    if (oldest_released)
-      return oldest_released;
-
-    // Then if there were any sustained notes kill the oldest.
-    if (oldest_sustained)
-      return oldest_sustained;
-
-    // If all are active just grab the oldest held voice.
-    if (oldest_held)
-      return oldest_held;
+    if (victims[Voice::kReleased])
+      return victims[Voice::kReleased];
+    if (victims[Voice::kSustained])
+      return victims[Voice::kSustained];
+    return victims[Voice::kHeld];
+  }
+
+  bool VoiceHandler::killsBefore(const BudgetCandidate& a, const BudgetCandidate& b) const {
+    // Released voices go first, then sustained, then held.
+    if (a.voice->key_state() != b.voice->key_state())
+      return a.voice->key_state() > b.voice->key_state();
+    if (isBetterVictim(a.voice, b.voice))
+      return true;
+    if (isBetterVictim(b.voice, a.voice))
+      return false;
+    return a.age < b.age;
+  }
+
+  void VoiceHandler::enforceCpuBudget() {
+    // Kill voices until the remaining ones are expected to fit the budget.
+    // Killed voices fade out over VOICE_KILL_TIME instead of dropping out.
+    mopo_float deadline = (1.0 * buffer_size_) / sample_rate_;
+    mopo_float budget_seconds = cpu_budget_ * deadline;
+    mopo_float projected_seconds = projected_load_ * deadline;
+
+    // The candidates become a heap with the next victim on top, so each kill
+    // is a pop instead of another scan of the active voices.
+    auto killed_later = [this](const BudgetCandidate& a, const BudgetCandidate& b) {
+      return killsBefore(b, a);
+    };
+    BudgetCandidate* begin = budget_candidates_;
+    BudgetCandidate* end = budget_candidates_ + num_budget_candidates_;
+    std::make_heap(begin, end, killed_later);
+
+    while (projected_seconds > budget_seconds && begin != end) {
+      std::pop_heap(begin, end, killed_later);
+      Voice* victim = (--end)->voice;
+
+      // Always leave the newest voice playing.
+      if (victim == active_voices_.back())
+        break;
 
-    return 0;
+      victim->kill();
+      projected_seconds -= victim->seconds();
+      budget_kills_++;
+    }
+    num_budget_candidates_ = 0;
   }
 
   void VoiceHandler::noteOn(mopo_float note, mopo_float velocity, int sample, int channel) {
     MOPO_ASSERT(sample >= 0 && sample < buffer_size_);
     MOPO_ASSERT(channel >= 0 && channel < NUM_MIDI_CHANNELS);
 
-    // Chercher d'abord une voix relâchée correspondant à la note
+    // Reuse a released voice already playing this note so its tail continues.
     Voice* voice = nullptr;
-    for (auto iter = active_voices_.begin(); iter != active_voices_.end(); ++iter) {
-      Voice* v = *iter;
-      if (v->key_state() == Voice::kReleased && v->state().note == note) {
-        voice = v;
-        active_voices_.erase(iter);
-        break;
+    if (same_note_reuse_) {
+      int note_index = utils::iclamp(note, 0, MIDI_SIZE - 1);
+      Voice* last_voice = note_voices_[note_index];
+      if (last_voice && last_voice->key_state() == Voice::kReleased &&
+          last_voice->state().note == note && active_voices_.contains(last_voice)) {
+        voice = last_voice;
+        removeActiveVoice(voice);
       }
     }
-    // Sinon, comportement normal
-    if (!voice) {
+
+    if (!voice)
       voice = grabVoice();
-    }
+
     pressed_notes_.remove(note);
     pressed_notes_.push_front(note);
 
     if (last_played_note_ < 0)
       last_played_note_ = note;
-    voice->activate(note, velocity, last_played_note_, pressed_notes_.size(), sample, channel);
-    active_voices_.push_back(voice);
+    activateVoice(voice, note, velocity, pressed_notes_.size(), sample, channel);
     last_played_note_ = note;
   }
 
@@ -323,52 +572,87 @@ namespace mopo {
 
     VoiceEvent voice_event = kVoiceOff;
 
-    for (Voice* voice : active_voices_) {
-      if (voice->state().note == note) {
-        if (sustain_)
-          voice->sustain();
-        else {
-          if (polyphony_ <= pressed_notes_.size() && voice->state().event != kVoiceKill) {
-            voice->kill();
-
-            Voice* new_voice = grabVoice();
-            active_voices_.push_back(new_voice);
-            mopo_float old_note = pressed_notes_.back();
-            pressed_notes_.pop_back();
-            pressed_notes_.push_front(old_note);
-            new_voice->activate(old_note, voice->state().velocity, last_played_note_,
-                                pressed_notes_.size() + 1, sample);
-            last_played_note_ = old_note;
-
-            voice_event = kVoiceReset;
-          }
-          else
-            voice->deactivate(sample);
+    // Gather first since stealing below reorders the active list.
+    Voice* note_voices[MAX_POLYPHONY];
+    int num_note_voices = 0;
+    for (Voice* voice = active_voices_.front(); voice; voice = voice->next(Voice::kActiveLink)) {
+      if (voice->state().note == note && num_note_voices < MAX_POLYPHONY)
+        note_voices[num_note_voices++] = voice;
+    }
+
+    for (int i = 0; i < num_note_voices; ++i) {
+      Voice* voice = note_voices[i];
+      if (sustain_)
+        sustainVoice(voice);
+      else {
+        if (polyphony_ <= pressed_notes_.size() && voice->state().event != kVoiceKill) {
+          voice->kill();
+
+          Voice* new_voice = grabVoice();
+          mopo_float old_note = pressed_notes_.back();
+          pressed_notes_.pop_back();
+          pressed_notes_.push_front(old_note);
+          activateVoice(new_voice, old_note, voice->state().velocity,
+                        pressed_notes_.size() + 1, sample, 0);
+          last_played_note_ = old_note;
+
+          voice_event = kVoiceReset;
         }
+        else
+          deactivateVoice(voice, sample);
       }
     }
     return voice_event;
   }
 
   void VoiceHandler::setAftertouch(mopo_float note, mopo_float aftertouch, int sample) {
-    for (Voice* voice : active_voices_) {
+    for (Voice* voice = active_voices_.front(); voice; voice = voice->next(Voice::kActiveLink)) {
       if (voice->state().note == note)
         voice->setAftertouch(aftertouch, sample);
     }
   }
 
   void VoiceHandler::setChannelAftertouch(int channel, mopo_float aftertouch, int sample) {
-    for (Voice* voice : active_voices_) {
-      if (voice->state().channel == channel)
+    MOPO_ASSERT(channel >= 0 && channel < NUM_MIDI_CHANNELS);
+
+    if (mpe_ && channel) {
+      Voice* voice = getChannelVoice(channel);
+      if (voice)
         voice->setAftertouch(aftertouch, sample);
+      return;
+    }
+
+    for (Voice* voice = active_voices_.front(); voice; voice = voice->next(Voice::kActiveLink)) {
+      if (voice->state().channel == channel || mpe_)
+        voice->setAftertouch(aftertouch, sample);
+    }
+  }
+
+  void VoiceHandler::setChannelExpression(int channel, Voice::Expression lane,
+                                          mopo_float value, int sample) {
+    MOPO_ASSERT(channel >= 0 && channel < NUM_MIDI_CHANNELS);
+    channel_expressions_[channel][lane] = value;
+
+    if (mpe_ && channel) {
+      Voice* voice = getChannelVoice(channel);
+      if (voice)
+        voice->setExpression(lane, value, sample);
+      return;
+    }
+
+    for (Voice* voice = active_voices_.front(); voice; voice = voice->next(Voice::kActiveLink)) {
+      if (voice->state().channel == channel || mpe_)
+        voice->setExpression(lane, value, sample);
     }
   }
 
   void VoiceHandler::setPolyphony(size_t polyphony) {
     while (all_voices_.size() < polyphony) {
       Voice* new_voice = createVoice();
+      new_voice->processor()->setRandomSeed(getVoiceSeed(all_voices_.size()));
       all_voices_.push_back(new_voice);
       active_voices_.push_back(new_voice);
+      state_voices_[new_voice->key_state()].push_back(new_voice);
     }
 
     int num_voices_to_kill = active_voices_.size() - polyphony;
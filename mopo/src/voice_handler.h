@@ -22,12 +22,15 @@
 #include "note_handler.h"
 #include "processor_router.h"
 #include "value.h"
+#include "voice_retirement.h"
 
 #include <map>
 #include <list>
 
 namespace mopo {
 
+  class VoiceList;
+
   struct VoiceState {
     VoiceEvent event;
     mopo_float note;
@@ -46,6 +49,21 @@ namespace mopo {
         kNumStates
       };
 
+      // Every voice sits in two intrusive lists at once: the age ordered
+      // list of active voices and the list for its current key state.
+      enum Link {
+        kActiveLink,
+        kStateLink,
+        kNumLinks
+      };
+
+      // Per note expression lanes, as sent on MPE member channels.
+      enum Expression {
+        kPitchBend,
+        kSlide,
+        kNumExpressions
+      };
+
       Voice(Processor* voice);
       virtual ~Voice();
 
@@ -57,6 +75,20 @@ namespace mopo {
       mopo_float aftertouch() { return aftertouch_; }
       mopo_float aftertouch_sample() { return aftertouch_sample_; }
 
+      mopo_float expression(Expression lane) { return expressions_[lane]; }
+      int expression_sample(Expression lane) { return expression_samples_[lane]; }
+
+      int quiet_samples() { return quiet_samples_; }
+      long long lifetime_samples() { return lifetime_samples_; }
+      long long released_samples() { return released_samples_; }
+
+      mopo_float level() { return level_; }
+      mopo_float cost() { return cost_; }
+      mopo_float seconds() { return seconds_; }
+
+      Voice* next(Link link) { return next_[link]; }
+      Voice* previous(Link link) { return previous_[link]; }
+
       void activate(mopo_float note, mopo_float velocity,
                     mopo_float last_note, int note_pressed = 0,
                     int sample = 0, int channel = 0) {
@@ -70,6 +102,10 @@ namespace mopo {
         aftertouch_ = velocity;
         aftertouch_sample_ = sample;
         key_state_ = kHeld;
+        quiet_samples_ = 0;
+        lifetime_samples_ = 0;
+        released_samples_ = 0;
+        level_ = 0.0;
       }
 
       void sustain() {
@@ -100,12 +136,44 @@ namespace mopo {
         return aftertouch_sample_ >= 0;
       }
 
+      void setExpression(Expression lane, mopo_float value, int sample = 0) {
+        expressions_[lane] = value;
+        expression_samples_[lane] = sample;
+      }
+
+      bool hasNewExpression(Expression lane) {
+        return expression_samples_[lane] >= 0;
+      }
+
       void clearEvents() {
         event_sample_ = -1;
         aftertouch_sample_ = -1;
+        for (int i = 0; i < kNumExpressions; ++i)
+          expression_samples_[i] = -1;
+      }
+
+      void addQuietSamples(int samples) { quiet_samples_ += samples; }
+      void resetQuietSamples() { quiet_samples_ = 0; }
+
+      void setLevel(mopo_float level) { level_ = level; }
+      void setCost(mopo_float cost) { cost_ = cost; }
+
+      // Exponentially averaged time this voice takes to render a block.
+      void measure(mopo_float seconds) {
+        seconds_ += COST_AVERAGE_DECAY * (seconds - seconds_);
+      }
+
+      void advance(int samples) {
+        lifetime_samples_ += samples;
+        if (state_.event != kVoiceOn)
+          released_samples_ += samples;
       }
 
     private:
+      friend class VoiceList;
+
+      static constexpr mopo_float COST_AVERAGE_DECAY = 0.1;
+
       Voice() { }
 
       int event_sample_;
@@ -115,9 +183,90 @@ namespace mopo {
       int aftertouch_sample_;
       mopo_float aftertouch_;
 
+      int expression_samples_[kNumExpressions];
+      mopo_float expressions_[kNumExpressions];
+
+      int quiet_samples_;
+      long long lifetime_samples_;
+      long long released_samples_;
+
+      mopo_float level_;
+      mopo_float cost_;
+      mopo_float seconds_;
+
+      Voice* next_[kNumLinks];
+      Voice* previous_[kNumLinks];
+      VoiceList* lists_[kNumLinks];
+
       Processor* processor_;
   };
 
+  // Intrusive doubly linked list of voices. Insertion and removal are O(1)
+  // and never allocate, so voices can move between lists on the audio thread.
+  class VoiceList {
+    public:
+      VoiceList(Voice::Link link = Voice::kActiveLink) :
+          link_(link), front_(nullptr), back_(nullptr), size_(0) { }
+
+      void setLink(Voice::Link link) { link_ = link; }
+
+      void push_back(Voice* voice) {
+        MOPO_ASSERT(voice->lists_[link_] == nullptr);
+        voice->lists_[link_] = this;
+        voice->previous_[link_] = back_;
+        voice->next_[link_] = nullptr;
+        if (back_)
+          back_->next_[link_] = voice;
+        else
+          front_ = voice;
+        back_ = voice;
+        size_++;
+      }
+
+      void remove(Voice* voice) {
+        MOPO_ASSERT(contains(voice));
+        Voice* previous = voice->previous_[link_];
+        Voice* next = voice->next_[link_];
+        if (previous)
+          previous->next_[link_] = next;
+        else
+          front_ = next;
+
+        if (next)
+          next->previous_[link_] = previous;
+        else
+          back_ = previous;
+
+        voice->previous_[link_] = nullptr;
+        voice->next_[link_] = nullptr;
+        voice->lists_[link_] = nullptr;
+        size_--;
+      }
+
+      Voice* pop_front() {
+        Voice* voice = front_;
+        if (voice)
+          remove(voice);
+        return voice;
+      }
+
+      // Lists sharing a link are told apart by the list the voice was
+      // last pushed on.
+      bool contains(Voice* voice) const {
+        return voice->lists_[link_] == this;
+      }
+
+      Voice* front() const { return front_; }
+      Voice* back() const { return back_; }
+      int size() const { return size_; }
+
+    private:
+      Voice::Link link_;
+      Voice* front_;
+      Voice* back_;
+      int size_;
+  };
+
   class VoiceHandler : public virtual ProcessorRouter, public NoteHandler {
     public:
       enum Inputs {
@@ -125,6 +274,16 @@ namespace mopo {
         kNumInputs
       };
 
+      // Which voice to take when every voice is busy. Released voices are
+      // always preferred over sustained ones and sustained over held ones;
+      // the policy orders voices inside each of those groups.
+      enum StealPolicy {
+        kStealOldest,
+        kStealQuietest,
+        kStealCostliest,
+        kNumStealPolicies
+      };
+
       VoiceHandler(size_t polyphony = 1);
 
       virtual ~VoiceHandler();
@@ -137,6 +296,15 @@ namespace mopo {
       virtual void process() override;
       virtual void setSampleRate(int sample_rate) override;
       virtual void setBufferSize(int buffer_size) override;
+      virtual void addReaders(reader_map* readers) const override;
+
+      // Every voice, the voice template and the and global processors.
+      virtual size_t allocatedBytes() const override;
+
+      // Each voice gets a seed from _seed_ and its index, voices added later
+      // get theirs the same way.
+      virtual void setRandomSeed(uint64_t seed) override;
+      virtual void freeStaleProcessors() override;
       int getNumActiveVoices();
       CircularQueue<mopo_float>& getPressedNotes() { return pressed_notes_; }
       bool isNotePlaying(mopo_float note);
@@ -147,6 +315,8 @@ namespace mopo {
       virtual VoiceEvent noteOff(mopo_float note, int sample = 0) override;
       void setAftertouch(mopo_float note, mopo_float aftertouch, int sample = 0);
       void setChannelAftertouch(int channel, mopo_float aftertouch, int sample = 0);
+      void setChannelExpression(int channel, Voice::Expression lane,
+                                mopo_float value, int sample = 0);
       void sustainOn();
       void sustainOff(int sample = 0);
 
@@ -157,17 +327,29 @@ namespace mopo {
       Output* channel() { return &channel_; }
       Output* velocity() { return &velocity_; }
       Output* aftertouch() { return &aftertouch_; }
+      Output* expression(Voice::Expression lane) { return &expressions_[lane]; }
       size_t polyphony() { return polyphony_; }
+
+      // MPE lower zone. Channel 0 is the master channel and reaches every
+      // voice, the others carry one note each, so their pressure and
+      // expression go straight to that note's voice.
+      void setMpe(bool mpe) { mpe_ = mpe; }
+      bool isMpe() const { return mpe_; }
     
       mopo_float getLastActiveNote() const;
 
       virtual ProcessorRouter* getMonoRouter() override { return &global_router_; }
       virtual ProcessorRouter* getPolyRouter() override { return &voice_router_; }
 
+      // Every voice's copy of _processor_, a processor of the voice router or
+      // of a router inside it.
+      std::vector<Processor*> getVoiceCopies(const Processor* processor) const;
+
       void addProcessor(Processor* processor) override;
       void removeProcessor(const Processor* processor) override;
       void addGlobalProcessor(Processor* processor);
       void removeGlobalProcessor(Processor* processor);
+
       Output* registerOutput(Output* output) override;
       Output* registerOutput(Output* output, int index) override;
 
@@ -185,6 +367,31 @@ namespace mopo {
         setVoiceKiller(killer->output());
       }
 
+      // Per voice cost estimate, e.g. the number of unison voices rendered.
+      void setVoiceCost(const Output* cost) {
+        voice_cost_ = cost;
+      }
+
+      void setStealPolicy(StealPolicy policy) { steal_policy_ = policy; }
+      StealPolicy getStealPolicy() const { return steal_policy_; }
+      void setSameNoteReuse(bool reuse) { same_note_reuse_ = reuse; }
+
+      // Fraction of the block deadline the voices may use before the oldest
+      // victims are killed. Zero disables the budget.
+      void setCpuBudget(mopo_float fraction) { cpu_budget_ = fraction; }
+      mopo_float getCpuBudget() const { return cpu_budget_; }
+      mopo_float getProjectedLoad() const { return projected_load_; }
+      int getNumBudgetKills() const { return budget_kills_; }
+
+      // Lets released voices retire as soon as this envelope has decayed
+      // under the retirement threshold, without waiting on the killer.
+      void setVoiceEnvelope(const Processor* envelope) {
+        voice_envelope_ = envelope;
+      }
+
+      VoiceRetirementPolicy& getRetirementPolicy() { return retirement_; }
+      const VoiceLifetimeStats& getVoiceLifetimeStats() const { return retirement_.stats(); }
+
       bool isPolyphonic(const Processor* processor) const override;
 
     protected:
@@ -196,8 +403,19 @@ namespace mopo {
       Voice* grabVoice();
       Voice* getVoiceToKill();
       Voice* createVoice();
+      uint64_t getVoiceSeed(int index) const;
+      Voice* findStealCandidate(Voice::KeyState state) const;
+      Voice* getChannelVoice(int channel) const;
+      bool isBetterVictim(Voice* candidate, Voice* current) const;
+      void activateVoice(Voice* voice, mopo_float note, mopo_float velocity,
+                         int note_pressed, int sample, int channel);
+      void deactivateVoice(Voice* voice, int sample);
+      void sustainVoice(Voice* voice);
+      void removeActiveVoice(Voice* voice);
+      void enforceCpuBudget();
       void prepareVoiceTriggers(Voice* voice);
       void processVoice(Voice* voice);
+      bool shouldRetire(Voice* voice);
       void clearAccumulatedOutputs();
       void clearNonaccumulatedOutputs();
       void accumulateOutputs();
@@ -209,6 +427,9 @@ namespace mopo {
       std::map<Output*, Output*> last_voice_outputs_;
       std::map<Output*, Output*> accumulated_outputs_;
       const Output* voice_killer_;
+      const Output* voice_cost_;
+      const Processor* voice_envelope_;
+      VoiceRetirementPolicy retirement_;
       mopo_float last_played_note_;
       int last_num_voices_;
 
@@ -219,15 +440,41 @@ namespace mopo {
       Output channel_;
       Output velocity_;
       Output aftertouch_;
+      Output expressions_[Voice::kNumExpressions];
 
       CircularQueue<mopo_float> pressed_notes_;
       CircularQueue<Voice*> all_voices_;
 
       CircularQueue<Voice*> free_voices_;
-      CircularQueue<Voice*> active_voices_;
+      VoiceList active_voices_;
+      VoiceList state_voices_[Voice::kNumStates];
+      Voice* steal_candidates_[Voice::kNumStates];
+      Voice* note_voices_[MIDI_SIZE];
+
+      bool mpe_;
+      Voice* channel_voices_[NUM_MIDI_CHANNELS];
+      mopo_float channel_expressions_[NUM_MIDI_CHANNELS][Voice::kNumExpressions];
+
+      StealPolicy steal_policy_;
+      bool same_note_reuse_;
+      mopo_float cpu_budget_;
+      mopo_float projected_load_;
+      int budget_kills_;
+
+      // Voices the budget may kill, gathered while the voices process.
+      struct BudgetCandidate {
+        Voice* voice;
+        int age;
+      };
+
+      bool killsBefore(const BudgetCandidate& a, const BudgetCandidate& b) const;
+
+      BudgetCandidate budget_candidates_[MAX_POLYPHONY];
+      int num_budget_candidates_;
 
       ProcessorRouter voice_router_;
       ProcessorRouter global_router_;
+      uint64_t random_seed_;
   };
 } // namespace mopo
 
@@ -0,0 +1,91 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "voice_retirement.h"
+
+#include "envelope.h"
+#include "utils.h"
+#include "voice_handler.h"
+
+#define DEFAULT_RETIRE_DB -90.0
+#define DEFAULT_RETIRE_HOLD 0.01
+
+namespace mopo {
+
+  VoiceRetirementPolicy::VoiceRetirementPolicy() :
+      sample_rate_(DEFAULT_SAMPLE_RATE), hold_seconds_(DEFAULT_RETIRE_HOLD),
+      hold_samples_(0), detector_(kPeak) {
+    setThreshold(DEFAULT_RETIRE_DB);
+    computeHoldSamples();
+  }
+
+  void VoiceRetirementPolicy::setSampleRate(int sample_rate) {
+    sample_rate_ = sample_rate;
+    computeHoldSamples();
+  }
+
+  void VoiceRetirementPolicy::setThreshold(mopo_float decibels) {
+    threshold_decibels_ = decibels;
+    threshold_gain_ = utils::dbToGain(decibels);
+  }
+
+  void VoiceRetirementPolicy::setHoldTime(mopo_float seconds) {
+    hold_seconds_ = utils::max(seconds, 0.0);
+    computeHoldSamples();
+  }
+
+  void VoiceRetirementPolicy::computeHoldSamples() {
+    hold_samples_ = hold_seconds_ * sample_rate_;
+  }
+
+  bool VoiceRetirementPolicy::envelopeFinished(mopo_float phase, mopo_float value) const {
+    int state = static_cast<int>(phase);
+    if (state == Envelope::kKilling)
+      return value <= 0.0;
+    if (state == Envelope::kReleasing)
+      return value < threshold_gain_;
+    return false;
+  }
+
+  bool VoiceRetirementPolicy::shouldRetire(Voice* voice, const mopo_float* buffer,
+                                           int buffer_size) const {
+    mopo_float level = 0.0;
+    if (detector_ == kRms)
+      level = utils::rms(buffer, buffer_size);
+    else
+      level = utils::peak(buffer, buffer_size, 1);
+
+    if (level >= threshold_gain_) {
+      voice->resetQuietSamples();
+      return false;
+    }
+
+    voice->addQuietSamples(buffer_size);
+    return voice->quiet_samples() >= hold_samples_;
+  }
+
+  void VoiceRetirementPolicy::recordRetirement(Voice* voice, bool from_envelope) {
+    mopo_float lifetime = (1.0 * voice->lifetime_samples()) / sample_rate_;
+    mopo_float tail = (1.0 * voice->released_samples()) / sample_rate_;
+
+    stats_.retired++;
+    if (from_envelope)
+      stats_.envelope_retired++;
+    stats_.total_lifetime += lifetime;
+    stats_.total_tail += tail;
+    stats_.longest_tail = utils::max(stats_.longest_tail, tail);
+  }
+} // namespace mopo
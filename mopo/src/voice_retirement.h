@@ -0,0 +1,103 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef VOICE_RETIREMENT_H
+#define VOICE_RETIREMENT_H
+
+#include "common.h"
+
+namespace mopo {
+
+  class Voice;
+
+  // Running totals describing how long voices lived before being retired.
+  // Written on the audio thread, read by whoever owns the engine lock.
+  struct VoiceLifetimeStats {
+    VoiceLifetimeStats() { reset(); }
+
+    void reset() {
+      retired = 0;
+      envelope_retired = 0;
+      total_lifetime = 0.0;
+      total_tail = 0.0;
+      longest_tail = 0.0;
+    }
+
+    mopo_float averageLifetime() const {
+      return retired ? total_lifetime / retired : 0.0;
+    }
+
+    mopo_float averageTail() const {
+      return retired ? total_tail / retired : 0.0;
+    }
+
+    int retired;
+    int envelope_retired;
+    mopo_float total_lifetime;
+    mopo_float total_tail;
+    mopo_float longest_tail;
+  };
+
+  // Decides when a released voice is quiet enough to give back to the free
+  // pool. A voice retires when its killer output stays under the threshold
+  // for the hold time, or immediately once its amplitude envelope is releasing
+  // or killing below the threshold.
+  class VoiceRetirementPolicy {
+    public:
+      enum Detector {
+        kPeak,
+        kRms,
+        kNumDetectors
+      };
+
+      VoiceRetirementPolicy();
+
+      void setSampleRate(int sample_rate);
+      void setThreshold(mopo_float decibels);
+      void setHoldTime(mopo_float seconds);
+      void setDetector(Detector detector) { detector_ = detector; }
+
+      mopo_float threshold() const { return threshold_decibels_; }
+      mopo_float holdTime() const { return hold_seconds_; }
+      Detector detector() const { return detector_; }
+
+      // Fast path using the amplitude envelope state and value.
+      bool envelopeFinished(mopo_float phase, mopo_float value) const;
+
+      // Updates the quiet time of _voice_ and returns true once it has been
+      // under the threshold long enough.
+      bool shouldRetire(Voice* voice, const mopo_float* buffer, int buffer_size) const;
+
+      void recordRetirement(Voice* voice, bool from_envelope);
+      const VoiceLifetimeStats& stats() const { return stats_; }
+      void resetStats() { stats_.reset(); }
+
+    private:
+      void computeHoldSamples();
+
+      int sample_rate_;
+      mopo_float threshold_decibels_;
+      mopo_float threshold_gain_;
+      mopo_float hold_seconds_;
+      int hold_samples_;
+      Detector detector_;
+
+      VoiceLifetimeStats stats_;
+  };
+} // namespace mopo
+
+#endif // VOICE_RETIREMENT_H
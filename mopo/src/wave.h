@@ -19,9 +19,9 @@
 #define WAVE_H
 
 #include "common.h"
+#include "random_generator.h"
 #include "utils.h"
 #include <cmath>
-#include <cstdlib>
 
 #define LOOKUP_SIZE 2048
 #define HIGH_FREQUENCY 20000
@@ -292,7 +292,8 @@ namespace mopo {
       }
 
       static inline mopo_float whitenoise() {
-        return (2.0 * rand()) / RAND_MAX - 1;
+        static thread_local RandomGenerator random;
+        return random.nextBipolar();
       }
 
       static inline mopo_float fullsin(mopo_float t) {
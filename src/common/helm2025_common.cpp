@@ -61,6 +61,8 @@ namespace mopo {
       ValueDetails::kLinear, false, "", "Delay Tempo" },
     { "distortion_on", 0.0, 1.0, 2, 0.0, 0.0, 1.0,
       ValueDetails::kLinear, false, "", "Distortion Switch" },
+    { "distortion_oversampling", 0.0, 3.0, 4, 0.0, 0.0, 1.0,
+      ValueDetails::kLinear, false, "", "Distortion Oversampling" },
     { "distortion_type", 0.0, 3.0, 4, 0.0, 0.0, 1.0,
       ValueDetails::kLinear, false, "", "Distortion Type" },
     { "distortion_drive", -30.0, 30.0, 0, 0.0, 0.0, 1.0,
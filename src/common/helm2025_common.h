@@ -182,7 +182,7 @@ namespace mopo {
   const int NUM_CHANNELS = 2;
   const int MEMORY_SAMPLE_RATE = 22000;
   const int MEMORY_RESOLUTION = 512;
-  const mopo_float STUTTER_MAX_SAMPLES = 96000.0;
+  const mopo_float STUTTER_MAX_SECONDS = 2.0;
   const int DEFAULT_MODULATION_CONNECTIONS = 256;
   const int DEFAULT_WINDOW_WIDTH = 992;
   const int DEFAULT_WINDOW_HEIGHT = 734;
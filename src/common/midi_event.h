@@ -36,20 +36,25 @@ struct MidiControlChange {
     uint8_t controller;
     uint8_t value;
     uint8_t channel;
+    int32_t sample;
 
     constexpr bool operator==(const MidiControlChange& other) const noexcept {
         return controller == other.controller && 
                value == other.value && 
-               channel == other.channel;
+               channel == other.channel &&
+               sample == other.sample;
     }
 };
 
 struct MidiPitchBend {
     int16_t value;  // -8192 to +8191
     uint8_t channel;
+    int32_t sample;
 
     constexpr bool operator==(const MidiPitchBend& other) const noexcept {
-        return value == other.value && channel == other.channel;
+        return value == other.value && 
+               channel == other.channel &&
+               sample == other.sample;
     }
 };
 
@@ -79,15 +84,78 @@ struct MidiChannelAftertouch {
     }
 };
 
+struct MidiProgramChange {
+    uint8_t program;
+    uint8_t channel;
+    int32_t sample;
+
+    constexpr bool operator==(const MidiProgramChange& other) const noexcept {
+        return program == other.program && 
+               channel == other.channel &&
+               sample == other.sample;
+    }
+};
+
 using MidiEvent = std::variant<
     MidiNoteOn,
     MidiNoteOff,
     MidiControlChange,
     MidiPitchBend,
     MidiAftertouch,
-    MidiChannelAftertouch
+    MidiChannelAftertouch,
+    MidiProgramChange
 >;
 
+[[nodiscard]] inline int32_t getMidiEventSample(const MidiEvent& event) noexcept {
+    return std::visit([](const auto& e) { return e.sample; }, event);
+}
+
+// Decodes one raw channel message, like the bytes of a juce::MidiBuffer
+// entry, without building a MidiMessage. Note on with velocity 0 is a note
+// off. Returns false for system messages and anything too short.
+[[nodiscard]] inline bool decodeMidiEvent(const uint8_t* data, int size, int32_t sample,
+                                          MidiEvent* event) noexcept {
+    if (size < 2 || data[0] < 0x80 || data[0] >= 0xf0)
+        return false;
+
+    uint8_t status = data[0] & 0xf0;
+    uint8_t channel = data[0] & 0x0f;
+    if (status == 0xc0) {
+        *event = MidiProgramChange{ data[1], channel, sample };
+        return true;
+    }
+    if (status == 0xd0) {
+        *event = MidiChannelAftertouch{ data[1], channel, sample };
+        return true;
+    }
+    if (size < 3)
+        return false;
+
+    switch (status) {
+        case 0x80:
+            *event = MidiNoteOff{ data[1], channel, sample };
+            return true;
+        case 0x90:
+            if (data[2] == 0)
+                *event = MidiNoteOff{ data[1], channel, sample };
+            else
+                *event = MidiNoteOn{ data[1], data[2], channel, sample };
+            return true;
+        case 0xa0:
+            *event = MidiAftertouch{ data[1], data[2], channel, sample };
+            return true;
+        case 0xb0:
+            *event = MidiControlChange{ data[1], data[2], channel, sample };
+            return true;
+        case 0xe0:
+            *event = MidiPitchBend{ static_cast<int16_t>((data[1] | (data[2] << 7)) - 8192),
+                                    channel, sample };
+            return true;
+        default:
+            return false;
+    }
+}
+
 class MidiEventHandler {
 public:
     virtual ~MidiEventHandler() = default;
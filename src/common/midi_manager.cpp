@@ -24,12 +24,24 @@
 #define BANK_SELECT_NUMBER 0
 #define FOLDER_SELECT_NUMBER 32
 #define MOD_WHEEL_CONTROL_NUMBER 1
+#define SUSTAIN_PEDAL_NUMBER 64
+#define SUSTAIN_PEDAL_THRESHOLD 64
+#define ALL_NOTES_OFF_NUMBER 123
+#define SLIDE_CONTROL_NUMBER 74
+#define DATA_ENTRY_NUMBER 6
+#define RPN_LSB_NUMBER 100
+#define RPN_MSB_NUMBER 101
+#define RPN_PITCH_BEND_RANGE 0x0000
+#define RPN_MPE_CONFIGURATION 0x0006
+#define RPN_NULL 0x3fff
 
 MidiManager::MidiManager(SynthBase* synth, MidiKeyboardState* keyboard_state,
                          std::map<std::string, String>* gui_state, Listener* listener) :
     synth_(synth), keyboard_state_(keyboard_state), gui_state_(gui_state),
     listener_(listener), armed_value_(nullptr) {
   engine_ = synth_->getEngine();
+  for (int i = 0; i < mopo::NUM_MIDI_CHANNELS; ++i)
+    rpns_[i] = RPN_NULL;
 }
 
 MidiManager::~MidiManager() {
@@ -96,57 +108,84 @@ void MidiManager::removeNextBlockOfMessages(MidiBuffer& buffer, int num_samples)
 }
 
 void MidiManager::processMidiMessage(const MidiMessage& midi_message, int sample_position) {
-  if (midi_message.isProgramChange()) {
-    current_patch_ = midi_message.getProgramChangeNumber();
+  mopo::MidiEvent event;
+  if (mopo::decodeMidiEvent(midi_message.getRawData(), midi_message.getRawDataSize(),
+                            sample_position, &event)) {
+    processMidiEvent(event);
+  }
+}
+
+void MidiManager::processMidiEvent(const mopo::MidiEvent& event, int sample) {
+  if (const mopo::MidiProgramChange* program = std::get_if<mopo::MidiProgramChange>(&event)) {
+    current_patch_ = program->program;
     File patch = LoadSave::loadPatch(current_bank_, current_folder_, current_patch_,
                                      synth_, *gui_state_);
     PatchLoadedCallback* callback = new PatchLoadedCallback(listener_, patch);
     (void)callback->post();
-    return;
   }
-
-  if (midi_message.isNoteOn()) {
-    engine_->noteOn(midi_message.getNoteNumber(),
-                    midi_message.getVelocity() / (mopo::MIDI_SIZE - 1.0),
-                    0, midi_message.getChannel() - 1);
+  else if (const mopo::MidiNoteOn* note_on = std::get_if<mopo::MidiNoteOn>(&event)) {
+    engine_->noteOn(note_on->note, note_on->velocity / (mopo::MIDI_SIZE - 1.0),
+                    sample, note_on->channel);
   }
-  else if (midi_message.isNoteOff())
-    (void)engine_->noteOff(midi_message.getNoteNumber());
-  else if (midi_message.isAllNotesOff())
-    (void)engine_->allNotesOff();
-  else if (midi_message.isSustainPedalOn())
-    (void)engine_->sustainOn();
-  else if (midi_message.isSustainPedalOff())
-    (void)engine_->sustainOff();
-  else if (midi_message.isAftertouch()) {
-    mopo::mopo_float note = midi_message.getNoteNumber();
-    mopo::mopo_float value = (1.0 * midi_message.getAfterTouchValue()) / mopo::MIDI_SIZE;
+  else if (const mopo::MidiNoteOff* note_off = std::get_if<mopo::MidiNoteOff>(&event))
+    (void)engine_->noteOff(note_off->note, sample);
+  else if (const mopo::MidiAftertouch* aftertouch = std::get_if<mopo::MidiAftertouch>(&event)) {
+    mopo::mopo_float note = aftertouch->note;
+    mopo::mopo_float value = (1.0 * aftertouch->pressure) / mopo::MIDI_SIZE;
     (void)engine_->setAftertouch(note, value);
   }
-  else if (midi_message.isChannelPressure()) {
-    int channel = midi_message.getChannel();
-    mopo::mopo_float value = midi_message.getChannelPressureValue() / (mopo::MIDI_SIZE - 1.0f);
+  else if (const mopo::MidiChannelAftertouch* pressure =
+           std::get_if<mopo::MidiChannelAftertouch>(&event)) {
+    int channel = pressure->channel;
+    mopo::mopo_float value = pressure->pressure / (mopo::MIDI_SIZE - 1.0f);
     (void)engine_->setChannelAftertouch(channel, value);
   }
-  else if (midi_message.isPitchWheel()) {
-    double percent = (1.0 * midi_message.getPitchWheelValue()) / PITCH_WHEEL_RESOLUTION;
+  else if (const mopo::MidiPitchBend* pitch_bend = std::get_if<mopo::MidiPitchBend>(&event)) {
+    double percent = (1.0 * (pitch_bend->value + 8192)) / PITCH_WHEEL_RESOLUTION;
     double value = 2 * percent - 1.0;
-    (void)engine_->setPitchWheel(value, midi_message.getChannel());
+    (void)engine_->setPitchWheel(value, pitch_bend->channel + 1);
   }
-  else if (midi_message.isController()) {
-    int controller_number = midi_message.getControllerNumber();
-    if (controller_number == MOD_WHEEL_CONTROL_NUMBER) {
-      double percent = (1.0 * midi_message.getControllerValue()) / MOD_WHEEL_RESOLUTION;
-      engine_->setModWheel(percent, midi_message.getChannel());
+  else if (const mopo::MidiControlChange* control = std::get_if<mopo::MidiControlChange>(&event)) {
+    int controller_number = control->controller;
+    if (controller_number == ALL_NOTES_OFF_NUMBER)
+      (void)engine_->allNotesOff();
+    else if (controller_number == SUSTAIN_PEDAL_NUMBER) {
+      if (control->value >= SUSTAIN_PEDAL_THRESHOLD)
+        (void)engine_->sustainOn();
+      else
+        (void)engine_->sustainOff();
+    }
+    else {
+      if (controller_number == MOD_WHEEL_CONTROL_NUMBER) {
+        double percent = (1.0 * control->value) / MOD_WHEEL_RESOLUTION;
+        engine_->setModWheel(percent, control->channel + 1);
+      }
+      else if (controller_number == SLIDE_CONTROL_NUMBER)
+        engine_->setSlide((1.0 * control->value) / (mopo::MIDI_SIZE - 1), control->channel + 1);
+      else if (controller_number == RPN_MSB_NUMBER)
+        rpns_[control->channel] = (control->value << 7) | (rpns_[control->channel] & 0x7f);
+      else if (controller_number == RPN_LSB_NUMBER)
+        rpns_[control->channel] = (rpns_[control->channel] & ~0x7f) | control->value;
+      else if (controller_number == DATA_ENTRY_NUMBER)
+        processRpn(control->channel, control->value);
+      else if (controller_number == BANK_SELECT_NUMBER)
+        current_bank_ = control->value;
+      else if (controller_number == FOLDER_SELECT_NUMBER)
+        current_folder_ = control->value;
+      midiInput(controller_number, control->value);
     }
-    else if (controller_number == BANK_SELECT_NUMBER)
-      current_bank_ = midi_message.getControllerValue();
-    else if (controller_number == FOLDER_SELECT_NUMBER)
-      current_folder_ = midi_message.getControllerValue();
-    midiInput(midi_message.getControllerNumber(), midi_message.getControllerValue());
   }
 }
 
+void MidiManager::processRpn(int channel, int value) {
+  // The MPE configuration message on the lower zone's master channel sets
+  // the number of member channels, zero turns MPE off.
+  if (rpns_[channel] == RPN_MPE_CONFIGURATION && channel == 0)
+    engine_->setMpe(value > 0);
+  else if (rpns_[channel] == RPN_PITCH_BEND_RANGE && channel > 0 && engine_->isMpe())
+    engine_->setMpePitchBendRange(value);
+}
+
 void MidiManager::handleIncomingMidiMessage(MidiInput *source,
                                             const MidiMessage &midi_message) {
   midi_collector_.addMessageToQueue(midi_message);
@@ -156,3 +195,7 @@ void MidiManager::replaceKeyboardMessages(MidiBuffer& buffer, int num_samples) {
   keyboard_state_->processNextMidiBuffer(buffer, 0, num_samples, true);
 }
 
+void MidiManager::updateKeyboardState(MidiBuffer& buffer, int num_samples) {
+  keyboard_state_->processNextMidiBuffer(buffer, 0, num_samples, false);
+}
+
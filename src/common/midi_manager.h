@@ -20,6 +20,7 @@
 #include <JuceHeader.h>
 #include "common.h"
 #include "helm2025_common.h"
+#include "midi_event.h"
 #include <string>
 #include <map>
 
@@ -50,11 +51,13 @@ class MidiManager : public MidiInputCallback {
     void clearMidiLearn(const std::string& name);
     void midiInput(int control, mopo::mopo_float value);
     void processMidiMessage(const MidiMessage &midi_message, int sample_position = 0);
+    void processMidiEvent(const mopo::MidiEvent& event, int sample = 0);
     bool isMidiMapped(const std::string& name) const;
 
     void setSampleRate(double sample_rate);
     void removeNextBlockOfMessages(MidiBuffer& buffer, int num_samples);
     void replaceKeyboardMessages(MidiBuffer& buffer, int num_samples);
+    void updateKeyboardState(MidiBuffer& buffer, int num_samples);
 
     midi_map getMidiLearnMap() { return midi_learn_map_; }
     void setMidiLearnMap(midi_map midi_learn_map) { midi_learn_map_ = midi_learn_map; }
@@ -75,6 +78,8 @@ class MidiManager : public MidiInputCallback {
     };
 
   protected:
+    void processRpn(int channel, int value);
+
     SynthBase* synth_;
     mopo::HelmEngine* engine_;
     MidiKeyboardState* keyboard_state_;
@@ -87,6 +92,9 @@ class MidiManager : public MidiInputCallback {
 
     const mopo::ValueDetails* armed_value_;
     midi_map midi_learn_map_;
+
+    // Registered parameter selected on each channel for data entry.
+    int rpns_[mopo::NUM_MIDI_CHANNELS];
 };
 
 #endif // MIDI_MANAGER_H
@@ -24,12 +24,17 @@
 #include <thread>
 
 #define OUTPUT_WINDOW_MIN_NOTE 16.0
+#define MAX_MIDI_EVENTS 2048
+#define MAX_KEYBOARD_MIDI_BYTES 4096
 
 SynthBase::SynthBase() {
   controls_ = engine_.getControls();
 
   keyboard_state_ = std::make_unique<MidiKeyboardState>();
   midi_manager_ = std::make_unique<MidiManager>(this, keyboard_state_.get(), &save_info_, this);
+  keyboard_messages_.ensureSize(MAX_KEYBOARD_MIDI_BYTES);
+  midi_events_.reserve(MAX_MIDI_EVENTS);
+  midi_event_index_ = 0;
 
   last_played_note_ = 0.0;
   last_num_pressed_ = 0;
@@ -47,7 +52,12 @@ void SynthBase::valueChanged(const std::string& name, mopo::mopo_float value) {
 }
 
 void SynthBase::valueChangedInternal(const std::string& name, mopo::mopo_float value) {
+  // Memory goes in before stutter turns on and comes out after it's off.
+  if (name == "stutter_on" && value)
+    setStutterMemory(true);
   valueChanged(name, value);
+  if (name == "stutter_on" && !value)
+    setStutterMemory(false);
   setValueNotifyHost(name, value);
 }
 
@@ -72,9 +82,11 @@ void SynthBase::exportToFileAsync(std::function<void(bool)> callback) {
 
 void SynthBase::valueChangedThroughMidi(const std::string& name, mopo::mopo_float value) {
   controls_[name]->set(value);
-  ValueChangedCallback* callback = new ValueChangedCallback(this, name, value);
   setValueNotifyHost(name, value);
-  callback->post();
+  if (!isOfflineRender()) {
+    ValueChangedCallback* callback = new ValueChangedCallback(this, name, value);
+    callback->post();
+  }
 }
 
 void SynthBase::patchChangedThroughMidi(File patch) {
@@ -87,8 +99,66 @@ void SynthBase::patchChangedThroughMidi(File patch) {
 
 void SynthBase::valueChangedExternal(const std::string& name, mopo::mopo_float value) {
   valueChanged(name, value);
-  ValueChangedCallback* callback = new ValueChangedCallback(this, name, value);
-  callback->post();
+  if (!isOfflineRender()) {
+    ValueChangedCallback* callback = new ValueChangedCallback(this, name, value);
+    callback->post();
+  }
+}
+
+void SynthBase::setOfflineRender(bool offline) {
+  bool was_offline = isOfflineRender();
+  engine_.setOfflineRender(offline);
+  setStutterMemory(controls_["stutter_on"]->value());
+  if (was_offline && !offline) {
+    FullGuiCallback* callback = new FullGuiCallback(this);
+    callback->post();
+  }
+}
+
+void SynthBase::setStutterMemory(bool stutter_on) {
+  bool wanted = stutter_on || isOfflineRender();
+  std::vector<mopo::Memory*> spares;
+  std::vector<mopo::Memory*> freed;
+
+  // Voices can be added while we allocate, so go again until all have it.
+  bool done = false;
+  while (!done) {
+    size_t missing = 0;
+    int size = 0;
+    {
+      ScopedLock lock(getCriticalSection());
+      for (mopo::Stutter* stutter : engine_.getStutters()) {
+        if (wanted && !stutter->hasMemory()) {
+          missing++;
+          size = stutter->getMemorySize();
+        }
+      }
+    }
+
+    while (spares.size() < missing)
+      spares.push_back(new mopo::Memory(size));
+
+    ScopedLock lock(getCriticalSection());
+    done = true;
+    for (mopo::Stutter* stutter : engine_.getStutters()) {
+      if (stutter->hasMemory() == wanted)
+        continue;
+
+      if (!wanted)
+        freed.push_back(stutter->swapMemory(nullptr));
+      else if (spares.size()) {
+        stutter->swapMemory(spares.back());
+        spares.pop_back();
+      }
+      else
+        done = false;
+    }
+  }
+
+  for (mopo::Memory* memory : spares)
+    delete memory;
+  for (mopo::Memory* memory : freed)
+    delete memory;
 }
 
 void SynthBase::changeModulationAmount(const std::string& source,
@@ -113,12 +183,26 @@ mopo::ModulationConnection* SynthBase::getConnection(const std::string& source,
 
 void SynthBase::setModulationAmount(mopo::ModulationConnection* connection,
                                     mopo::mopo_float amount) {
+  bool connected = mod_connections_.count(connection);
+  if (connected != (amount != 0.0)) {
+    // Rewiring allocates copies of the scale for every voice, so it happens
+    // here under the engine lock instead of on the audio thread.
+    ScopedLock lock(getCriticalSection());
+    connection->amount.set(amount);
+    if (connected)
+      engine_.disconnectModulation(connection);
+    else
+      engine_.connectModulation(connection);
+  }
+
   if (amount == 0.0) {
     modulation_bank_.recycle(connection);
     mod_connections_.erase(connection);
   }
-  else if (mod_connections_.count(connection) == 0)
+  else if (!connected)
     mod_connections_.insert(connection);
+
+  // Queued even after rewiring so older queued amounts can't win.
   modulation_change_queue_.enqueue(mopo::modulation_change(connection, amount));
 }
 
@@ -174,12 +258,14 @@ void SynthBase::loadInitPatch() {
   getCriticalSection().enter();
   LoadSave::initSynth(this, save_info_);
   getCriticalSection().exit();
+  setStutterMemory(controls_["stutter_on"]->value());
 }
 
 void SynthBase::loadFromVar(juce::var state) {
   getCriticalSection().enter();
   LoadSave::varToState(this, save_info_, state);
   getCriticalSection().exit();
+  setStutterMemory(controls_["stutter_on"]->value());
 }
 
 bool SynthBase::loadFromFile(File patch) {
@@ -253,25 +339,47 @@ void SynthBase::processAudio(AudioSampleBuffer* buffer, int channels, int sample
     }
   }
 
-  updateMemoryOutput(samples, engine_output_left, engine_output_right);
+  if (!engine_.shouldSkipTelemetry())
+    updateMemoryOutput(samples, engine_output_left, engine_output_right);
 }
 
-void SynthBase::processMidi(MidiBuffer& midi_messages, int start_sample, int end_sample) {
-  bool process_all = end_sample == 0;
+void SynthBase::decodeMidi(MidiBuffer& midi_messages, int num_samples) {
+  keyboard_messages_.clear();
+  midi_manager_->replaceKeyboardMessages(keyboard_messages_, num_samples);
+  midi_manager_->updateKeyboardState(midi_messages, num_samples);
+
+  midi_events_.clear();
+  midi_event_index_ = 0;
+
+  // Both buffers are sorted, keyboard events go first on ties.
+  auto keyboard = keyboard_messages_.cbegin();
+  auto host = midi_messages.cbegin();
+  while (keyboard != keyboard_messages_.cend() || host != midi_messages.cend()) {
+    bool from_keyboard = host == midi_messages.cend() ||
+                         (keyboard != keyboard_messages_.cend() &&
+                          (*keyboard).samplePosition <= (*host).samplePosition);
+    const MidiMessageMetadata metadata = from_keyboard ? *keyboard++ : *host++;
 
-  for (auto it = midi_messages.cbegin(); it != midi_messages.cend(); ++it) {
-    int midi_sample = (*it).samplePosition;
-    if (process_all || (midi_sample >= start_sample && midi_sample < end_sample))
-      midi_manager_->processMidiMessage((*it).getMessage(), midi_sample - start_sample);
+    mopo::MidiEvent event;
+    if (mopo::decodeMidiEvent(metadata.data, metadata.numBytes, metadata.samplePosition, &event))
+      midi_events_.push_back(event);
+
+    // Growing the list would allocate on the audio thread.
+    if (midi_events_.size() >= MAX_MIDI_EVENTS)
+      break;
   }
 }
 
-void SynthBase::processKeyboardEvents(MidiBuffer& buffer, int num_samples) {
-  MidiBuffer keyboard_messages;
-  midi_manager_->replaceKeyboardMessages(keyboard_messages, num_samples);
-  midi_manager_->replaceKeyboardMessages(buffer, num_samples);
+void SynthBase::processMidi(int start_sample, int end_sample) {
+  int num_events = static_cast<int>(midi_events_.size());
+  for (; midi_event_index_ < num_events; ++midi_event_index_) {
+    const mopo::MidiEvent& event = midi_events_[midi_event_index_];
+    int sample = mopo::getMidiEventSample(event);
+    if (sample >= end_sample)
+      break;
 
-  processMidi(keyboard_messages);
+    midi_manager_->processMidiEvent(event, std::max(0, sample - start_sample));
+  }
 }
 
 void SynthBase::processControlChanges() {
@@ -282,17 +390,8 @@ void SynthBase::processControlChanges() {
 
 void SynthBase::processModulationChanges() {
   mopo::modulation_change change;
-  while (getNextModulationChange(change)) {
-    mopo::ModulationConnection* connection = change.first;
-    mopo::mopo_float amount = change.second;
-    connection->amount.set(amount);
-
-    bool active = engine_.isModulationActive(connection);
-    if (active && amount == 0.0)
-      engine_.disconnectModulation(connection);
-    else if (!active && amount)
-      engine_.connectModulation(connection);
-  }
+  while (getNextModulationChange(change))
+    change.first->amount.set(change.second);
 }
 
 void SynthBase::updateMemoryOutput(int samples, const mopo::mopo_float* left,
@@ -377,8 +476,20 @@ String SynthBase::getFolderName() {
   return save_info_["folder_name"];
 }
 
+void SynthBase::FullGuiCallback::messageCallback() {
+  if (listener) {
+    SynthGuiInterface* gui_interface = listener->getGuiInterface();
+    if (gui_interface)
+      gui_interface->updateFullGui();
+  }
+}
+
 void SynthBase::ValueChangedCallback::messageCallback() {
   if (listener) {
+    // MIDI and host changes land on the audio thread, stutter memory can't.
+    if (control_name == "stutter_on")
+      listener->setStutterMemory(value);
+
     SynthGuiInterface* gui_interface = listener->getGuiInterface();
     if (gui_interface) {
       gui_interface->updateGuiControl(control_name, value);
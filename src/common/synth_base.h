@@ -23,6 +23,7 @@
 #include "helm2025_common.h"
 #include "helm2025_engine.h"
 #include "memory.h"
+#include "midi_event.h"
 #include "midi_manager.h"
 #include <string>
 
@@ -76,6 +77,16 @@ class SynthBase : public MidiManager::Listener {
     String getPatchName();
     String getFolderName();
 
+    // Offline bounces skip GUI updates and refresh the whole GUI once done.
+    // Leaving offline posts a message, so don't call it while processing.
+    void setOfflineRender(bool offline);
+    bool isOfflineRender() { return engine_.isOfflineRender(); }
+
+    // Gives every voice stutter memory when stutter turns on and frees it
+    // when it turns off. Only handing it over holds the engine lock. Offline
+    // renders always keep it, automation there never reaches this thread.
+    void setStutterMemory(bool stutter_on);
+
     mopo::control_map& getControls() { return controls_; }
     mopo::HelmEngine* getEngine() { return &engine_; }
     MidiKeyboardState* getKeyboardState() { return keyboard_state_.get(); }
@@ -93,6 +104,14 @@ class SynthBase : public MidiManager::Listener {
       mopo::mopo_float value;
     };
 
+    struct FullGuiCallback : public CallbackMessage {
+      FullGuiCallback(SynthBase* listener) : listener(listener) { }
+
+      void messageCallback() override;
+
+      SynthBase* listener;
+    };
+
   protected:
     virtual const CriticalSection& getCriticalSection() = 0;
     virtual SynthGuiInterface* getGuiInterface() = 0;
@@ -110,8 +129,12 @@ class SynthBase : public MidiManager::Listener {
     }
 
     void processAudio(AudioSampleBuffer* buffer, int channels, int samples, int offset);
-    void processMidi(MidiBuffer& buffer, int start_sample = 0, int end_sample = 0);
-    void processKeyboardEvents(MidiBuffer& buffer, int num_samples);
+
+    // Decodes the block's MIDI and the GUI keyboard's notes into one sorted
+    // list, processMidi() then plays the events before _end_sample_ in the
+    // sub-block starting at _start_sample_.
+    void decodeMidi(MidiBuffer& midi_messages, int num_samples);
+    void processMidi(int start_sample, int end_sample);
     void processControlChanges();
     void processModulationChanges();
     void updateMemoryOutput(int samples, const mopo::mopo_float* left,
@@ -121,6 +144,9 @@ class SynthBase : public MidiManager::Listener {
     mopo::HelmEngine engine_;
     std::unique_ptr<MidiManager> midi_manager_;
     std::unique_ptr<MidiKeyboardState> keyboard_state_;
+    MidiBuffer keyboard_messages_;
+    std::vector<mopo::MidiEvent> midi_events_;
+    int midi_event_index_;
 
     File active_file_;
     float output_memory_[2 * mopo::MEMORY_RESOLUTION];
@@ -27,6 +27,7 @@ SynthGuiInterface::SynthGuiInterface(SynthBase* synth, bool use_gui) : synth_(sy
                              synth->getEngine()->getMonoModulations(),
                              synth->getEngine()->getPolyModulations(),
                              synth->getKeyboardState());
+      gui_->setProfiler(&synth->getEngine()->getProfiler());
   }
 }
 
@@ -0,0 +1,114 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "animation_clock.h"
+
+#include <algorithm>
+
+void AnimationClock::Listener::startAnimating(Component* component, int frames_per_second) {
+  Holder* holder = dynamic_cast<Holder*>(component);
+  if (holder == nullptr)
+    holder = component->findParentComponentOfClass<Holder>();
+  if (holder == nullptr)
+    return;
+
+  AnimationClock* clock = holder->getAnimationClock();
+  if (clock != clock_) {
+    stopAnimating();
+    clock->addListener(this, frames_per_second);
+  }
+}
+
+void AnimationClock::Listener::stopAnimating() {
+  if (clock_)
+    clock_->removeListener(this);
+}
+
+AnimationClock::AnimationClock(Component* editor, int frames_per_second) :
+    ComponentMovementWatcher(editor), editor_(editor),
+    frames_per_second_(frames_per_second), ticking_(false) { }
+
+AnimationClock::~AnimationClock() {
+  stopTimer();
+  for (Subscription& subscription : subscriptions_) {
+    if (subscription.listener)
+      subscription.listener->clock_ = nullptr;
+  }
+}
+
+void AnimationClock::addListener(Listener* listener, int frames_per_second) {
+  if (listener->clock_ == this)
+    return;
+
+  // Start one period in so a new listener ticks on the next frame.
+  int rate = std::min(frames_per_second, frames_per_second_);
+  subscriptions_.push_back({ listener, rate, frames_per_second_ - rate });
+  listener->clock_ = this;
+  updateRunning();
+}
+
+void AnimationClock::removeListener(Listener* listener) {
+  for (Subscription& subscription : subscriptions_) {
+    if (subscription.listener == listener)
+      subscription.listener = nullptr;
+  }
+  listener->clock_ = nullptr;
+
+  if (!ticking_) {
+    removeCancelled();
+    updateRunning();
+  }
+}
+
+void AnimationClock::timerCallback() {
+  if (!editor_->isShowing()) {
+    stopTimer();
+    return;
+  }
+
+  // Listeners may subscribe or leave while ticking, so go by index.
+  ticking_ = true;
+  for (size_t i = 0; i < subscriptions_.size(); ++i) {
+    Subscription& subscription = subscriptions_[i];
+    subscription.phase += subscription.frames_per_second;
+    if (subscription.phase < frames_per_second_)
+      continue;
+
+    subscription.phase -= frames_per_second_;
+    if (subscription.listener)
+      subscription.listener->animationTick();
+  }
+  ticking_ = false;
+
+  removeCancelled();
+  updateRunning();
+}
+
+void AnimationClock::updateRunning() {
+  bool should_run = !subscriptions_.empty() && editor_->isShowing();
+  if (should_run && !isTimerRunning())
+    startTimerHz(frames_per_second_);
+  else if (!should_run && isTimerRunning())
+    stopTimer();
+}
+
+void AnimationClock::removeCancelled() {
+  subscriptions_.erase(std::remove_if(subscriptions_.begin(), subscriptions_.end(),
+                                      [](const Subscription& subscription) {
+                                        return subscription.listener == nullptr;
+                                      }),
+                       subscriptions_.end());
+}
@@ -0,0 +1,88 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef ANIMATION_CLOCK_H
+#define ANIMATION_CLOCK_H
+
+#include <JuceHeader.h>
+
+#include <vector>
+
+// One message thread timer per editor. Every animated widget is ticked from
+// it in a single batch, each at about the rate it asked for, so the message
+// thread wakes once per frame instead of once per widget. The clock stops
+// while the editor is hidden or minimized, or when nothing is subscribed.
+class AnimationClock : private Timer, private ComponentMovementWatcher {
+  public:
+    class Listener {
+      public:
+        Listener() : clock_(nullptr) { }
+        virtual ~Listener() { stopAnimating(); }
+
+        virtual void animationTick() = 0;
+
+        // Subscribes to the clock of the editor holding _component_. Does
+        // nothing until _component_ is inside one.
+        void startAnimating(Component* component, int frames_per_second);
+        void stopAnimating();
+        bool isAnimating() const { return clock_ != nullptr; }
+
+      private:
+        friend class AnimationClock;
+
+        AnimationClock* clock_;
+    };
+
+    // Editors owning a clock derive from this so their widgets can find it.
+    class Holder {
+      public:
+        virtual ~Holder() { }
+        virtual AnimationClock* getAnimationClock() = 0;
+    };
+
+    AnimationClock(Component* editor, int frames_per_second);
+    ~AnimationClock();
+
+    void addListener(Listener* listener, int frames_per_second);
+    void removeListener(Listener* listener);
+
+    int getFramesPerSecond() const { return frames_per_second_; }
+
+  private:
+    struct Subscription {
+      Listener* listener;
+      int frames_per_second;
+      int phase;
+    };
+
+    void timerCallback() override;
+    void componentMovedOrResized(bool moved, bool resized) override { }
+    void componentPeerChanged() override { updateRunning(); }
+    void componentVisibilityChanged() override { updateRunning(); }
+
+    void updateRunning();
+    void removeCancelled();
+
+    Component* editor_;
+    int frames_per_second_;
+    bool ticking_;
+    std::vector<Subscription> subscriptions_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnimationClock)
+};
+
+#endif // ANIMATION_CLOCK_H
@@ -19,20 +19,25 @@
 
 #define FRAMES_PER_SECOND 24
 
-BpmSlider::BpmSlider(String name) : SynthSlider(name) {
-  startTimerHz(FRAMES_PER_SECOND);
-}
+BpmSlider::BpmSlider(String name) : SynthSlider(name) { }
 
-void BpmSlider::timerCallback() {
+void BpmSlider::animationTick() {
   SynthGuiInterface* parent = findParentComponentOfClass<SynthGuiInterface>();
-  if (parent == nullptr || parent->getAudioDeviceManager()) {
-    stopTimer();
+  if (parent == nullptr)
     return;
-  }
-  
+
   double bpm = parent->getControlValue(getName().toStdString());
   if (getValue() != bpm)
     setValue(bpm, NotificationType::dontSendNotification);
 }
 
+void BpmSlider::parentHierarchyChanged() {
+  // Only a plugin follows the host tempo.
+  SynthGuiInterface* parent = findParentComponentOfClass<SynthGuiInterface>();
+  if (parent && parent->getAudioDeviceManager() == nullptr)
+    startAnimating(this, FRAMES_PER_SECOND);
+  else
+    stopAnimating();
 
+  SynthSlider::parentHierarchyChanged();
+}
@@ -18,13 +18,15 @@
 #define BPM_SLIDER_H
 
 #include <JuceHeader.h>
+#include "animation_clock.h"
 #include "synth_slider.h"
 
-class BpmSlider : public SynthSlider, public Timer {
+class BpmSlider : public SynthSlider, public AnimationClock::Listener {
   public:
     BpmSlider(String name);
 
-    void timerCallback() override;
+    void animationTick() override;
+    void parentHierarchyChanged() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BpmSlider)
 };
@@ -3,9 +3,10 @@
 #include "../synthesis/helm2025_engine_simd.h"
 #include "juce_gui_basics/juce_gui_basics.h"
 #include "juce_graphics/juce_graphics.h"
+#include "animation_clock.h"
 
 class EnvelopeEditorSimd : public juce::Component,
-                          public juce::Timer {
+                          public AnimationClock::Listener {
 public:
     EnvelopeEditorSimd(const juce::String& name)
         : envelopeName_(name) {
@@ -25,13 +26,13 @@ public:
         setupModeButton(linearMode_, "Linear");
         setupModeButton(exponentialMode_, "Exponential");
         setupModeButton(scurveMode_, "S-Curve");
-
-        // Démarrage du timer pour le rafraîchissement
-        startTimerHz(30);
     }
 
-    ~EnvelopeEditorSimd() override {
-        stopTimer();
+    ~EnvelopeEditorSimd() override = default;
+
+    void parentHierarchyChanged() override {
+        // Rafraîchissement par l'horloge de l'éditeur
+        startAnimating(this, 30);
     }
 
     void resized() override {
@@ -82,7 +83,7 @@ public:
         drawTimeMarkers(g);
     }
 
-    void timerCallback() override {
+    void animationTick() override {
         // Mise à jour de la visualisation en temps réel
         repaint(visualizer_);
     }
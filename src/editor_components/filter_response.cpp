@@ -16,6 +16,7 @@
 
 #include "filter_response.h"
 
+#include "biquad_filter.h"
 #include "colors.h"
 #include "midi_lookup.h"
 #include "utils.h"
@@ -27,6 +28,20 @@
 #define GRID_CELL_WIDTH 8
 #define DELTA_SLOPE_REDRAW_THRESHOLD 0.01
 #define X_REDRAW_THRESHOLD 30
+#define SAMPLE_RATE 44100
+
+// Cache key steps: a sixteenth of a semitone of cutoff, 1/1024 of the
+// resonance range and 1/256 of a blend section.
+#define CUTOFF_STEPS 16.0
+#define RESONANCE_STEPS 1024.0
+#define BLEND_STEPS 256.0
+
+namespace {
+  float gainToPercent(double gain) {
+    double gain_db = mopo::utils::gainToDb(gain);
+    return (gain_db - MIN_GAIN_DB) / (MAX_GAIN_DB - MIN_GAIN_DB);
+  }
+} // namespace
 
 FilterResponse::FilterResponse(int resolution) {
   resolution_ = resolution;
@@ -35,13 +50,10 @@ FilterResponse::FilterResponse(int resolution) {
   filter_blend_slider_ = nullptr;
   filter_shelf_slider_ = nullptr;
 
-  filter_low_.setSampleRate(44100);
-  filter_band_.setSampleRate(44100);
-  filter_high_.setSampleRate(44100);
-  filter_shelf_.setSampleRate(44100);
   style_ = mopo::StateVariableFilter::kNumStyles;
   active_ = false;
-  resetResponsePath();
+  has_response_ = false;
+  response_pending_ = false;
 
   setOpaque(true);
   setBufferedToImage(true);
@@ -85,11 +97,7 @@ void FilterResponse::resized() {
   auto *display = Desktop::getInstance().getDisplays().getPrimaryDisplay();
   jassert(display != nullptr);
 
-  float scale = display->scale;
-  background_ = Image(Image::RGB, scale * getWidth(), scale * getHeight(), true);
-  Graphics g(background_);
-  g.addTransform(AffineTransform::scale(scale, scale));
-  paintBackground(g);
+  background_ = geometry_cache_->getGrid(getWidth(), getHeight(), display->scale);
 
   computeFilterCoefficients();
   resetResponsePath();
@@ -105,40 +113,82 @@ void FilterResponse::mouseDrag(const MouseEvent& e) {
   repaint();
 }
 
-float FilterResponse::getPercentForMidiNote(float midi_note) {
-  float frequency = mopo::utils::midiNoteToFrequency(midi_note);
+GeometryCache::Curve FilterResponse::computeResponse(const GeometryCache::FilterResponseKey& key,
+                                                     const mopo::ResponseGrid& grid) {
+  mopo::StateVariableFilter::Styles style =
+      static_cast<mopo::StateVariableFilter::Styles>(key.style);
+  double cutoff = key.cutoff / CUTOFF_STEPS;
+  double resonance_percent = key.resonance / RESONANCE_STEPS;
+  double blend = key.blend / BLEND_STEPS;
+
+  double frequency = mopo::utils::midiNoteToFrequency(cutoff);
+  double resonance = mopo::utils::magnitudeToQ(resonance_percent);
+  double decibels = mopo::utils::interpolate(MIN_GAIN_DB, MAX_GAIN_DB, resonance_percent);
+  double gain = mopo::utils::dbToGain(decibels);
 
-  float response = 0.0f;
-  if (style_ == mopo::StateVariableFilter::kShelf)
-    response = fabs(filter_shelf_.getAmplitudeResponse(frequency));
-  else {
-    float blend = filter_blend_slider_->getValue();
-    float low_pass_amount = mopo::utils::clamp(1.0 - blend, 0.0, 1.0);
-    float band_pass_amount = mopo::utils::clamp(1.0 - fabs(blend - 1.0), 0.0, 1.0);
-    float high_pass_amount = mopo::utils::clamp(blend - 1.0, 0.0, 1.0);
+  if (style == mopo::StateVariableFilter::k24dB) {
+    resonance = sqrt(resonance);
+    gain = sqrt(gain);
+  }
 
-    response = low_pass_amount * filter_low_.getAmplitudeResponse(frequency) +
-               band_pass_amount * filter_band_.getAmplitudeResponse(frequency) +
-               high_pass_amount * filter_high_.getAmplitudeResponse(frequency);
+  int points = grid.size();
+  GeometryCache::Curve curve(points);
+  std::vector<mopo::mopo_float> magnitudes(points);
 
-    response = fabs(response);
-    if (style_ == mopo::StateVariableFilter::k24dB)
-      response *= response;
+  if (style == mopo::StateVariableFilter::kShelf) {
+    mopo::BiquadFilter::Type type = mopo::BiquadFilter::kLowShelf;
+    if (key.shelf == mopo::StateVariableFilter::kBandShelf)
+      type = mopo::BiquadFilter::kBandShelf;
+    else if (key.shelf == mopo::StateVariableFilter::kHighShelf)
+      type = mopo::BiquadFilter::kHighShelf;
+
+    mopo::BiquadFilter::Coefficients shelf =
+        mopo::BiquadFilter::computeCoefficients(type, frequency, 1.0, gain, SAMPLE_RATE);
+    mopo::BiquadFilter::getMagnitudes(shelf, grid, magnitudes.data());
+    for (int i = 0; i < points; ++i)
+      curve[i] = gainToPercent(magnitudes[i]);
+    return curve;
   }
 
-  float gain_db = mopo::utils::gainToDb(response);
-  return (gain_db - MIN_GAIN_DB) / (MAX_GAIN_DB - MIN_GAIN_DB);
+  mopo::BiquadFilter::Coefficients low = mopo::BiquadFilter::computeCoefficients(
+      mopo::BiquadFilter::kLowPass, frequency, resonance, 1.0, SAMPLE_RATE);
+  mopo::BiquadFilter::Coefficients band = mopo::BiquadFilter::computeCoefficients(
+      mopo::BiquadFilter::kBandPass, frequency, resonance, 1.0, SAMPLE_RATE);
+  mopo::BiquadFilter::Coefficients high = mopo::BiquadFilter::computeCoefficients(
+      mopo::BiquadFilter::kHighPass, frequency, resonance, 1.0, SAMPLE_RATE);
+
+  double low_pass_amount = mopo::utils::clamp(1.0 - blend, 0.0, 1.0);
+  double band_pass_amount = mopo::utils::clamp(1.0 - fabs(blend - 1.0), 0.0, 1.0);
+  double high_pass_amount = mopo::utils::clamp(blend - 1.0, 0.0, 1.0);
+
+  // The blend mixes the magnitudes, not the complex responses.
+  std::vector<mopo::mopo_float> band_magnitudes(points);
+  std::vector<mopo::mopo_float> high_magnitudes(points);
+  mopo::BiquadFilter::getMagnitudes(low, grid, magnitudes.data());
+  mopo::BiquadFilter::getMagnitudes(band, grid, band_magnitudes.data());
+  mopo::BiquadFilter::getMagnitudes(high, grid, high_magnitudes.data());
+
+  for (int i = 0; i < points; ++i) {
+    double response = low_pass_amount * magnitudes[i] +
+                      band_pass_amount * band_magnitudes[i] +
+                      high_pass_amount * high_magnitudes[i];
+
+    if (style == mopo::StateVariableFilter::k24dB)
+      response *= response;
+    curve[i] = gainToPercent(response);
+  }
+  return curve;
 }
 
 void FilterResponse::resetResponsePath() {
   static const int wrap_size = 10;
 
-  if (cutoff_slider_ == nullptr)
+  if (!has_response_)
     return;
 
   filter_response_path_.clear();
   filter_response_path_.startNewSubPath(-wrap_size, getHeight() + wrap_size);
-  float start_percent = getPercentForMidiNote(0.0);
+  float start_percent = response_[0];
   float last_y = getHeight() * (1.0f - start_percent);
   float last_slope = 0.0f;
   float last_x = 0.0f;
@@ -147,8 +197,7 @@ void FilterResponse::resetResponsePath() {
 
   for (int i = 0; i < resolution_; ++i) {
     float t = (1.0f * i) / (resolution_ - 1);
-    float midi_note = cutoff_slider_->proportionOfLengthToValue(t);
-    float percent = getPercentForMidiNote(midi_note);
+    float percent = response_[i + 1];
 
     float new_x = getWidth() * t;
     float new_y = getHeight() * (1.0f - percent);
@@ -162,47 +211,81 @@ void FilterResponse::resetResponsePath() {
     }
   }
 
-  float end_percent = getPercentForMidiNote(cutoff_slider_->getMaximum());
+  float end_percent = response_[resolution_ + 1];
 
   filter_response_path_.lineTo(getWidth() + wrap_size, getHeight() * (1.0f - end_percent));
   filter_response_path_.lineTo(getWidth() + wrap_size, getHeight() + wrap_size);
 }
 
+GeometryCache::FilterResponseKey FilterResponse::getResponseKey() {
+  GeometryCache::FilterResponseKey key = { style_, 0, 0, 0, 0, resolution_ };
+  key.cutoff = roundToInt(CUTOFF_STEPS * cutoff_slider_->getValue());
+
+  if (style_ == mopo::StateVariableFilter::kShelf)
+    key.shelf = static_cast<int>(filter_shelf_slider_->getValue());
+  else
+    key.blend = roundToInt(BLEND_STEPS * filter_blend_slider_->getValue());
+
+  // The shelves use resonance as their gain.
+  key.resonance = roundToInt(RESONANCE_STEPS * resonance_slider_->getValue());
+  return key;
+}
+
 void FilterResponse::computeFilterCoefficients() {
   if (cutoff_slider_ == nullptr || resonance_slider_ == nullptr ||
       filter_blend_slider_ == nullptr || filter_shelf_slider_ == nullptr) {
     return;
   }
 
-  mopo::StateVariableFilter::Shelves shelf = static_cast<mopo::StateVariableFilter::Shelves>(
-      static_cast<int>(filter_shelf_slider_->getValue()));
-  double frequency = mopo::utils::midiNoteToFrequency(cutoff_slider_->getValue());
-  double resonance = mopo::utils::magnitudeToQ(resonance_slider_->getValue());
-  double decibels = mopo::utils::interpolate(MIN_GAIN_DB, MAX_GAIN_DB,
-                                             resonance_slider_->getValue());
-  double gain = mopo::utils::dbToGain(decibels);
+  GeometryCache::FilterResponseKey key = getResponseKey();
+  if (has_response_ && key == response_key_)
+    return;
 
-  if (style_ == mopo::StateVariableFilter::k24dB) {
-    resonance = sqrt(resonance);
-    gain = sqrt(gain);
-  }
-  
-  if (style_ == mopo::StateVariableFilter::kShelf) {
-    mopo::BiquadFilter::Type type = mopo::BiquadFilter::kLowShelf;
-    if (shelf == mopo::StateVariableFilter::kBandShelf)
-      type = mopo::BiquadFilter::kBandShelf;
-    else if (shelf == mopo::StateVariableFilter::kHighShelf)
-      type = mopo::BiquadFilter::kHighShelf;
-    filter_shelf_.computeCoefficients(type, frequency, 1.0, gain);
+  response_key_ = key;
+  if (geometry_cache_->findFilterResponse(key, &response_))
+    has_response_ = true;
+  else if (has_response_) {
+    // Keep showing the last response until the new one is ready.
+    requestResponse();
+    return;
   }
   else {
-    filter_low_.computeCoefficients(mopo::BiquadFilter::kLowPass, frequency, resonance, 1.0);
-    filter_band_.computeCoefficients(mopo::BiquadFilter::kBandPass, frequency, resonance, 1.0);
-    filter_high_.computeCoefficients(mopo::BiquadFilter::kHighPass, frequency, resonance, 1.0);
+    response_ = computeResponse(key, *response_grid_);
+    geometry_cache_->storeFilterResponse(key, response_);
+    has_response_ = true;
   }
   resetResponsePath();
 }
 
+void FilterResponse::requestResponse() {
+  if (response_pending_)
+    return;
+
+  response_pending_ = true;
+  GeometryCache::FilterResponseKey key = response_key_;
+  std::shared_ptr<const mopo::ResponseGrid> grid = response_grid_;
+  Component::SafePointer<FilterResponse> self(this);
+
+  geometry_cache_->computeFilterResponse(key,
+      [key, grid] { return computeResponse(key, *grid); },
+      [self] {
+        if (self != nullptr)
+          self->responseComputed();
+      });
+}
+
+void FilterResponse::responseComputed() {
+  response_pending_ = false;
+
+  // The settings may have moved on while the response was computed.
+  if (geometry_cache_->findFilterResponse(response_key_, &response_)) {
+    resetResponsePath();
+    repaint();
+  }
+  else
+    requestResponse();
+}
+
 void FilterResponse::setFilterSettingsFromPosition(Point<int> position) {
   if (cutoff_slider_) {
     double percent = mopo::utils::clamp((1.0 * position.x) / getWidth(), 0.0, 1.0);
@@ -232,10 +315,21 @@ void FilterResponse::setResonanceSlider(SynthSlider* slider) {
 void FilterResponse::setCutoffSlider(SynthSlider* slider) {
   cutoff_slider_ = slider;
   cutoff_slider_->addSliderListener(this);
+
+  std::vector<mopo::mopo_float> frequencies(resolution_ + 2);
+  frequencies[0] = mopo::utils::midiNoteToFrequency(0.0);
+  for (int i = 0; i < resolution_; ++i) {
+    float t = (1.0f * i) / (resolution_ - 1);
+    float midi_note = cutoff_slider_->proportionOfLengthToValue(t);
+    frequencies[i + 1] = mopo::utils::midiNoteToFrequency(midi_note);
+  }
+  frequencies[resolution_ + 1] = mopo::utils::midiNoteToFrequency(cutoff_slider_->getMaximum());
+  response_grid_ = std::make_shared<mopo::ResponseGrid>(frequencies.data(), frequencies.size(),
+                                                        SAMPLE_RATE);
+
   computeFilterCoefficients();
   repaint();
 }
-
 void FilterResponse::setFilterBlendSlider(SynthSlider* slider) {
   filter_blend_slider_ = slider;
   filter_blend_slider_->addSliderListener(this);
@@ -19,8 +19,12 @@
 #define FILTER_RESPONSE_H
 
 #include <JuceHeader.h>
+
+#include <memory>
+
 #include "helm2025_common.h"
-#include "biquad_filter.h"
+#include "frequency_response.h"
+#include "geometry_cache.h"
 #include "state_variable_filter.h"
 #include "synth_slider.h"
 
@@ -29,7 +33,11 @@ class FilterResponse : public Component, SynthSlider::SliderListener {
     FilterResponse(int resolution);
     ~FilterResponse();
 
-    float getPercentForMidiNote(float midi_note);
+    // Heights, as fractions of the graph, of the response of the filter _key_
+    // describes at each frequency of _grid_. Safe to call from any thread.
+    static GeometryCache::Curve computeResponse(const GeometryCache::FilterResponseKey& key,
+                                                const mopo::ResponseGrid& grid);
+
     void resetResponsePath();
     void computeFilterCoefficients();
     void setFilterSettingsFromPosition(Point<int> position);
@@ -50,15 +58,24 @@ class FilterResponse : public Component, SynthSlider::SliderListener {
     void setActive(bool active);
 
   private:
+    GeometryCache::FilterResponseKey getResponseKey();
+    void requestResponse();
+    void responseComputed();
+
     Path filter_response_path_;
     int resolution_;
     mopo::StateVariableFilter::Styles style_;
     bool active_;
 
-    mopo::BiquadFilter filter_low_;
-    mopo::BiquadFilter filter_band_;
-    mopo::BiquadFilter filter_high_;
-    mopo::BiquadFilter filter_shelf_;
+    // Frequencies the response is drawn at: the lowest note, one per point
+    // across the cutoff slider, then the highest. Shared with the cache
+    // thread while it computes.
+    std::shared_ptr<const mopo::ResponseGrid> response_grid_;
+    GeometryCache::FilterResponseKey response_key_;
+    GeometryCache::Curve response_;
+    bool has_response_;
+    bool response_pending_;
+    SharedResourcePointer<GeometryCache> geometry_cache_;
 
     SynthSlider* filter_blend_slider_;
     SynthSlider* filter_shelf_slider_;
@@ -0,0 +1,132 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "geometry_cache.h"
+
+#include <tuple>
+
+#define MAX_FILTER_RESPONSES 256
+#define MAX_GRIDS 8
+#define GRID_CELL_WIDTH 8
+#define JOB_TIMEOUT_MS 1000
+
+namespace {
+  std::tuple<int, int, int, int, int, int> keyFields(const GeometryCache::FilterResponseKey& key) {
+    return std::make_tuple(key.style, key.shelf, key.cutoff,
+                           key.resonance, key.blend, key.resolution);
+  }
+} // namespace
+
+bool GeometryCache::FilterResponseKey::operator<(const FilterResponseKey& other) const {
+  return keyFields(*this) < keyFields(other);
+}
+
+bool GeometryCache::FilterResponseKey::operator==(const FilterResponseKey& other) const {
+  return keyFields(*this) == keyFields(other);
+}
+
+GeometryCache::GeometryCache() : thread_pool_(1) { }
+
+GeometryCache::~GeometryCache() {
+  thread_pool_.removeAllJobs(true, JOB_TIMEOUT_MS);
+}
+
+Path GeometryCache::getWaveShape(mopo::Wave::Type type, int resolution) {
+  if (type == mopo::Wave::kSampleAndHold || type == mopo::Wave::kSampleAndGlide ||
+      type == mopo::Wave::kWhiteNoise) {
+    return Path();
+  }
+
+  std::pair<int, int> key(type, resolution);
+  auto found = wave_shapes_.find(key);
+  if (found != wave_shapes_.end())
+    return found->second;
+
+  Path& shape = wave_shapes_[key];
+  shape.startNewSubPath(0.0f, 0.0f);
+  for (int i = 1; i < resolution - 1; ++i) {
+    float t = (1.0f * i) / resolution;
+    shape.lineTo(t, mopo::Wave::wave(type, t));
+  }
+  shape.lineTo(1.0f, 0.0f);
+  return shape;
+}
+
+bool GeometryCache::findFilterResponse(const FilterResponseKey& key, Curve* curve) {
+  ScopedLock lock(response_lock_);
+  auto found = response_lookup_.find(key);
+  if (found == response_lookup_.end())
+    return false;
+
+  // Most recently used entries stay at the front.
+  responses_.splice(responses_.begin(), responses_, found->second);
+  *curve = found->second->second;
+  return true;
+}
+
+void GeometryCache::storeFilterResponse(const FilterResponseKey& key, const Curve& curve) {
+  ScopedLock lock(response_lock_);
+  auto found = response_lookup_.find(key);
+  if (found != response_lookup_.end()) {
+    found->second->second = curve;
+    responses_.splice(responses_.begin(), responses_, found->second);
+    return;
+  }
+
+  responses_.emplace_front(key, curve);
+  response_lookup_[key] = responses_.begin();
+
+  if (responses_.size() > MAX_FILTER_RESPONSES) {
+    response_lookup_.erase(responses_.back().first);
+    responses_.pop_back();
+  }
+}
+
+void GeometryCache::computeFilterResponse(const FilterResponseKey& key,
+                                          std::function<Curve()> compute,
+                                          std::function<void()> done) {
+  thread_pool_.addJob([this, key, compute, done] {
+    storeFilterResponse(key, compute());
+    MessageManager::callAsync(done);
+  });
+}
+
+Image GeometryCache::getGrid(int width, int height, float scale) {
+  for (auto grid = grids_.begin(); grid != grids_.end(); ++grid) {
+    if (grid->width == width && grid->height == height && grid->scale == scale) {
+      grids_.splice(grids_.begin(), grids_, grid);
+      return grid->image;
+    }
+  }
+
+  Image image(Image::RGB, scale * width, scale * height, true);
+  {
+    Graphics g(image);
+    g.addTransform(AffineTransform::scale(scale, scale));
+
+    g.fillAll(Colour(0xff424242));
+    g.setColour(Colour(0xff4a4a4a));
+    for (int x = 0; x < width; x += GRID_CELL_WIDTH)
+      g.drawLine(x, 0, x, height);
+    for (int y = 0; y < height; y += GRID_CELL_WIDTH)
+      g.drawLine(0, y, width, y);
+  }
+
+  grids_.push_front({ width, height, scale, image });
+  if (grids_.size() > MAX_GRIDS)
+    grids_.pop_back();
+  return image;
+}
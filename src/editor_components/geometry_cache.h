@@ -0,0 +1,101 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef GEOMETRY_CACHE_H
+#define GEOMETRY_CACHE_H
+
+#include <JuceHeader.h>
+
+#include <functional>
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "wave.h"
+
+// Shapes and rasters the graph views rebuild on every slider move or
+// resize, shared by every open editor. Hold it through a
+// SharedResourcePointer so it and its thread go away with the last editor.
+//
+// Wave shapes are kept in unit coordinates so one entry serves every size
+// and amplitude. Filter responses are kept per rounded setting and can be
+// computed off the message thread. Grids are kept per size.
+class GeometryCache {
+  public:
+    // Filter settings in steps finer than a view can show. Fields a style
+    // ignores should be left at zero so those settings share an entry.
+    struct FilterResponseKey {
+      int style;
+      int shelf;
+      int cutoff;
+      int resonance;
+      int blend;
+      int resolution;
+
+      bool operator<(const FilterResponseKey& other) const;
+      bool operator==(const FilterResponseKey& other) const;
+      bool operator!=(const FilterResponseKey& other) const { return !(*this == other); }
+    };
+
+    typedef std::vector<float> Curve;
+
+    GeometryCache();
+    ~GeometryCache();
+
+    // One cycle of _type_ from (0, 0) to (1, 0), with the wave value as y.
+    // Empty for the random waves, which have no fixed shape.
+    Path getWaveShape(mopo::Wave::Type type, int resolution);
+
+    // Fills _curve_ and returns true when _key_ is cached. Any thread.
+    bool findFilterResponse(const FilterResponseKey& key, Curve* curve);
+    void storeFilterResponse(const FilterResponseKey& key, const Curve& curve);
+
+    // Stores the result of _compute_ under _key_ from the cache thread, then
+    // calls _done_ on the message thread.
+    void computeFilterResponse(const FilterResponseKey& key, std::function<Curve()> compute,
+                               std::function<void()> done);
+
+    // Graph background grid for a view of _width_ by _height_ at _scale_.
+    // The image is shared, draw it rather than drawing into it.
+    Image getGrid(int width, int height, float scale);
+
+  private:
+    typedef std::pair<FilterResponseKey, Curve> ResponseEntry;
+
+    struct Grid {
+      int width;
+      int height;
+      float scale;
+      Image image;
+    };
+
+    std::map<std::pair<int, int>, Path> wave_shapes_;
+
+    CriticalSection response_lock_;
+    std::list<ResponseEntry> responses_;
+    std::map<FilterResponseKey, std::list<ResponseEntry>::iterator> response_lookup_;
+
+    std::list<Grid> grids_;
+
+    // Last so its jobs finish before anything they touch goes away.
+    ThreadPool thread_pool_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GeometryCache)
+};
+
+#endif // GEOMETRY_CACHE_H
@@ -21,7 +21,6 @@
 #define TIME_TO_STAY_VISIBLE 2000.0
 
 GlobalToolTip::GlobalToolTip() {
-  startTimerHz(FRAMES_PER_SECOND);
   time_updated_ = 0;
   setInterceptsMouseClicks(false, false);
 }
@@ -50,7 +49,11 @@ void GlobalToolTip::setText(String parameter, String value) {
   setVisible(true);
 }
 
-void GlobalToolTip::timerCallback() {
+void GlobalToolTip::parentHierarchyChanged() {
+  startAnimating(this, FRAMES_PER_SECOND);
+}
+
+void GlobalToolTip::animationTick() {
   if (shown_parameter_text_ != parameter_text_ || shown_value_text_ != value_text_) {
     shown_value_text_ = value_text_;
     shown_parameter_text_ = parameter_text_;
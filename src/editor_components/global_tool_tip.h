@@ -19,14 +19,16 @@
 #define GLOBAL_TOOL_TIP_H
 
 #include <JuceHeader.h>
+#include "animation_clock.h"
 
-class GlobalToolTip  : public Component, public Timer {
+class GlobalToolTip  : public Component, public AnimationClock::Listener {
   public:
     GlobalToolTip();
     ~GlobalToolTip();
 
     void setText(String parameter, String value);
-    void timerCallback() override;
+    void animationTick() override;
+    void parentHierarchyChanged() override;
     void paint(Graphics& g) override;
 
   private:
@@ -129,7 +129,7 @@ void GraphicalStepSequencer::mouseDrag(const MouseEvent& e) {
   last_edit_position_ = e.getPosition();
 }
 
-void GraphicalStepSequencer::timerCallback() {
+void GraphicalStepSequencer::animationTick() {
   if (step_generator_output_) {
     int new_step = step_generator_output_->buffer[0];
     if (new_step != last_step_) {
@@ -240,13 +240,13 @@ void GraphicalStepSequencer::showRealtimeFeedback(bool show_feedback) {
   if (show_feedback) {
     if (step_generator_output_ == nullptr) {
       SynthGuiInterface* parent = findParentComponentOfClass<SynthGuiInterface>();
-      startTimerHz(FRAMES_PER_SECOND);
+      startAnimating(this, FRAMES_PER_SECOND);
       if (parent)
         step_generator_output_ = parent->getSynth()->getModSource(getName().toStdString());
     }
   }
   else {
-    stopTimer();
+    stopAnimating();
     step_generator_output_ = nullptr;
     last_step_ = -1;
     repaint();
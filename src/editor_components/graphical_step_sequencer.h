@@ -19,17 +19,19 @@
 #define GRAPHICAL_STEP_SEQUENCER_H
 
 #include <JuceHeader.h>
+#include "animation_clock.h"
 #include "mopo.h"
 #include "synth_slider.h"
 #include <vector>
 
-class GraphicalStepSequencer : public Component, public Timer, public Slider::Listener,
+class GraphicalStepSequencer : public Component, public AnimationClock::Listener,
+                               public Slider::Listener,
                                public SynthSlider::SliderListener {
   public:
     GraphicalStepSequencer();
     ~GraphicalStepSequencer();
 
-    void timerCallback() override;
+    void animationTick() override;
     void setNumStepsSlider(SynthSlider* num_steps_slider);
     void setStepSliders(std::vector<Slider*> sliders);
     void sliderValueChanged(Slider* moved_slider) override;
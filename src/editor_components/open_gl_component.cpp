@@ -29,6 +29,22 @@
 
 using namespace ::juce::gl;
 
+void OpenGLComponent::renderTimed(OpenGLContext& open_gl_context, bool animate) {
+  double start = Time::getMillisecondCounterHiRes();
+  render(open_gl_context, animate);
+  double microseconds = 1000.0 * (Time::getMillisecondCounterHiRes() - start);
+
+  num_frames_ = num_frames_ + 1;
+  total_frame_microseconds_ = total_frame_microseconds_ + microseconds;
+  if (microseconds > max_frame_microseconds_)
+    max_frame_microseconds_ = microseconds;
+}
+
+double OpenGLComponent::getAverageFrameMicroseconds() const {
+  int num_frames = num_frames_;
+  return num_frames ? total_frame_microseconds_ / num_frames : 0.0;
+}
+
 void OpenGLComponent::setViewPort(OpenGLContext& open_gl_context) {
   float scale = open_gl_context.getRenderingScale();
   FullInterface* parent = findParentComponentOfClass<FullInterface>();
@@ -20,11 +20,31 @@
 
 #include <JuceHeader.h>
 
+#include <atomic>
+
+// Frames are only rendered when a component asks for one, either by being
+// marked dirty or by finding new telemetry when it is polled.
 class OpenGLComponent : public Component {
   public:
-    OpenGLComponent() { }
+    OpenGLComponent() : dirty_(true), num_frames_(0),
+                        total_frame_microseconds_(0.0), max_frame_microseconds_(0.0) { }
     virtual ~OpenGLComponent() { }
 
+    // Asks for a new frame. Safe from any thread.
+    void markDirty() { dirty_ = true; }
+    bool takeDirty() { return dirty_.exchange(false); }
+
+    // Polled on the message thread before each frame while animating.
+    // Returns true when the values this component draws have changed.
+    virtual bool pollTelemetry() { return false; }
+
+    // Runs render() and counts the time it took against this component.
+    void renderTimed(OpenGLContext& open_gl_context, bool animate);
+
+    int getNumFrames() const { return num_frames_; }
+    double getAverageFrameMicroseconds() const;
+    double getMaxFrameMicroseconds() const { return max_frame_microseconds_; }
+
     void paint(Graphics& g) override { }
 
     virtual void init(OpenGLContext& open_gl_context) = 0;
@@ -35,6 +55,12 @@ class OpenGLComponent : public Component {
   protected:
     void setViewPort(OpenGLContext& open_gl_context);
 
+  private:
+    std::atomic<bool> dirty_;
+    std::atomic<int> num_frames_;
+    std::atomic<double> total_frame_microseconds_;
+    std::atomic<double> max_frame_microseconds_;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OpenGLComponent)
 };
 
@@ -56,6 +56,8 @@ OpenGLEnvelope::OpenGLEnvelope() {
   release_slider_ = nullptr;
   envelope_amp_ = nullptr;
   envelope_phase_ = nullptr;
+  last_polled_phase_ = 0.0f;
+  last_polled_amp_ = 0.0f;
 
   position_vertices_ = new float[16] {
     0.0f, 1.0f, 0.0f, 1.0f,
@@ -150,6 +152,21 @@ void OpenGLEnvelope::paintBackground() {
                 marker_radius, marker_radius);
 
   background_.updateBackgroundImage(background_image_);
+  markDirty();
+}
+
+bool OpenGLEnvelope::pollTelemetry() {
+  if (envelope_phase_ == nullptr || envelope_amp_ == nullptr)
+    return false;
+
+  float phase = envelope_phase_->buffer[0];
+  float amp = envelope_amp_->buffer[0];
+  if (phase == last_polled_phase_ && amp == last_polled_amp_)
+    return false;
+
+  last_polled_phase_ = phase;
+  last_polled_amp_ = amp;
+  return true;
 }
 
 void OpenGLEnvelope::paintPositionImage() {
@@ -48,6 +48,7 @@ class OpenGLEnvelope : public OpenGLComponent, public SynthSlider::SliderListene
     void render(OpenGLContext& open_gl_context, bool animate = true) override;
     void destroy(OpenGLContext& open_gl_context) override;
     void paintBackground(Graphics& g) override { }
+    bool pollTelemetry() override;
 
   private:
     void drawPosition(OpenGLContext& open_gl_context);
@@ -74,6 +75,8 @@ class OpenGLEnvelope : public OpenGLComponent, public SynthSlider::SliderListene
 
     mopo::Output* envelope_phase_;
     mopo::Output* envelope_amp_;
+    float last_polled_phase_;
+    float last_polled_amp_;
 
     SynthSlider* attack_slider_;
     SynthSlider* decay_slider_;
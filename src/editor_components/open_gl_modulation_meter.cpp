@@ -35,42 +35,22 @@ using namespace ::juce::gl;
 
 OpenGLModulationMeter::OpenGLModulationMeter(const mopo::Output* mono_total,
                                              const mopo::Output* poly_total,
-                                             const SynthSlider* slider,
-                                             float* vertices) :
-        mono_total_(mono_total), poly_total_(poly_total), destination_(slider), vertices_(vertices),
-        current_value_(0.0), knob_percent_(0.0), mod_percent_(0.0),
+                                             const SynthSlider* slider) :
+        mono_total_(mono_total), poly_total_(poly_total), destination_(slider),
+        instance_changed_(true), current_value_(0.0), knob_percent_(0.0), mod_percent_(0.0),
         full_radius_(0.0), outer_radius_(0.0),
         left_(0.0f), right_(0.0), top_(0.0), bottom_(0.0) {
-  static const float initial_rotary_vertices[24] {
-    0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f,
-    0.0f, 0.0f, -1.0f, -1.0f, 0.0f, 0.0f,
-    0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f,
-    0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f
-  };
-
-  static const float initial_horizontal_vertices[24] {
-    0.0f, 0.0f, 0.0f, 0.0f, -10.0f, 10.0f,
-    0.0f, 0.0f, 0.0f, 0.0f, -10.0f, 10.0f,
-    0.0f, 0.0f, 0.0f, 0.0f, -10.0f, 10.0f,
-    0.0f, 0.0f, 0.0f, 0.0f, -10.0f, 10.0f
-  };
-
-  static const float initial_vertical_vertices[24] {
-    0.0f, 0.0f, 0.0f, 0.0f, -10.0f, 10.0f,
-    0.0f, 0.0f, 0.0f, 0.0f, -10.0f, 10.0f,
-    0.0f, 0.0f, 0.0f, 0.0f, -10.0f, 10.0f,
-    0.0f, 0.0f, 0.0f, 0.0f, -10.0f, 10.0f
-  };
-
   rotary_ = destination_->isRotary() &&
             &destination_->getLookAndFeel() != TextLookAndFeel::instance();
 
+  // Rotary meters draw an arc over the quad, linear ones fill all of it.
+  memset(instance_, 0, kFloatsPerInstance * sizeof(float));
   if (rotary_)
-    memcpy(vertices_, initial_rotary_vertices, sizeof(initial_rotary_vertices));
-  else if (destination_->isHorizontal())
-    memcpy(vertices_, initial_horizontal_vertices, sizeof(initial_horizontal_vertices));
-  else
-    memcpy(vertices_, initial_vertical_vertices, sizeof(initial_vertical_vertices));
+    instance_[kCoordinateScale] = 1.0f;
+  else {
+    instance_[kRangeStart] = -10.0f;
+    instance_[kRangeEnd] = 10.0f;
+  }
 
   setInterceptsMouseClicks(false, false);
   updateDrawing();
@@ -130,23 +110,39 @@ void OpenGLModulationMeter::setVertices() {
 
 void OpenGLModulationMeter::collapseVertices() {
   left_ = right_ = top_ = bottom_= 0.0f;
-  vertices_[0] = vertices_[6] = 0.0f;
-  vertices_[12] = vertices_[18] = 0.0f;
-  vertices_[1] = vertices_[19] = 0.0f;
-  vertices_[7] = vertices_[13] = 0.0f;
+  instance_[kLeft] = instance_[kRight] = 0.0f;
+  instance_[kBottom] = instance_[kTop] = 0.0f;
+  instance_changed_ = true;
 }
 
-void OpenGLModulationMeter::updateDrawing() {
-  if (mono_total_) {
-    current_value_ = mono_total_->buffer[0];
-    if (poly_total_)
-      current_value_ += poly_total_->buffer[0];
-  }
+double OpenGLModulationMeter::getCurrentValue() const {
+  if (mono_total_ == nullptr)
+    return current_value_;
 
+  double value = mono_total_->buffer[0];
+  if (poly_total_)
+    value += poly_total_->buffer[0];
+  return value;
+}
+
+void OpenGLModulationMeter::getPercents(double value,
+                                        double* mod_percent, double* knob_percent) const {
   double range = destination_->getMaximum() - destination_->getMinimum();
-  double value = (current_value_ - destination_->getMinimum()) / range;
-  double new_mod_percent = mopo::utils::clamp(value , 0.0, 1.0);
-  double new_knob_percent = (destination_->getValue() - destination_->getMinimum()) / range;
+  *mod_percent = mopo::utils::clamp((value - destination_->getMinimum()) / range, 0.0, 1.0);
+  *knob_percent = (destination_->getValue() - destination_->getMinimum()) / range;
+}
+
+bool OpenGLModulationMeter::hasNewValue() const {
+  double new_mod_percent, new_knob_percent;
+  getPercents(getCurrentValue(), &new_mod_percent, &new_knob_percent);
+  return new_mod_percent != mod_percent_ || new_knob_percent != knob_percent_;
+}
+
+void OpenGLModulationMeter::updateDrawing() {
+  current_value_ = getCurrentValue();
+
+  double new_mod_percent, new_knob_percent;
+  getPercents(current_value_, &new_mod_percent, &new_knob_percent);
 
   if (new_mod_percent != mod_percent_ || new_knob_percent != knob_percent_) {
     mod_percent_ = new_mod_percent;
@@ -161,25 +157,18 @@ void OpenGLModulationMeter::updateDrawing() {
       float min_radians = mopo::utils::interpolate(-angle, angle, min_percent);
       float max_radians = mopo::utils::interpolate(-angle, angle, max_percent);
 
-      vertices_[0] = vertices_[6] = left_;
-      vertices_[12] = vertices_[18] = right_;
-      vertices_[1] = vertices_[19] = top_;
-      vertices_[7] = vertices_[13] = bottom_;
-
-      for (int i = 0; i < 4; ++i) {
-        vertices_[4 + 6 * i] = min_radians;
-        vertices_[5 + 6 * i] = max_radians;
-      }
+      instance_[kLeft] = left_;
+      instance_[kRight] = right_;
+      instance_[kTop] = top_;
+      instance_[kBottom] = bottom_;
+      instance_[kRangeStart] = min_radians;
+      instance_[kRangeEnd] = max_radians;
     }
     else if (destination_->isHorizontal()) {
-      float start = mopo::utils::interpolate(left_, right_, min_percent);
-      vertices_[0] = vertices_[6] = start;
-
-      float end = mopo::utils::interpolate(left_, right_, max_percent);
-      vertices_[12] = vertices_[18] = end;
-
-      vertices_[1] = vertices_[19] = top_;
-      vertices_[7] = vertices_[13] = bottom_;
+      instance_[kLeft] = mopo::utils::interpolate(left_, right_, min_percent);
+      instance_[kRight] = mopo::utils::interpolate(left_, right_, max_percent);
+      instance_[kTop] = top_;
+      instance_[kBottom] = bottom_;
     }
     else if (&destination_->getLookAndFeel() == TextLookAndFeel::instance()) {
       float start = bottom_;
@@ -191,22 +180,18 @@ void OpenGLModulationMeter::updateDrawing() {
       else
         start = mopo::utils::interpolate(top_, bottom_, -diff_percent);
 
-      vertices_[7] = vertices_[13] = start;
-      vertices_[1] = vertices_[19] = end;
-
-      vertices_[0] = vertices_[6] = left_;
-      vertices_[12] = vertices_[18] = right_;
+      instance_[kBottom] = start;
+      instance_[kTop] = end;
+      instance_[kLeft] = left_;
+      instance_[kRight] = right_;
     }
     else {
-      float start = mopo::utils::interpolate(bottom_, top_, min_percent);
-      vertices_[7] = vertices_[13] = start;
-
-      float end = mopo::utils::interpolate(bottom_, top_, max_percent);
-      vertices_[1] = vertices_[19] = end;
-
-      vertices_[0] = vertices_[6] = left_;
-      vertices_[12] = vertices_[18] = right_;
+      instance_[kBottom] = mopo::utils::interpolate(bottom_, top_, min_percent);
+      instance_[kTop] = mopo::utils::interpolate(bottom_, top_, max_percent);
+      instance_[kLeft] = left_;
+      instance_[kRight] = right_;
     }
+    instance_changed_ = true;
   }
 }
 
@@ -18,16 +18,32 @@
 #define OPEN_GL_MODULATION_METER_H
 
 #include <JuceHeader.h>
+
+#include <atomic>
+
 #include "open_gl_component.h"
 #include "processor.h"
 #include "synth_slider.h"
 
+// Each meter is one instance of a shared quad. It keeps its bounds and arc
+// laid out as InstanceAttribute and flags when they change.
 class OpenGLModulationMeter : public Component {
   public:
+    enum InstanceAttribute {
+      kLeft,
+      kRight,
+      kBottom,
+      kTop,
+      kRangeStart,
+      kRangeEnd,
+      kCoordinateScale,
+      kPadding,
+      kFloatsPerInstance
+    };
+
     OpenGLModulationMeter(const mopo::Output* mono_total,
                           const mopo::Output* poly_total,
-                          const SynthSlider* slider,
-                          float* vertices);
+                          const SynthSlider* slider);
     virtual ~OpenGLModulationMeter();
 
     void paint(Graphics& g) override;
@@ -36,17 +52,28 @@ class OpenGLModulationMeter : public Component {
 
     void updateDrawing();
 
+    // True when updateDrawing() would move the meter.
+    bool hasNewValue() const;
+
     bool isModulated() { return modulated_; }
     void setModulated(bool modulated) { modulated_ = modulated; }
 
+    const float* getInstance() const { return instance_; }
+
+    // True once after the instance attributes were rewritten.
+    bool takeInstanceChanged() { return instance_changed_.exchange(false); }
+
   private:
     void setVertices();
     void collapseVertices();
+    double getCurrentValue() const;
+    void getPercents(double value, double* mod_percent, double* knob_percent) const;
 
     const mopo::Output* mono_total_;
     const mopo::Output* poly_total_;
     const SynthSlider* destination_;
-    float* vertices_;
+    float instance_[kFloatsPerInstance];
+    std::atomic<bool> instance_changed_;
 
     double current_value_;
     double knob_percent_;
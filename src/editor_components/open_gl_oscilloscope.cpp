@@ -28,16 +28,21 @@
 
 using namespace ::juce::gl;
 
+#include <cstring>
+
 #include "helm2025_common.h"
 #include "shaders.h"
 #include "utils.h"
 
 #define RESOLUTION 256
 #define GRID_CELL_WIDTH 8
+#define MEMORY_SNAPSHOT_SIZE (mopo::MEMORY_RESOLUTION + 1)
 
 OpenGLOscilloscope::OpenGLOscilloscope() : output_memory_(nullptr) {
   line_data_ = new float[2 * RESOLUTION];
   line_indices_ = new int[2 * RESOLUTION];
+  last_memory_ = new float[MEMORY_SNAPSHOT_SIZE];
+  std::memset(last_memory_, 0, MEMORY_SNAPSHOT_SIZE * sizeof(float));
 
   for (int i = 0; i < RESOLUTION; ++i) {
     float t = i / (RESOLUTION - 1.0f);
@@ -54,6 +59,19 @@ OpenGLOscilloscope::OpenGLOscilloscope() : output_memory_(nullptr) {
 OpenGLOscilloscope::~OpenGLOscilloscope() {
   delete[] line_data_;
   delete[] line_indices_;
+  delete[] last_memory_;
+}
+
+bool OpenGLOscilloscope::pollTelemetry() {
+  if (output_memory_ == nullptr)
+    return false;
+
+  size_t size = MEMORY_SNAPSHOT_SIZE * sizeof(float);
+  if (std::memcmp(last_memory_, output_memory_, size) == 0)
+    return false;
+
+  std::memcpy(last_memory_, output_memory_, size);
+  return true;
 }
 
 void OpenGLOscilloscope::paintBackground(Graphics& g) {
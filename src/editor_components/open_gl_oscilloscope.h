@@ -34,6 +34,7 @@ class OpenGLOscilloscope : public OpenGLComponent {
     void render(OpenGLContext& open_gl_context, bool animate = true) override;
     void destroy(OpenGLContext& open_gl_context) override;
     void paintBackground(Graphics& g) override;
+    bool pollTelemetry() override;
 
   private:
     void drawLines(OpenGLContext& open_gl_context);
@@ -42,6 +43,7 @@ class OpenGLOscilloscope : public OpenGLComponent {
     std::unique_ptr<OpenGLShaderProgram::Attribute> position_;
 
     const float* output_memory_;
+    float* last_memory_;
     float* line_data_;
     int* line_indices_;
     GLuint line_buffer_;
@@ -37,6 +37,7 @@ using namespace ::juce::gl;
 
 OpenGLPeakMeter::OpenGLPeakMeter(bool left) : left_(left) {
   peak_output_ = nullptr;
+  last_peak_ = 0.0f;
   position_vertices_ = new float[8] {
     -1.0f, 1.0f,
     -1.0f, -1.0f,
@@ -102,6 +103,18 @@ void OpenGLPeakMeter::updateVertices() {
   position_vertices_[6] = position;
 }
 
+bool OpenGLPeakMeter::pollTelemetry() {
+  if (peak_output_ == nullptr)
+    return false;
+
+  float peak = peak_output_->buffer[left_ ? 0 : 1];
+  if (peak == last_peak_)
+    return false;
+
+  last_peak_ = peak;
+  return true;
+}
+
 void OpenGLPeakMeter::render(OpenGLContext& open_gl_context, bool animate) {
   MOPO_ASSERT(glGetError() == GL_NO_ERROR);
 
@@ -34,11 +34,13 @@ class OpenGLPeakMeter : public OpenGLComponent {
     void render(OpenGLContext& open_gl_context, bool animate = true) override;
     void destroy(OpenGLContext& open_gl_context) override;
     void paintBackground(Graphics& g) override;
+    bool pollTelemetry() override;
 
   private:
     void updateVertices();
 
     mopo::Output* peak_output_;
+    float last_peak_;
 
     std::unique_ptr<OpenGLShaderProgram> shader_;
     std::unique_ptr<OpenGLShaderProgram::Attribute> position_;
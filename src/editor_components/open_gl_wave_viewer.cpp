@@ -33,7 +33,6 @@ using namespace ::juce::gl;
 #include "utils.h"
 #include "../synthesis/synced_random.h"
 
-#define GRID_CELL_WIDTH 8
 #include "../synthesis/helm2025_lfo.h"
 #include "../synthesis/synced_random.h"
 #define PADDING 5.0f
@@ -47,6 +46,8 @@ OpenGLWaveViewer::OpenGLWaveViewer(int resolution) {
   resolution_ = resolution;
   wave_phase_ = nullptr;
   wave_amp_ = nullptr;
+  last_polled_phase_ = 0.0f;
+  last_polled_amp_ = 0.0f;
   last_phase_ = 0.0f;
 
   // synced_randoms_ sera généré dynamiquement selon le LFO
@@ -84,13 +85,8 @@ void OpenGLWaveViewer::paintBackground() {
   Graphics g(background_image_);
   g.addTransform(AffineTransform::scale(scale, scale));
 
-  // Fond neutre
-  g.fillAll(Colour(0xff424242));
-  g.setColour(Colour(0xff4a4a4a));
-  for (int x = 0; x < getWidth(); x += GRID_CELL_WIDTH)
-    g.drawLine(x, 0, x, getHeight());
-  for (int y = 0; y < getHeight(); y += GRID_CELL_WIDTH)
-    g.drawLine(0, y, getWidth(), y);
+  Image grid = geometry_cache_->getGrid(getWidth(), getHeight(), scale);
+  g.drawImage(grid, 0, 0, getWidth(), getHeight(), 0, 0, grid.getWidth(), grid.getHeight());
 
   g.setColour(Colors::graph_fill);
   g.fillPath(wave_path_);
@@ -101,6 +97,21 @@ void OpenGLWaveViewer::paintBackground() {
   g.strokePath(wave_path_, stroke);
 
   background_.updateBackgroundImage(background_image_);
+  markDirty();
+}
+
+bool OpenGLWaveViewer::pollTelemetry() {
+  if (wave_phase_ == nullptr || wave_amp_ == nullptr)
+    return false;
+
+  float phase = wave_phase_->buffer[0];
+  float amp = wave_amp_->buffer[0];
+  if (phase == last_polled_phase_ && amp == last_polled_amp_)
+    return false;
+
+  last_polled_phase_ = phase;
+  last_polled_amp_ = amp;
+  return true;
 }
 
 void OpenGLWaveViewer::paintPositionImage() {
@@ -295,16 +306,14 @@ void OpenGLWaveViewer::resetWavePath() {
     paintBackground();
     return;
   } else {
-    // All deterministic waveforms (original + new ones)
-    wave_path_.startNewSubPath(0, getHeight() / 2.0f);
-    for (int i = 1; i < resolution_ - 1; ++i) {
-      float t = (1.0f * i) / resolution_;
-      float val = amplitude * mopo::Wave::wave(type, t);
-      wave_path_.lineTo(t * draw_width, padding + draw_height * ((1.0f - val) / 2.0f));
-    }
+    // All deterministic waveforms (original + new ones), stretched from
+    // the cached unit shape.
+    wave_path_ = geometry_cache_->getWaveShape(type, resolution_);
+    wave_path_.applyTransform(AffineTransform(draw_width, 0.0f, 0.0f,
+                                              0.0f, -0.5f * draw_height * amplitude,
+                                              padding + 0.5f * draw_height));
   }
 
-  wave_path_.lineTo(getWidth(), getHeight() / 2.0f);
   paintBackground();
 }
 
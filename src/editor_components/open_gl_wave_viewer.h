@@ -20,6 +20,7 @@
 
 #include <JuceHeader.h>
 
+#include "geometry_cache.h"
 #include "helm2025_common.h"
 #include "open_gl_background.h"
 #include "open_gl_component.h"
@@ -44,6 +45,7 @@ class OpenGLWaveViewer : public OpenGLComponent, public SynthSlider::SliderListe
     void render(OpenGLContext& open_gl_context, bool animate = true) override;
     void destroy(OpenGLContext& open_gl_context) override;
     void paintBackground(Graphics& g) override { }
+    bool pollTelemetry() override;
 
   private:
     void drawPosition(OpenGLContext& open_gl_context);
@@ -57,6 +59,8 @@ class OpenGLWaveViewer : public OpenGLComponent, public SynthSlider::SliderListe
     SynthSlider* amplitude_slider_;
     mopo::Output* wave_phase_;
     mopo::Output* wave_amp_;
+    float last_polled_phase_;
+    float last_polled_amp_;
     Path wave_path_;
     int resolution_;
   // Pour la synchronisation des randoms avec le LFO
@@ -66,6 +70,7 @@ class OpenGLWaveViewer : public OpenGLComponent, public SynthSlider::SliderListe
     float last_phase_;  // Pour détecter les resets de cycle
 
     OpenGLBackground background_;
+    SharedResourcePointer<GeometryCache> geometry_cache_;
   
     Image position_image_;
     Image background_image_;
@@ -86,16 +86,16 @@ void Oscilloscope::resetWavePath() {
   wave_path_.lineTo(getWidth() - PADDING_X, getHeight() / 2.0f);
 }
 
-void Oscilloscope::timerCallback() {
+void Oscilloscope::animationTick() {
   resetWavePath();
   repaint();
 }
 
 void Oscilloscope::showRealtimeFeedback(bool show_feedback) {
   if (show_feedback)
-    startTimerHz(FRAMES_PER_SECOND);
+    startAnimating(this, FRAMES_PER_SECOND);
   else {
-    stopTimer();
+    stopAnimating();
     wave_path_.clear();
     repaint();
   }
@@ -19,14 +19,15 @@
 #define OSCILLOSCOPE_H
 
 #include <JuceHeader.h>
+#include "animation_clock.h"
 #include "memory.h"
 
-class Oscilloscope : public Component, public Timer {
+class Oscilloscope : public Component, public AnimationClock::Listener {
   public:
     Oscilloscope();
     ~Oscilloscope();
 
-    void timerCallback() override;
+    void animationTick() override;
     void paint(Graphics& g) override;
     void paintBackground(Graphics& g);
     void resized() override;
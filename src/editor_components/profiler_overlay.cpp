@@ -0,0 +1,96 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "profiler_overlay.h"
+#include "fonts.h"
+#include "full_interface.h"
+#include "open_gl_component.h"
+
+#define FRAMES_PER_SECOND 4
+#define LINE_HEIGHT 14.0f
+
+ProfilerOverlay::ProfilerOverlay(const mopo::Profiler* profiler) : profiler_(profiler) {
+  setInterceptsMouseClicks(false, false);
+}
+
+ProfilerOverlay::~ProfilerOverlay() { }
+
+void ProfilerOverlay::paint(Graphics& g) {
+  g.setColour(Colour(0xcc000000));
+  g.fillRect(0.0f, 0.0f, 1.0f * getWidth(), LINE_HEIGHT * (lines_.size() + 1));
+
+  g.setColour(Colour(0xffffffff));
+  g.setFont(Fonts::instance()->monospace().withPointHeight(0.8f * LINE_HEIGHT));
+  for (int i = 0; i < lines_.size(); ++i) {
+    g.drawText(lines_[i], LINE_HEIGHT / 2.0f, LINE_HEIGHT * (i + 0.5f),
+               getWidth() - LINE_HEIGHT, LINE_HEIGHT, Justification::centredLeft, false);
+  }
+}
+
+void ProfilerOverlay::parentHierarchyChanged() {
+  startAnimating(this, FRAMES_PER_SECOND);
+}
+
+void ProfilerOverlay::animationTick() {
+  StringArray lines;
+  lines.add("blocks " + String(profiler_->blocks()) +
+            "  late " + String(profiler_->deadlineMisses()) +
+            "  voices " + String(profiler_->activeVoices()) +
+            " (max " + String(profiler_->maxActiveVoices()) + ")");
+  lines.add("memory  voice " + String(profiler_->voiceBytes() / 1024) + " KB" +
+            "  instance " + String(profiler_->instanceBytes() / 1024) + " KB");
+
+  FullInterface* full_interface = findParentComponentOfClass<FullInterface>();
+  if (full_interface) {
+    std::vector<OpenGLComponent*> components;
+    full_interface->getOpenGLComponents(&components);
+
+    OpenGLComponent* slowest = nullptr;
+    for (OpenGLComponent* component : components) {
+      if (slowest == nullptr ||
+          component->getAverageFrameMicroseconds() > slowest->getAverageFrameMicroseconds()) {
+        slowest = component;
+      }
+    }
+
+    String render_line = "frames " + String(full_interface->getNumFramesRendered());
+    if (slowest) {
+      String name = slowest->getName().isEmpty() ? "unnamed" : slowest->getName();
+      render_line += "  slowest " + name +
+                     " " + String(slowest->getAverageFrameMicroseconds(), 1) + " us" +
+                     " (max " + String(slowest->getMaxFrameMicroseconds(), 1) + ")";
+    }
+    lines.add(render_line);
+  }
+
+  lines.add("section        mean us     p99 us     max us");
+
+  for (int i = 0; i < profiler_->numSections(); ++i) {
+    const mopo::ProfileSection* section = profiler_->getSection(i);
+    long long count = section->count();
+    double mean = count ? section->totalNanoseconds() / (1000.0 * count) : 0.0;
+    lines.add(String(section->name()).paddedRight(' ', 12) +
+              String(mean, 2).paddedLeft(' ', 11) +
+              String(section->percentileNanoseconds(0.99) / 1000.0, 2).paddedLeft(' ', 11) +
+              String(section->maxNanoseconds() / 1000.0, 2).paddedLeft(' ', 11));
+  }
+
+  if (lines != lines_) {
+    lines_ = lines;
+    repaint();
+  }
+}
@@ -0,0 +1,45 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+#ifndef PROFILER_OVERLAY_H
+#define PROFILER_OVERLAY_H
+
+#include <JuceHeader.h>
+
+#include "animation_clock.h"
+#include "profiler.h"
+
+// Debug readout of the engine profiler, drawn over the interface in
+// MOPO_PROFILE builds.
+class ProfilerOverlay : public Component, public AnimationClock::Listener {
+  public:
+    ProfilerOverlay(const mopo::Profiler* profiler);
+    ~ProfilerOverlay();
+
+    void animationTick() override;
+    void parentHierarchyChanged() override;
+    void paint(Graphics& g) override;
+
+  private:
+    const mopo::Profiler* profiler_;
+    StringArray lines_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProfilerOverlay)
+};
+
+#endif // PROFILER_OVERLAY_H
@@ -19,7 +19,6 @@
 #include "colors.h"
 #include "synth_gui_interface.h"
 
-#define GRID_CELL_WIDTH 8
 #define FRAMES_PER_SECOND 30
 #define PADDING 5.0f
 #define MARKER_WIDTH 6.0f
@@ -68,13 +67,7 @@ void WaveViewer::paint(juce::Graphics &g) {
 void WaveViewer::paintBackground(Graphics& g) {
   static const DropShadow shadow(Colour(0xbb000000), 5, Point<int>(0, 0));
 
-  g.fillAll(Colour(0xff424242));
-
-  g.setColour(Colour(0xff4a4a4a));
-  for (int x = 0; x < getWidth(); x += GRID_CELL_WIDTH)
-    g.drawLine(x, 0, x, getHeight());
-  for (int y = 0; y < getHeight(); y += GRID_CELL_WIDTH)
-    g.drawLine(0, y, getWidth(), y);
+  g.drawImage(grid_, 0, 0, getWidth(), getHeight(), 0, 0, grid_.getWidth(), grid_.getHeight());
 
   shadow.drawForPath(g, wave_path_);
 
@@ -97,6 +90,7 @@ void WaveViewer::resized() {
 
   float scale = display->scale;
   background_ = Image(Image::RGB, scale * getWidth(), scale * getHeight(), true);
+  grid_ = geometry_cache_->getGrid(getWidth(), getHeight(), scale);
   resetWavePath();
 }
 
@@ -116,7 +110,7 @@ void WaveViewer::mouseDown(const MouseEvent& e) {
   }
 }
 
-void WaveViewer::timerCallback() {
+void WaveViewer::animationTick() {
   if (wave_phase_) {
     float phase = wave_phase_->buffer[0];
     amp_ = wave_amp_->buffer[0];
@@ -207,14 +201,11 @@ void WaveViewer::resetWavePath() {
   mopo::Wave::Type type = static_cast<mopo::Wave::Type>(static_cast<int>(wave_slider_->getValue()));
 
   if (type != mopo::Wave::kSampleAndHold && type != mopo::Wave::kSampleAndGlide && type != mopo::Wave::kWhiteNoise) {
-    wave_path_.startNewSubPath(0, getHeight() / 2.0f);
-    for (int i = 1; i < resolution_ - 1; ++i) {
-      float t = (1.0f * i) / resolution_;
-      float val = amplitude * mopo::Wave::wave(type, t);
-      wave_path_.lineTo(t * draw_width, padding + draw_height * ((1.0f - val) / 2.0f));
-    }
-
-    wave_path_.lineTo(getWidth(), getHeight() / 2.0f);
+    // The cached unit shape only needs stretching to this view and amplitude.
+    wave_path_ = geometry_cache_->getWaveShape(type, resolution_);
+    wave_path_.applyTransform(AffineTransform(draw_width, 0.0f, 0.0f,
+                                              0.0f, -0.5f * draw_height * amplitude,
+                                              padding + 0.5f * draw_height));
   }
   else if (type == mopo::Wave::kWhiteNoise || type == mopo::Wave::kSampleAndHold)
     drawRandom();
@@ -243,13 +234,13 @@ void WaveViewer::showRealtimeFeedback(bool show_feedback) {
       if (parent) {
         wave_amp_ = parent->getSynth()->getModSource(getName().toStdString());
         wave_phase_ = parent->getSynth()->getModSource(getName().toStdString() + "_phase");
-        startTimerHz(FRAMES_PER_SECOND);
+        startAnimating(this, FRAMES_PER_SECOND);
       }
     }
   }
   else {
     wave_phase_ = nullptr;
-    stopTimer();
+    stopAnimating();
     repaint();
   }
 }
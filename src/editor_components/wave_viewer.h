@@ -19,15 +19,17 @@
 #define WAVE_VIEWER_H
 
 #include <JuceHeader.h>
+#include "animation_clock.h"
+#include "geometry_cache.h"
 #include "wave.h"
 #include "helm2025_common.h"
 
-class WaveViewer : public Component, public Timer, public Slider::Listener {
+class WaveViewer : public Component, public AnimationClock::Listener, public Slider::Listener {
   public:
     WaveViewer(int resolution);
     ~WaveViewer();
 
-    void timerCallback() override;
+    void animationTick() override;
     void setWaveSlider(Slider* slider);
     void setAmplitudeSlider(Slider* slider);
     void drawRandom();
@@ -56,6 +58,8 @@ class WaveViewer : public Component, public Timer, public Slider::Listener {
     float phase_;
     float amp_;
     Image background_;
+    Image grid_;
+    SharedResourcePointer<GeometryCache> geometry_cache_;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveViewer)
 };
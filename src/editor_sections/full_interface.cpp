@@ -25,6 +25,10 @@
 #include "text_look_and_feel.h"
 
 #define TOP_HEIGHT 64
+#define FRAMES_PER_SECOND 60
+#define PROFILER_OVERLAY_WIDTH 380
+#define PROFILER_OVERLAY_HEIGHT 200
+#define BACKGROUND_SETTLE_MS 150
 
 #ifndef PAY_NAG
   #define PAY_NAG 1
@@ -33,9 +37,13 @@
 FullInterface::FullInterface(mopo::control_map controls, mopo::output_map modulation_sources,
                              mopo::output_map mono_modulations,
                              mopo::output_map poly_modulations,
-                             MidiKeyboardState* keyboard_state) : SynthSection("full_interface") {
+                             MidiKeyboardState* keyboard_state) :
+    SynthSection("full_interface"), animation_clock_(this, FRAMES_PER_SECOND) {
   animate_ = true;
-  open_gl_context.setContinuousRepainting(true);
+  background_pending_ = false;
+  last_resize_ms_ = 0;
+  num_frames_rendered_ = 0;
+  open_gl_context.setContinuousRepainting(false);
   open_gl_context.setRenderer(this);
   open_gl_context.attachTo(*getTopLevelComponent());
   open_gl_context.setOpenGLVersionRequired(OpenGLContext::openGL3_2);
@@ -104,9 +112,11 @@ FullInterface::FullInterface(mopo::control_map controls, mopo::output_map modula
   delete_section_->toFront(false);
 
   setOpaque(false);
+  animation_clock_.addListener(this, FRAMES_PER_SECOND);
 }
 
 FullInterface::~FullInterface() {
+  stopAnimating();
   open_gl_context.detach();
   open_gl_context.setRenderer(nullptr);
   about_section_ = nullptr;
@@ -243,9 +253,22 @@ void FullInterface::resized() {
   SynthSection::resized();
   modulation_manager_->setBounds(getBounds());
 
+  if (profiler_overlay_) {
+    profiler_overlay_->setBounds(synthesis_interface_->getX() + padding, synthesis_interface_->getY(),
+                                 PROFILER_OVERLAY_WIDTH, PROFILER_OVERLAY_HEIGHT);
+  }
+
   checkBackground();
 }
 
+void FullInterface::setProfiler(const mopo::Profiler* profiler) {
+#if MOPO_PROFILE
+  addAndMakeVisible((profiler_overlay_ = std::make_unique<ProfilerOverlay>(profiler)).get());
+  profiler_overlay_->toFront(false);
+  resized();
+#endif
+}
+
 void FullInterface::setOutputMemory(const float* output_memory) {
   oscilloscope_->setOutputMemory(output_memory);
 }
@@ -285,10 +308,21 @@ void FullInterface::buttonClicked(Button* clicked_button) {
 void FullInterface::animate(bool animate) {
   animate_ = animate;
   SynthSection::animate(animate);
-  open_gl_context.setContinuousRepainting(animate);
+  open_gl_context.triggerRepaint();
   repaint();
 }
 
+void FullInterface::animationTick() {
+  if (background_pending_ &&
+      Time::getMillisecondCounter() - last_resize_ms_ >= BACKGROUND_SETTLE_MS) {
+    background_pending_ = false;
+    redrawBackground();
+  }
+
+  if (pollOpenGLComponents(animate_))
+    open_gl_context.triggerRepaint();
+}
+
 void FullInterface::checkBackground() {
   auto *display = Desktop::getInstance().getDisplays().getPrimaryDisplay();
   jassert(display != nullptr);
@@ -297,13 +331,32 @@ void FullInterface::checkBackground() {
   int width = scale * getWidth();
   int height = scale * getHeight();
 
-  if (background_image_.getWidth() != width || background_image_.getHeight() != height) {
-    background_image_ = Image(Image::ARGB, width, height, true);
-    Graphics g(background_image_);
-    g.addTransform(AffineTransform::scale(scale, scale));
-    paintBackground(g);
-    background_.updateBackgroundImage(background_image_);
+  if (background_image_.getWidth() == width && background_image_.getHeight() == height) {
+    background_pending_ = false;
+    return;
   }
+
+  // While the editor is dragged to a new size the old background is
+  // stretched, only the size it settles on gets painted.
+  if (background_image_.isValid()) {
+    background_pending_ = true;
+    last_resize_ms_ = Time::getMillisecondCounter();
+  }
+  else
+    redrawBackground();
+}
+
+void FullInterface::redrawBackground() {
+  auto *display = Desktop::getInstance().getDisplays().getPrimaryDisplay();
+  jassert(display != nullptr);
+
+  float scale = display->scale;
+  background_image_ = Image(Image::ARGB, scale * getWidth(), scale * getHeight(), true);
+  Graphics g(background_image_);
+  g.addTransform(AffineTransform::scale(scale, scale));
+  paintBackground(g);
+  background_.updateBackgroundImage(background_image_);
+  open_gl_context.triggerRepaint();
 }
 
 void FullInterface::newOpenGLContextCreated() {
@@ -314,6 +367,7 @@ void FullInterface::newOpenGLContextCreated() {
 void FullInterface::renderOpenGL() {
   background_.render(open_gl_context);
   renderOpenGLComponents(open_gl_context, animate_);
+  num_frames_rendered_ = num_frames_rendered_ + 1;
 }
 
 void FullInterface::openGLContextClosing() {
@@ -20,7 +20,10 @@
 
 #include <JuceHeader.h>
 
+#include <atomic>
+
 #include "about_section.h"
+#include "animation_clock.h"
 #include "arp_section.h"
 #include "bpm_section.h"
 #include "contribute_section.h"
@@ -33,11 +36,13 @@
 #include "overlay.h"
 #include "patch_browser.h"
 #include "patch_selector.h"
+#include "profiler_overlay.h"
 #include "synthesis_interface.h"
 #include "synth_section.h"
 #include "update_check_section.h"
 
-class FullInterface : public SynthSection, public OpenGLRenderer {
+class FullInterface : public SynthSection, public OpenGLRenderer,
+                      public AnimationClock::Holder, public AnimationClock::Listener {
   public:
     FullInterface(mopo::control_map controls, mopo::output_map modulation_sources,
                   mopo::output_map mono_modulations, mopo::output_map poly_modulations,
@@ -46,6 +51,9 @@ class FullInterface : public SynthSection, public OpenGLRenderer {
 
     void setOutputMemory(const float* output_memory);
 
+    // Shows the profiler readout when built with MOPO_PROFILE.
+    void setProfiler(const mopo::Profiler* profiler);
+
     void createModulationSliders(mopo::output_map modulation_sources,
                                  mopo::output_map mono_modulations,
                                  mopo::output_map poly_modulations);
@@ -59,6 +67,12 @@ class FullInterface : public SynthSection, public OpenGLRenderer {
     void animate(bool animate = true) override;
     void checkBackground();
 
+    // Renders a frame when any OpenGL component asked for one since the
+    // last tick, so an idle editor draws nothing.
+    void animationTick() override;
+    AnimationClock* getAnimationClock() override { return &animation_clock_; }
+    int getNumFramesRendered() const { return num_frames_rendered_; }
+
     void newOpenGLContextCreated() override;
     void renderOpenGL() override;
     void openGLContextClosing() override;
@@ -70,6 +84,8 @@ class FullInterface : public SynthSection, public OpenGLRenderer {
     void externalPatchLoaded(File patch) { patch_browser_->externalPatchLoaded(patch); }
 
   private:
+    void redrawBackground();
+
     std::map<std::string, SynthSlider*> slider_lookup_;
     std::map<std::string, Button*> button_lookup_;
     std::unique_ptr<OpenGLModulationManager> modulation_manager_;
@@ -90,10 +106,15 @@ class FullInterface : public SynthSection, public OpenGLRenderer {
     std::unique_ptr<SaveSection> save_section_;
     std::unique_ptr<DeleteSection> delete_section_;
     std::unique_ptr<VolumeSection> volume_section_;
+    std::unique_ptr<ProfilerOverlay> profiler_overlay_;
 
+    AnimationClock animation_clock_;
     bool animate_;
+    std::atomic<int> num_frames_rendered_;
     OpenGLContext open_gl_context;
     Image background_image_;
+    bool background_pending_;
+    uint32 last_resize_ms_;
     OpenGLBackground background_;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FullInterface)
@@ -29,9 +29,22 @@
 
 using namespace ::juce::gl;
 
-#define FLOATS_PER_METER 24
+#define FLOATS_PER_INSTANCE OpenGLModulationMeter::kFloatsPerInstance
 #define INDICES_PER_METER 6
-#define POINTS_PER_METER 4
+
+namespace {
+  const float quad_corners[8] {
+    -1.0f, 1.0f,
+    -1.0f, -1.0f,
+    1.0f, -1.0f,
+    1.0f, 1.0f
+  };
+
+  const int quad_triangles[INDICES_PER_METER] {
+    0, 1, 2,
+    2, 3, 0
+  };
+} // namespace
 
 OpenGLModulationManager::OpenGLModulationManager(
     mopo::output_map modulation_sources,
@@ -39,11 +52,6 @@ OpenGLModulationManager::OpenGLModulationManager(
     std::map<std::string, SynthSlider*> sliders,
     mopo::output_map mono_modulations,
     mopo::output_map poly_modulations) {
-  static const int quad_triangles[6] {
-    0, 1, 2,
-    2, 3, 0
-  };
-
   modulation_buttons_ = modulation_buttons;
   modulation_sources_ = modulation_sources;
   setInterceptsMouseClicks(false, true);
@@ -71,29 +79,22 @@ OpenGLModulationManager::OpenGLModulationManager(
   }
 
   slider_model_lookup_ = sliders;
-  vertices_ = new float[FLOATS_PER_METER * slider_model_lookup_.size()];
-  triangles_ = new int[INDICES_PER_METER * slider_model_lookup_.size()];
+  instances_ = new float[FLOATS_PER_INSTANCE * slider_model_lookup_.size()];
+  shown_meters_.reserve(slider_model_lookup_.size());
+  instance_meters_.reserve(slider_model_lookup_.size());
 
-  int i = 0;
   for (auto& slider : slider_model_lookup_) {
     std::string name = slider.first;
     const mopo::Output* mono_total = mono_modulations[name];
     const mopo::Output* poly_total = poly_modulations[name];
 
-    float* meter_vertices = vertices_ + (i * FLOATS_PER_METER);
-    memset(meter_vertices, 0, FLOATS_PER_METER * sizeof(float));
-
-    int* meter_triangles = triangles_ + (i * INDICES_PER_METER);
-    for (int t = 0; t < INDICES_PER_METER; ++t)
-      meter_triangles[t] = i * POINTS_PER_METER + quad_triangles[t];
-
     slider.second->addSliderListener(this);
 
     // Create modulation meter.
     if (mono_total) {
       std::string name = slider.second->getName().toStdString();
       OpenGLModulationMeter* meter = new OpenGLModulationMeter(mono_total, poly_total,
-                                                               slider.second, meter_vertices);
+                                                               slider.second);
       addChildComponent(meter);
       meter_lookup_[name] = meter;
       meter->setName(name);
@@ -112,8 +113,6 @@ OpenGLModulationManager::OpenGLModulationManager(
 
     slider_lookup_[name] = mod_slider;
     owned_sliders_.push_back(mod_slider);
-
-    ++i;
   }
 
   addAndMakeVisible(polyphonic_destinations_.get());
@@ -129,6 +128,7 @@ OpenGLModulationManager::~OpenGLModulationManager() {
     delete overlay.second;
   for (Slider* slider : owned_sliders_)
     delete slider;
+  delete[] instances_;
 }
 
 void OpenGLModulationManager::paint(Graphics& g) {
@@ -169,6 +169,7 @@ void OpenGLModulationManager::resized() {
                               model->getWidth(), model->getHeight());
   }
 
+  markDirty();
   OpenGLComponent::resized();
 }
 
@@ -201,23 +202,23 @@ void OpenGLModulationManager::modulationDisconnected(mopo::ModulationConnection*
 
   meter_lookup_[connection->destination]->setModulated(!last);
   meter_lookup_[connection->destination]->setVisible(!last);
+  markDirty();
 }
 
 void OpenGLModulationManager::init(OpenGLContext& open_gl_context) {
   open_gl_context.extensions.glGenBuffers(1, &vertex_buffer_);
   open_gl_context.extensions.glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-
-  int num_meters = slider_model_lookup_.size();
-  GLsizeiptr vert_size = static_cast<GLsizeiptr>(num_meters * FLOATS_PER_METER * sizeof(float));
-  open_gl_context.extensions.glBufferData(GL_ARRAY_BUFFER, vert_size,
-                                          vertices_, GL_STATIC_DRAW);
+  open_gl_context.extensions.glBufferData(GL_ARRAY_BUFFER, sizeof(quad_corners),
+                                          quad_corners, GL_STATIC_DRAW);
 
   open_gl_context.extensions.glGenBuffers(1, &triangle_buffer_);
   open_gl_context.extensions.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangle_buffer_);
+  open_gl_context.extensions.glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quad_triangles),
+                                          quad_triangles, GL_STATIC_DRAW);
 
-  GLsizeiptr tri_size = static_cast<GLsizeiptr>(num_meters * INDICES_PER_METER * sizeof(int));
-  open_gl_context.extensions.glBufferData(GL_ELEMENT_ARRAY_BUFFER, tri_size,
-                                          triangles_, GL_STATIC_DRAW);
+  // A new context has an empty instance buffer, repack on the next frame.
+  open_gl_context.extensions.glGenBuffers(1, &instance_buffer_);
+  instance_meters_.clear();
 
   const char* vertex_shader = Shaders::getShader(Shaders::kModulationVertex);
   const char* fragment_shader = Shaders::getShader(Shaders::kModulationFragment);
@@ -228,23 +229,41 @@ void OpenGLModulationManager::init(OpenGLContext& open_gl_context) {
       shader_->addFragmentShader(OpenGLHelpers::translateFragmentShaderToV3(fragment_shader)) &&
       shader_->link()) {
     shader_->use();
-    position_ = std::make_unique<OpenGLShaderProgram::Attribute>(*shader_, "position");
-    coordinates_ = std::make_unique<OpenGLShaderProgram::Attribute>(*shader_, "coordinates");
+    corner_ = std::make_unique<OpenGLShaderProgram::Attribute>(*shader_, "corner");
+    bounds_ = std::make_unique<OpenGLShaderProgram::Attribute>(*shader_, "bounds");
     range_ = std::make_unique<OpenGLShaderProgram::Attribute>(*shader_, "range");
+    coordinate_scale_ = std::make_unique<OpenGLShaderProgram::Attribute>(*shader_,
+                                                                         "coordinate_scale");
     radius_uniform_ = std::make_unique<OpenGLShaderProgram::Uniform>(*shader_, "radius");
   }
 }
 
+bool OpenGLModulationManager::pollTelemetry() {
+  for (auto& meter : meter_lookup_) {
+    bool show = meter.second->isModulated() && slider_model_lookup_[meter.first]->isVisible();
+    if (show && meter.second->hasNewValue())
+      return true;
+  }
+  return false;
+}
+
 void OpenGLModulationManager::render(OpenGLContext& open_gl_context, bool animate) {
   if (!animate)
     return;
 
+  shown_meters_.clear();
   for (auto& meter : meter_lookup_) {
     bool show = meter.second->isModulated() && slider_model_lookup_[meter.first]->isVisible();
-    if (show)
+    if (show) {
       meter.second->updateDrawing();
+      shown_meters_.push_back(meter.second);
+    }
   }
 
+  uploadInstances(open_gl_context);
+  if (instance_meters_.empty())
+    return;
+
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   setViewPort(open_gl_context);
@@ -253,57 +272,108 @@ void OpenGLModulationManager::render(OpenGLContext& open_gl_context, bool animat
   radius_uniform_->set(0.9f);
 
   open_gl_context.extensions.glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+  if (corner_ != nullptr) {
+    open_gl_context.extensions.glVertexAttribPointer(corner_->attributeID, 2, GL_FLOAT,
+                                                     GL_FALSE, 2 * sizeof(float), 0);
+    open_gl_context.extensions.glEnableVertexAttribArray(corner_->attributeID);
+  }
+
+  open_gl_context.extensions.glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+  enableInstanceAttribute(open_gl_context, bounds_.get(), 4, OpenGLModulationMeter::kLeft);
+  enableInstanceAttribute(open_gl_context, range_.get(), 2, OpenGLModulationMeter::kRangeStart);
+  enableInstanceAttribute(open_gl_context, coordinate_scale_.get(), 1,
+                          OpenGLModulationMeter::kCoordinateScale);
 
-  int num_meters = slider_model_lookup_.size();
-  GLsizeiptr vert_size = static_cast<GLsizeiptr>(num_meters * FLOATS_PER_METER * sizeof(float));
-  open_gl_context.extensions.glBufferData(GL_ARRAY_BUFFER, vert_size,
-                                          vertices_, GL_STATIC_DRAW);
   open_gl_context.extensions.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangle_buffer_);
+  glDrawElementsInstanced(GL_TRIANGLES, INDICES_PER_METER, GL_UNSIGNED_INT, 0,
+                          static_cast<GLsizei>(instance_meters_.size()));
 
-  if (position_ != nullptr) {
-    open_gl_context.extensions.glVertexAttribPointer(position_->attributeID, 2, GL_FLOAT,
-                                                     GL_FALSE, 6 * sizeof(float), 0);
-    open_gl_context.extensions.glEnableVertexAttribArray(position_->attributeID);
-  }
+  if (corner_ != nullptr)
+    open_gl_context.extensions.glDisableVertexAttribArray(corner_->attributeID);
 
-  if (coordinates_ != nullptr) {
-    open_gl_context.extensions.glVertexAttribPointer(coordinates_->attributeID, 2, GL_FLOAT,
-                                                     GL_FALSE, 6 * sizeof(float),
-                                                     (GLvoid*)(2 * sizeof(float)));
-    open_gl_context.extensions.glEnableVertexAttribArray(coordinates_->attributeID);
-  }
+  disableInstanceAttribute(open_gl_context, bounds_.get());
+  disableInstanceAttribute(open_gl_context, range_.get());
+  disableInstanceAttribute(open_gl_context, coordinate_scale_.get());
 
-  if (range_ != nullptr) {
-    open_gl_context.extensions.glVertexAttribPointer(range_->attributeID, 2, GL_FLOAT,
-                                                     GL_FALSE, 6 * sizeof(float),
-                                                     (GLvoid*)(4 * sizeof(float)));
-    open_gl_context.extensions.glEnableVertexAttribArray(range_->attributeID);
+  open_gl_context.extensions.glBindBuffer(GL_ARRAY_BUFFER, 0);
+  open_gl_context.extensions.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void OpenGLModulationManager::uploadInstances(OpenGLContext& open_gl_context) {
+  open_gl_context.extensions.glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+
+  int num_instances = shown_meters_.size();
+  if (shown_meters_ != instance_meters_) {
+    // Only shown meters get an instance, so the buffer is repacked when that set changes.
+    instance_meters_ = shown_meters_;
+    for (int i = 0; i < num_instances; ++i) {
+      instance_meters_[i]->takeInstanceChanged();
+      memcpy(instances_ + i * FLOATS_PER_INSTANCE, instance_meters_[i]->getInstance(),
+             FLOATS_PER_INSTANCE * sizeof(float));
+    }
+
+    GLsizeiptr size = static_cast<GLsizeiptr>(num_instances * FLOATS_PER_INSTANCE * sizeof(float));
+    open_gl_context.extensions.glBufferData(GL_ARRAY_BUFFER, size, instances_, GL_DYNAMIC_DRAW);
+  }
+  else {
+    // Otherwise only meters that moved are sent, neighbours together.
+    int run_start = -1;
+    for (int i = 0; i <= num_instances; ++i) {
+      bool changed = i < num_instances && instance_meters_[i]->takeInstanceChanged();
+      if (changed) {
+        memcpy(instances_ + i * FLOATS_PER_INSTANCE, instance_meters_[i]->getInstance(),
+               FLOATS_PER_INSTANCE * sizeof(float));
+        if (run_start < 0)
+          run_start = i;
+      }
+      else if (run_start >= 0) {
+        GLintptr offset = static_cast<GLintptr>(run_start * FLOATS_PER_INSTANCE * sizeof(float));
+        GLsizeiptr size = static_cast<GLsizeiptr>((i - run_start) * FLOATS_PER_INSTANCE *
+                                                  sizeof(float));
+        open_gl_context.extensions.glBufferSubData(GL_ARRAY_BUFFER, offset, size,
+                                                   instances_ + run_start * FLOATS_PER_INSTANCE);
+        run_start = -1;
+      }
+    }
   }
 
-  glDrawElements(GL_TRIANGLES, num_meters * INDICES_PER_METER, GL_UNSIGNED_INT, 0);
+  open_gl_context.extensions.glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-  if (position_ != nullptr)
-    open_gl_context.extensions.glDisableVertexAttribArray(position_->attributeID);
+void OpenGLModulationManager::enableInstanceAttribute(OpenGLContext& open_gl_context,
+                                                      OpenGLShaderProgram::Attribute* attribute,
+                                                      int size, int offset) {
+  if (attribute == nullptr)
+    return;
 
-  if (coordinates_ != nullptr)
-    open_gl_context.extensions.glDisableVertexAttribArray(coordinates_->attributeID);
+  open_gl_context.extensions.glVertexAttribPointer(attribute->attributeID, size, GL_FLOAT,
+                                                   GL_FALSE, FLOATS_PER_INSTANCE * sizeof(float),
+                                                   (GLvoid*)(offset * sizeof(float)));
+  open_gl_context.extensions.glEnableVertexAttribArray(attribute->attributeID);
+  glVertexAttribDivisor(attribute->attributeID, 1);
+}
 
-  if (range_ != nullptr)
-    open_gl_context.extensions.glDisableVertexAttribArray(range_->attributeID);
+void OpenGLModulationManager::disableInstanceAttribute(OpenGLContext& open_gl_context,
+                                                       OpenGLShaderProgram::Attribute* attribute) {
+  if (attribute == nullptr)
+    return;
 
-  open_gl_context.extensions.glBindBuffer(GL_ARRAY_BUFFER, 0);
-  open_gl_context.extensions.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  // The divisor is global state, other components expect one vertex per value.
+  glVertexAttribDivisor(attribute->attributeID, 0);
+  open_gl_context.extensions.glDisableVertexAttribArray(attribute->attributeID);
 }
 
 void OpenGLModulationManager::destroy(OpenGLContext& open_gl_context) {
   shader_ = nullptr;
-  position_ = nullptr;
-  coordinates_ = nullptr;
+  corner_ = nullptr;
+  bounds_ = nullptr;
   range_ = nullptr;
+  coordinate_scale_ = nullptr;
   radius_uniform_ = nullptr;
 
   open_gl_context.extensions.glDeleteBuffers(1, &vertex_buffer_);
   open_gl_context.extensions.glDeleteBuffers(1, &triangle_buffer_);
+  open_gl_context.extensions.glDeleteBuffers(1, &instance_buffer_);
 }
 
 void OpenGLModulationManager::hoverStarted(const std::string& name) {
@@ -322,6 +392,7 @@ void OpenGLModulationManager::modulationsChanged(const std::string& destination)
   int num_modulations = parent->getSynth()->getNumModulations(destination);
   meter_lookup_[destination]->setModulated(num_modulations);
   meter_lookup_[destination]->setVisible(num_modulations);
+  markDirty();
 }
 
 void OpenGLModulationManager::setModulationAmount(std::string source, std::string destination,
@@ -352,6 +423,7 @@ void OpenGLModulationManager::reset() {
   }
 
   setSliderValues();
+  markDirty();
 }
 
 void OpenGLModulationManager::makeModulationsVisible(std::string destination, bool visible) {
@@ -25,6 +25,7 @@
 #include "open_gl_component.h"
 #include "synth_slider.h"
 #include <set>
+#include <vector>
 
 class ModulationHighlight;
 class OpenGLModulationMeter;
@@ -57,6 +58,7 @@ class OpenGLModulationManager : public OpenGLComponent,
     void render(OpenGLContext& open_gl_context, bool animate = true) override;
     void destroy(OpenGLContext& open_gl_context) override;
     void paintBackground(Graphics& g) override { }
+    bool pollTelemetry() override;
 
     // SynthSlider::SliderListener
     void hoverStarted(const std::string& name) override;
@@ -66,6 +68,11 @@ class OpenGLModulationManager : public OpenGLComponent,
   private:
     void makeModulationsVisible(std::string destination, bool visible);
     void setSliderValues();
+    void uploadInstances(OpenGLContext& open_gl_context);
+    void enableInstanceAttribute(OpenGLContext& open_gl_context,
+                                 OpenGLShaderProgram::Attribute* attribute, int size, int offset);
+    void disableInstanceAttribute(OpenGLContext& open_gl_context,
+                                  OpenGLShaderProgram::Attribute* attribute);
 
     std::unique_ptr<Component> polyphonic_destinations_;
     std::unique_ptr<Component> monophonic_destinations_;
@@ -83,15 +90,20 @@ class OpenGLModulationManager : public OpenGLComponent,
     mopo::output_map modulation_sources_;
 
     std::unique_ptr<OpenGLShaderProgram> shader_;
-    std::unique_ptr<OpenGLShaderProgram::Attribute> position_;
-    std::unique_ptr<OpenGLShaderProgram::Attribute> coordinates_;
+    std::unique_ptr<OpenGLShaderProgram::Attribute> corner_;
+    std::unique_ptr<OpenGLShaderProgram::Attribute> bounds_;
     std::unique_ptr<OpenGLShaderProgram::Attribute> range_;
+    std::unique_ptr<OpenGLShaderProgram::Attribute> coordinate_scale_;
     std::unique_ptr<OpenGLShaderProgram::Uniform> radius_uniform_;
 
-    float* vertices_;
-    int* triangles_;
+    // One quad drawn once per shown meter. instances_ mirrors the instance
+    // buffer, in the order of instance_meters_.
+    std::vector<OpenGLModulationMeter*> shown_meters_;
+    std::vector<OpenGLModulationMeter*> instance_meters_;
+    float* instances_;
     GLuint vertex_buffer_;
     GLuint triangle_buffer_;
+    GLuint instance_buffer_;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OpenGLModulationManager)
 };
@@ -112,12 +112,34 @@ void SynthSection::initOpenGLComponents(OpenGLContext& open_gl_context) {
 
 void SynthSection::renderOpenGLComponents(OpenGLContext& open_gl_context, bool animate) {
   for (auto& open_gl_component : open_gl_components_)
-    open_gl_component->render(open_gl_context, animate);
+    open_gl_component->renderTimed(open_gl_context, animate);
 
   for (auto& sub_section : sub_sections_)
     sub_section.second->renderOpenGLComponents(open_gl_context, animate);
 }
 
+bool SynthSection::pollOpenGLComponents(bool animate) {
+  // Every component is polled, so each one keeps its last seen values.
+  bool dirty = false;
+  for (auto& open_gl_component : open_gl_components_) {
+    dirty |= open_gl_component->takeDirty();
+    if (animate && open_gl_component->isShowing())
+      dirty |= open_gl_component->pollTelemetry();
+  }
+
+  for (auto& sub_section : sub_sections_)
+    dirty |= sub_section.second->pollOpenGLComponents(animate);
+  return dirty;
+}
+
+void SynthSection::getOpenGLComponents(std::vector<OpenGLComponent*>* components) {
+  for (auto& open_gl_component : open_gl_components_)
+    components->push_back(open_gl_component);
+
+  for (auto& sub_section : sub_sections_)
+    sub_section.second->getOpenGLComponents(components);
+}
+
 void SynthSection::destroyOpenGLComponents(OpenGLContext& open_gl_context) {
   for (auto& open_gl_component : open_gl_components_)
     open_gl_component->destroy(open_gl_context);
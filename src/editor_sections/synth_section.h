@@ -23,6 +23,7 @@
 #include "helm2025_common.h"
 #include "synth_button.h"
 #include <map>
+#include <vector>
 
 class OpenGLComponent;
 class SynthSlider;
@@ -49,6 +50,10 @@ class SynthSection : public Component, public Slider::Listener,
     void renderOpenGLComponents(OpenGLContext& open_gl_context, bool animate);
     void destroyOpenGLComponents(OpenGLContext& open_gl_context);
 
+    // True when any OpenGL component below this section wants a new frame.
+    bool pollOpenGLComponents(bool animate);
+    void getOpenGLComponents(std::vector<OpenGLComponent*>* components);
+
     // Widget Listeners.
     virtual void sliderValueChanged(Slider* moved_slider) override;
     virtual void buttonClicked(Button* clicked_button) override;
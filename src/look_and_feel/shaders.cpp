@@ -55,18 +55,20 @@ const char* Shaders::shaders_[] = {
   "    gl_FragColor = color;\n"
   "}\n",
 
-  "attribute " JUCE_MEDIUMP " vec4 position;\n"
-  "attribute " JUCE_MEDIUMP " vec2 coordinates;\n"
+  "attribute " JUCE_MEDIUMP " vec2 corner;\n"
+  "attribute " JUCE_MEDIUMP " vec4 bounds;\n"
   "attribute " JUCE_MEDIUMP " vec2 range;\n"
+  "attribute " JUCE_MEDIUMP " float coordinate_scale;\n"
   "\n"
   "varying " JUCE_MEDIUMP " vec2 coordinates_out;\n"
   "varying " JUCE_MEDIUMP " vec2 range_out;\n"
   "\n"
   "void main()\n"
   "{\n"
-  "    coordinates_out = coordinates;\n"
+  "    " JUCE_MEDIUMP " vec2 t = 0.5 * corner + 0.5;\n"
+  "    coordinates_out = coordinate_scale * corner;\n"
   "    range_out = range;\n"
-  "    gl_Position = position;\n"
+  "    gl_Position = vec4(mix(bounds.x, bounds.y, t.x), mix(bounds.z, bounds.w, t.y), 0.0, 1.0);\n"
   "}\n",
 
   "varying " JUCE_MEDIUMP " vec2 coordinates_out;\n"
@@ -2,12 +2,16 @@
 
 #include "helm2025_plugin_simd.h"
 #include "juce_gui_basics/juce_gui_basics.h"
+#include "animation_clock.h"
 
-class HelmEditorSimd : public juce::AudioProcessorEditor {
+class HelmEditorSimd : public juce::AudioProcessorEditor,
+                       public AnimationClock::Holder,
+                       public AnimationClock::Listener {
 public:
     HelmEditorSimd(HelmPluginSimd& plugin)
         : AudioProcessorEditor(plugin)
-        , plugin_(plugin) {
+        , plugin_(plugin)
+        , animationClock_(this, 30) {
         
         setSize(800, 600);
 
@@ -17,11 +21,13 @@ public:
         setupEnvelopeControls();
 
         // Rafraîchissement de l'interface toutes les 50ms
-        startTimerHz(20);
+        animationClock_.addListener(this, 20);
     }
 
     ~HelmEditorSimd() override = default;
 
+    AnimationClock* getAnimationClock() override { return &animationClock_; }
+
     void paint(juce::Graphics& g) override {
         g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
     }
@@ -79,7 +85,7 @@ private:
         };
     }
 
-    void timerCallback() {
+    void animationTick() override {
         // Mise à jour des visualisations en temps réel
         repaint();
         ampEnvelope_.repaint();
@@ -87,6 +93,7 @@ private:
     }
 
     HelmPluginSimd& plugin_;
+    AnimationClock animationClock_;
     
     // Sections de l'interface
     juce::Component oscillatorSection;
@@ -18,10 +18,12 @@
 #include "helm2025_common.h"
 #include "helm2025_editor.h"
 #include "load_save.h"
+#include "realtime_audit.h"
 
 #define PITCH_WHEEL_RESOLUTION 0x3fff
 #define MAX_BUFFER_PROCESS 256
 #define SET_PROGRAM_WAIT_MILLISECONDS 500
+#define LATENCY_CHECK_MILLISECONDS 200
 
 HelmPlugin::HelmPlugin() :
     AudioProcessor(BusesProperties().withOutput("Output", juce::AudioChannelSet::stereo(), true)) {
@@ -37,9 +39,12 @@ HelmPlugin::HelmPlugin() :
     bridge_lookup_[control.first] = bridge;
     addParameter(bridge);
   }
+
+  startTimer(LATENCY_CHECK_MILLISECONDS);
 }
 
 HelmPlugin::~HelmPlugin() {
+  stopTimer();
   midi_manager_ = nullptr;
   keyboard_state_ = nullptr;
 }
@@ -154,6 +159,11 @@ void HelmPlugin::prepareToPlay(double sample_rate, int buffer_size) {
   engine_.setSampleRate(sample_rate);
   engine_.setBufferSize(std::min<int>(buffer_size, MAX_BUFFER_PROCESS));
   midi_manager_->setSampleRate(sample_rate);
+  // Hosts prepare again around a bounce. Switching here keeps the GUI
+  // refresh message out of processBlock.
+  setOfflineRender(isNonRealtime());
+  setLatencySamples(engine_.getLatencySamples());
+  mopo::realtime_audit::install();
 }
 
 void HelmPlugin::releaseResources() {
@@ -162,6 +172,7 @@ void HelmPlugin::releaseResources() {
 }
 
 void HelmPlugin::processBlock(AudioSampleBuffer& buffer, MidiBuffer& midi_messages) {
+  mopo::RealtimeScope realtime;
   int total_samples = buffer.getNumSamples();
   int num_channels = getTotalNumOutputChannels();
   getPlayHead()->getCurrentPosition(position_info_);
@@ -174,19 +185,25 @@ void HelmPlugin::processBlock(AudioSampleBuffer& buffer, MidiBuffer& midi_messag
   processControlChanges();
   processModulationChanges();
 
-  MidiBuffer keyboard_messages = midi_messages;
-  processKeyboardEvents(keyboard_messages, total_samples);
+  decodeMidi(midi_messages, total_samples);
 
   for (int sample_offset = 0; sample_offset < total_samples;) {
     int num_samples = std::min<int>(total_samples - sample_offset, MAX_BUFFER_PROCESS);
 
-    processMidi(midi_messages, sample_offset, sample_offset + num_samples);
+    processMidi(sample_offset, sample_offset + num_samples);
     processAudio(&buffer, num_channels, num_samples, sample_offset);
 
     sample_offset += num_samples;
   }
 }
 
+void HelmPlugin::timerCallback() {
+  // Hosts expect latency changes on the message thread.
+  int latency = engine_.getLatencySamples();
+  if (latency != getLatencySamples())
+    setLatencySamples(latency);
+}
+
 bool HelmPlugin::hasEditor() const {
   return true;
 }
@@ -24,7 +24,8 @@
 
 class ValueBridge;
 
-class HelmPlugin : public SynthBase, public AudioProcessor, public ValueBridge::Listener {
+class HelmPlugin : public SynthBase, public AudioProcessor, public ValueBridge::Listener,
+                   private Timer {
   public:
     HelmPlugin();
     virtual ~HelmPlugin();
@@ -74,6 +75,9 @@ class HelmPlugin : public SynthBase, public AudioProcessor, public ValueBridge::
     bool isBusesLayoutSupported(const BusesLayout &layouts) const override;
 
   private:
+    // Tells the host when the patch changes the oversampling latency.
+    void timerCallback() override;
+
     uint32 set_state_time_;
 
     int current_program_;
@@ -0,0 +1,217 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batch_renderer.h"
+
+#include "render_synth.h"
+
+#define RENDER_BLOCK_SAMPLES 4096
+#define SILENCE_MAGNITUDE 0.00001f
+#define SILENCE_SECONDS 1.0
+
+bool RenderClip::loadFromFile(File file) {
+  FileInputStream stream(file);
+  MidiFile midi_file;
+  if (!stream.openedOk() || !midi_file.readFrom(stream))
+    return false;
+
+  midi_file.convertTimestampTicksToSeconds();
+
+  name = file.getFileNameWithoutExtension();
+  events.clear();
+  for (int i = 0; i < midi_file.getNumTracks(); ++i)
+    events.addSequence(*midi_file.getTrack(i), 0.0);
+  events.updateMatchedPairs();
+  length = events.getEndTime();
+
+  MidiMessageSequence tempos;
+  midi_file.findAllTempoEvents(tempos);
+  bpm = 0.0;
+  if (tempos.getNumEvents())
+    bpm = 60.0 / tempos.getEventPointer(0)->message.getTempoSecondsPerQuarterNote();
+  return true;
+}
+
+BatchRenderer::Worker::Worker(BatchRenderer* renderer) :
+    Thread("Render Worker"), renderer_(renderer), buffer_(mopo::NUM_CHANNELS, RENDER_BLOCK_SAMPLES) {
+  midi_.ensureSize(RENDER_BLOCK_SAMPLES);
+}
+
+BatchRenderer::Worker::~Worker() {
+  stopThread(-1);
+}
+
+void BatchRenderer::Worker::run() {
+  const RenderJob* job = nullptr;
+  while (!threadShouldExit() && (job = renderer_->nextJob())) {
+    String error;
+    if (renderer_->renderJob(*job, synth_, buffer_, midi_, error))
+      renderer_->num_rendered_++;
+    else
+      renderer_->addFailure(*job, error);
+  }
+}
+
+void BatchRenderer::render(const std::vector<RenderJob>& jobs) {
+  jobs_ = &jobs;
+  next_job_ = 0;
+  num_rendered_ = 0;
+  rendered_samples_ = 0;
+  failures_.clear();
+
+  double start = Time::getMillisecondCounterHiRes();
+
+  int num_workers = std::max(1, std::min<int>(settings_.num_threads, jobs.size()));
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (int i = 0; i < num_workers; ++i) {
+    workers.push_back(std::make_unique<Worker>(this));
+    workers.back()->startThread();
+  }
+
+  for (auto& worker : workers)
+    worker->waitForThreadToExit(-1);
+
+  wall_seconds_ = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+  jobs_ = nullptr;
+}
+
+double BatchRenderer::getAudioSeconds() const {
+  return rendered_samples_ / static_cast<double>(settings_.sample_rate);
+}
+
+const RenderJob* BatchRenderer::nextJob() {
+  int index = next_job_++;
+  if (index >= static_cast<int>(jobs_->size()))
+    return nullptr;
+  return &(*jobs_)[index];
+}
+
+bool BatchRenderer::renderJob(const RenderJob& job, std::unique_ptr<RenderSynth>& synth,
+                              AudioSampleBuffer& buffer, MidiBuffer& midi, String& error) {
+  // Filter and delay state left by the last job would change the output.
+  if (settings_.deterministic)
+    synth = nullptr;
+
+  if (synth == nullptr) {
+    ScopedLock lock(startup_lock_);
+    synth = std::make_unique<RenderSynth>(settings_.sample_rate);
+  }
+
+  if (!synth->loadPatch(job.patch)) {
+    error = "Couldn't load patch";
+    return false;
+  }
+
+  if (settings_.deterministic)
+    synth->setRandomSeed(settings_.seed);
+
+  const RenderClip* clip = job.clip;
+  if (clip->bpm)
+    synth->setBpm(clip->bpm);
+
+  if (!job.output.getParentDirectory().createDirectory()) {
+    error = "Couldn't create " + job.output.getParentDirectory().getFullPathName();
+    return false;
+  }
+
+  job.output.deleteFile();
+  std::unique_ptr<FileOutputStream> stream = job.output.createOutputStream();
+  if (stream == nullptr || stream->failedToOpen()) {
+    error = "Couldn't open output file";
+    return false;
+  }
+
+  // The writer owns the stream once it's made.
+  WavAudioFormat wav_format;
+  std::unique_ptr<AudioFormatWriter> writer(
+      wav_format.createWriterFor(stream.get(), settings_.sample_rate, mopo::NUM_CHANNELS,
+                                 settings_.bit_depth, {}, 0));
+  if (writer == nullptr) {
+    error = "Unsupported output format";
+    return false;
+  }
+  stream.release();
+
+  int sample_rate = settings_.sample_rate;
+  int64 clip_samples = static_cast<int64>(clip->length * sample_rate);
+  int64 end_sample = clip_samples + static_cast<int64>(settings_.max_tail * sample_rate);
+  int64 silence_samples = static_cast<int64>(SILENCE_SECONDS * sample_rate);
+
+  int num_events = clip->events.getNumEvents();
+  int event_index = 0;
+  bool released = false;
+  bool silent = false;
+  int64 quiet_samples = 0;
+  int64 position = 0;
+
+  while (position < end_sample && !silent) {
+    int num_samples = static_cast<int>(std::min<int64>(RENDER_BLOCK_SAMPLES, end_sample - position));
+
+    midi.clear();
+    for (; event_index < num_events; ++event_index) {
+      const MidiMessage& message = clip->events.getEventPointer(event_index)->message;
+      int64 sample = static_cast<int64>(message.getTimeStamp() * sample_rate);
+      if (sample >= position + num_samples)
+        break;
+      // A program change would swap the job's patch for a bank one.
+      if (!message.isMetaEvent() && !message.isProgramChange())
+        midi.addEvent(message, static_cast<int>(sample - position));
+    }
+
+    if (!released && position >= clip_samples) {
+      synth->releaseNotes();
+      released = true;
+    }
+
+    synth->render(buffer, midi, num_samples, position);
+
+    // Line the file up with the clip, like a host compensating for latency.
+    int skip = 0;
+    if (position == 0) {
+      skip = std::min(synth->getLatencySamples(), num_samples);
+      end_sample += skip;
+    }
+
+    if (!writer->writeFromAudioSampleBuffer(buffer, skip, num_samples - skip)) {
+      writer = nullptr;
+      synth = nullptr;
+      job.output.deleteFile();
+      error = "Couldn't write output file";
+      return false;
+    }
+
+    if (released) {
+      if (buffer.getMagnitude(0, num_samples) < SILENCE_MAGNITUDE)
+        quiet_samples += num_samples;
+      else
+        quiet_samples = 0;
+      silent = quiet_samples >= silence_samples && !synth->hasActiveVoices();
+    }
+
+    rendered_samples_ += num_samples - skip;
+    position += num_samples;
+  }
+
+  // Anything still sounding would leak into the next job.
+  if (!silent)
+    synth = nullptr;
+  return true;
+}
+
+void BatchRenderer::addFailure(const RenderJob& job, const String& error) {
+  ScopedLock lock(failure_lock_);
+  failures_.push_back({ job, error });
+}
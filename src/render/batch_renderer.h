@@ -0,0 +1,121 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCH_RENDERER_H
+#define BATCH_RENDERER_H
+
+#include <JuceHeader.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class RenderSynth;
+
+// A MIDI file merged into one sequence, with times in seconds. Loaded once
+// and read by every worker.
+struct RenderClip {
+  bool loadFromFile(File file);
+
+  String name;
+  MidiMessageSequence events;
+  double length = 0.0;
+
+  // From the file's first tempo event, zero leaves the patch's tempo.
+  double bpm = 0.0;
+};
+
+struct RenderJob {
+  File patch;
+  const RenderClip* clip;
+  File output;
+};
+
+struct RenderSettings {
+  int sample_rate = 44100;
+  int bit_depth = 24;
+  int num_threads = 1;
+
+  // Longest release kept after the clip ends, renders stop sooner once the
+  // patch falls silent.
+  double max_tail = 4.0;
+
+  // Seeds every job's random streams the same way, so a render comes out
+  // bit for bit the same on any thread and in any order.
+  bool deterministic = false;
+  uint64 seed = 0;
+};
+
+// Renders patches playing clips to WAV files on a pool of threads. Each
+// thread owns one synth and reuses it from job to job, unless renders are
+// deterministic, then every job starts on a fresh one. Output is written
+// to disk a block at a time.
+class BatchRenderer {
+  public:
+    struct Failure {
+      RenderJob job;
+      String error;
+    };
+
+    BatchRenderer(const RenderSettings& settings) : settings_(settings) { }
+
+    // Blocks until every job is done.
+    void render(const std::vector<RenderJob>& jobs);
+
+    int getNumRendered() const { return num_rendered_; }
+    const std::vector<Failure>& getFailures() const { return failures_; }
+    double getAudioSeconds() const;
+    double getWallSeconds() const { return wall_seconds_; }
+
+  private:
+    class Worker : public Thread {
+      public:
+        Worker(BatchRenderer* renderer);
+        ~Worker();
+
+        void run() override;
+
+      private:
+        BatchRenderer* renderer_;
+        std::unique_ptr<RenderSynth> synth_;
+        AudioSampleBuffer buffer_;
+        MidiBuffer midi_;
+    };
+
+    const RenderJob* nextJob();
+
+    // Returns false and sets _error_ on failure. Drops _synth_ when the
+    // patch didn't fall silent, the next job then starts on a fresh one.
+    bool renderJob(const RenderJob& job, std::unique_ptr<RenderSynth>& synth,
+                   AudioSampleBuffer& buffer, MidiBuffer& midi, String& error);
+    void addFailure(const RenderJob& job, const String& error);
+
+    RenderSettings settings_;
+    const std::vector<RenderJob>* jobs_ = nullptr;
+    std::atomic<int> next_job_ { 0 };
+    std::atomic<int> num_rendered_ { 0 };
+    std::atomic<int64> rendered_samples_ { 0 };
+    double wall_seconds_ = 0.0;
+
+    // Creating a synth reads and may write the user's config.
+    CriticalSection startup_lock_;
+    CriticalSection failure_lock_;
+    std::vector<Failure> failures_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchRenderer)
+};
+
+#endif // BATCH_RENDERER_H
@@ -0,0 +1,178 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <JuceHeader.h>
+#include "batch_renderer.h"
+#include "helm2025_common.h"
+
+#include <iostream>
+#include <set>
+
+namespace {
+  void printHelp() {
+    std::cout << "Usage:" << newLine;
+    std::cout << "  " << ProjectInfo::projectName << " [OPTION...] -m CLIP.mid PATCH..." << newLine << newLine;
+    std::cout << "Renders every PATCH playing every CLIP to a WAV file. A PATCH can be a ."
+              << mopo::PATCH_EXTENSION << " file," << newLine;
+    std::cout << "a folder searched for them, or a .txt file listing one per line." << newLine << newLine;
+    std::cout << "Help Options:" << newLine;
+    std::cout << "  -h, --help                          Show help options" << newLine << newLine;
+    std::cout << "Application Options:" << newLine;
+    std::cout << "  -v, --version                       Show version information and exit" << newLine;
+    std::cout << "  -m, --midi FILE                     MIDI clip to play, repeat for more clips" << newLine;
+    std::cout << "  -o, --output DIR                    Where to write, default is the current folder" << newLine;
+    std::cout << "  -j, --threads N                     Render threads, default is one per core" << newLine;
+    std::cout << "  -r, --rate HZ                       Sample rate, default is 44100" << newLine;
+    std::cout << "  -b, --bits N                        16, 24 or 32 bits per sample, default is 24" << newLine;
+    std::cout << "  -t, --tail SECONDS                  Longest release after a clip, default is 4" << newLine;
+    std::cout << "  -s, --seed N                        Seed randomness so renders repeat exactly" << newLine;
+  }
+
+  File getFile(const String& path) {
+    return File::getCurrentWorkingDirectory().getChildFile(path.unquoted());
+  }
+
+  void addPatches(File file, Array<File>& patches) {
+    String patch_pattern = String("*.") + mopo::PATCH_EXTENSION;
+
+    if (file.isDirectory()) {
+      Array<File> found;
+      file.findChildFiles(found, File::findFiles, true, patch_pattern);
+      found.sort();
+      patches.addArray(found);
+    }
+    else if (file.hasFileExtension("txt")) {
+      StringArray lines;
+      file.readLines(lines);
+      for (const String& line : lines) {
+        if (line.trim().isNotEmpty())
+          addPatches(getFile(line.trim()), patches);
+      }
+    }
+    else
+      patches.add(file);
+  }
+
+  // Patches from different folders can share a name, so the folder goes in
+  // the path and anything still clashing gets a number.
+  File getOutputFile(File output_directory, File patch, const RenderClip& clip,
+                     bool name_clip, std::set<String>& used) {
+    String name = patch.getFileNameWithoutExtension();
+    if (name_clip)
+      name += " - " + clip.name;
+
+    File folder = output_directory.getChildFile(patch.getParentDirectory().getFileName());
+    File output = folder.getChildFile(File::createLegalFileName(name + ".wav"));
+    for (int i = 2; used.count(output.getFullPathName().toLowerCase()); ++i)
+      output = folder.getChildFile(File::createLegalFileName(name + " " + String(i) + ".wav"));
+
+    used.insert(output.getFullPathName().toLowerCase());
+    return output;
+  }
+} // namespace
+
+int main(int argc, char* argv[]) {
+  StringArray args;
+  for (int i = 1; i < argc; ++i)
+    args.add(String::fromUTF8(argv[i]));
+
+  RenderSettings settings;
+  settings.num_threads = SystemStats::getNumCpus();
+  File output_directory = File::getCurrentWorkingDirectory();
+  StringArray clip_paths;
+  Array<File> patches;
+
+  for (int i = 0; i < args.size(); ++i) {
+    String arg = args[i];
+    bool has_value = i + 1 < args.size();
+
+    if (arg == "--help" || arg == "-h") {
+      printHelp();
+      return 0;
+    }
+    else if (arg == "--version" || arg == "-v") {
+      std::cout << ProjectInfo::projectName << " " << ProjectInfo::versionString << newLine;
+      return 0;
+    }
+    else if ((arg == "--midi" || arg == "-m") && has_value)
+      clip_paths.add(args[++i]);
+    else if ((arg == "--output" || arg == "-o") && has_value)
+      output_directory = getFile(args[++i]);
+    else if ((arg == "--threads" || arg == "-j") && has_value)
+      settings.num_threads = std::max(1, args[++i].getIntValue());
+    else if ((arg == "--rate" || arg == "-r") && has_value)
+      settings.sample_rate = args[++i].getIntValue();
+    else if ((arg == "--bits" || arg == "-b") && has_value)
+      settings.bit_depth = args[++i].getIntValue();
+    else if ((arg == "--tail" || arg == "-t") && has_value)
+      settings.max_tail = std::max(0.0, args[++i].getDoubleValue());
+    else if ((arg == "--seed" || arg == "-s") && has_value) {
+      settings.deterministic = true;
+      settings.seed = static_cast<uint64>(args[++i].getLargeIntValue());
+    }
+    else if (arg.startsWith("-")) {
+      std::cerr << "Unknown option " << arg << ", see --help" << newLine;
+      return 1;
+    }
+    else
+      addPatches(getFile(arg), patches);
+  }
+
+  if (clip_paths.isEmpty() || patches.isEmpty()) {
+    printHelp();
+    return 1;
+  }
+
+  if (settings.sample_rate <= 0) {
+    std::cerr << "Sample rate must be positive" << newLine;
+    return 1;
+  }
+
+  std::vector<std::unique_ptr<RenderClip>> clips;
+  for (const String& path : clip_paths) {
+    clips.push_back(std::make_unique<RenderClip>());
+    if (!clips.back()->loadFromFile(getFile(path))) {
+      std::cerr << "Couldn't read MIDI file " << path << newLine;
+      return 1;
+    }
+  }
+
+  std::vector<RenderJob> jobs;
+  std::set<String> used_outputs;
+  for (const File& patch : patches) {
+    for (auto& clip : clips) {
+      File output = getOutputFile(output_directory, patch, *clip, clips.size() > 1, used_outputs);
+      jobs.push_back({ patch, clip.get(), output });
+    }
+  }
+
+  BatchRenderer renderer(settings);
+  renderer.render(jobs);
+
+  for (const BatchRenderer::Failure& failure : renderer.getFailures()) {
+    std::cerr << "Failed " << failure.job.patch.getFullPathName() << " with "
+              << failure.job.clip->name << ": " << failure.error << newLine;
+  }
+
+  double audio_seconds = renderer.getAudioSeconds();
+  double wall_seconds = std::max(renderer.getWallSeconds(), 0.001);
+  std::cout << "Rendered " << renderer.getNumRendered() << " of " << (int)jobs.size()
+            << " files on " << std::min<int>(settings.num_threads, jobs.size()) << " threads" << newLine;
+  std::cout << String(audio_seconds, 1) << " s of audio in " << String(wall_seconds, 1) << " s, "
+            << String(audio_seconds / wall_seconds, 1) << " patch-seconds per second" << newLine;
+
+  return renderer.getFailures().empty() ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "render_synth.h"
+
+// Same slicing as the plugin's offline bounces, so renders match them.
+#define RENDER_BUFFER_PROCESS 256
+
+RenderSynth::RenderSynth(int sample_rate) {
+  engine_.setSampleRate(sample_rate);
+  engine_.setBufferSize(RENDER_BUFFER_PROCESS);
+  engine_.updateAllModulationSwitches();
+  midi_manager_->setSampleRate(sample_rate);
+  setOfflineRender(true);
+}
+
+bool RenderSynth::loadPatch(File patch) {
+  if (!loadFromFile(patch))
+    return false;
+
+  processControlChanges();
+  processModulationChanges();
+  // Picks the distortion oversampling for this patch.
+  setOfflineRender(true);
+  return true;
+}
+
+void RenderSynth::render(AudioSampleBuffer& buffer, MidiBuffer& midi_messages,
+                         int num_samples, int64 position) {
+  ScopedLock lock(getCriticalSection());
+
+  engine_.correctToTime(position);
+  processControlChanges();
+  processModulationChanges();
+  decodeMidi(midi_messages, num_samples);
+
+  for (int sample_offset = 0; sample_offset < num_samples;) {
+    int samples = std::min<int>(num_samples - sample_offset, RENDER_BUFFER_PROCESS);
+
+    processMidi(sample_offset, sample_offset + samples);
+    processAudio(&buffer, buffer.getNumChannels(), samples, sample_offset);
+
+    sample_offset += samples;
+  }
+}
+
+void RenderSynth::releaseNotes() {
+  ScopedLock lock(getCriticalSection());
+
+  engine_.sustainOff();
+  engine_.allNotesOff();
+
+  // Releasing a note takes it off the pressed list, so copy it first.
+  std::vector<mopo::mopo_float> pressed;
+  for (mopo::mopo_float note : engine_.getPressedNotes())
+    pressed.push_back(note);
+
+  for (mopo::mopo_float note : pressed)
+    (void)engine_.noteOff(note);
+}
@@ -0,0 +1,56 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RENDER_SYNTH_H
+#define RENDER_SYNTH_H
+
+#include <JuceHeader.h>
+
+#include "synth_base.h"
+
+// A synth with no GUI and no audio device, driven block by block by the
+// batch renderer. Always runs as an offline bounce.
+class RenderSynth : public SynthBase {
+  public:
+    RenderSynth(int sample_rate);
+
+    // SynthBase
+    const CriticalSection& getCriticalSection() override { return critical_section_; }
+    SynthGuiInterface* getGuiInterface() override { return nullptr; }
+
+    bool loadPatch(File patch);
+    void setBpm(double bpm) { engine_.setBpm(bpm); }
+    void setRandomSeed(uint64 seed) { engine_.setDeterministicRender(true, seed); }
+
+    // Renders _num_samples_ into the start of _buffer_, with _midi_messages_
+    // timed from the start of the block. _position_ is the block's time in
+    // samples from the start of the clip, tempo synced modulation follows it.
+    void render(AudioSampleBuffer& buffer, MidiBuffer& midi_messages,
+                int num_samples, int64 position);
+
+    // Lets go of every held note and the sustain pedal.
+    void releaseNotes();
+
+    bool hasActiveVoices() { return engine_.getNumActiveVoices() > 0; }
+    int getLatencySamples() { return engine_.getLatencySamples(); }
+
+  private:
+    CriticalSection critical_section_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderSynth)
+};
+
+#endif // RENDER_SYNTH_H
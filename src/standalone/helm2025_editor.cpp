@@ -189,6 +189,7 @@ void HelmEditor::prepareToPlay(int buffer_size, double sample_rate) {
   engine_.setBufferSize(std::min(buffer_size, MAX_BUFFER_PROCESS));
   engine_.updateAllModulationSwitches();
   midi_manager_->setSampleRate(sample_rate);
+  mopo::realtime_audit::install();
   // Sauvegarde immédiate du buffer size
   UserPreferences::saveAudioBufferSize(buffer_size);
   // Sauvegarde immédiate des paramètres audio principaux
@@ -213,6 +214,7 @@ void HelmEditor::prepareToPlay(int buffer_size, double sample_rate) {
 }
 
 void HelmEditor::getNextAudioBlock(const AudioSourceChannelInfo& buffer) {
+  mopo::RealtimeScope realtime;
   ScopedLock lock(getCriticalSection());
 
   int num_samples = buffer.buffer->getNumSamples();
@@ -222,12 +224,12 @@ void HelmEditor::getNextAudioBlock(const AudioSourceChannelInfo& buffer) {
   processModulationChanges();
   MidiBuffer midi_messages;
   midi_manager_->removeNextBlockOfMessages(midi_messages, num_samples);
-  processMidi(midi_messages);
-  processKeyboardEvents(midi_messages, num_samples);
+  decodeMidi(midi_messages, num_samples);
 
   for (int b = 0; b < num_samples; b += synth_samples) {
     int current_samples = std::min<int>(synth_samples, num_samples - b);
 
+    processMidi(b, b + current_samples);
     processAudio(buffer.buffer, mopo::NUM_CHANNELS, current_samples, b);
   }
 }
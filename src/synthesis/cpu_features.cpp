@@ -0,0 +1,123 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cpu_features.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define MSVC_X86 1
+#elif defined(__x86_64__) || defined(__i386__)
+#define GNU_X86 1
+#endif
+
+namespace mopo {
+
+  namespace {
+#if MSVC_X86
+    // CPUID leaf 1 ECX and leaf 7 EBX bits, plus the XCR0 state the OS
+    // saves. AVX registers are only usable when the OS saves them too.
+    const int SSE41_BIT = 1 << 19;
+    const int OSXSAVE_BIT = 1 << 27;
+    const int AVX2_BIT = 1 << 5;
+    const int AVX512F_BIT = 1 << 16;
+    const unsigned long long XCR0_AVX = 0x6;
+    const unsigned long long XCR0_AVX512 = 0xe6;
+
+    bool detect(CpuFeatures::Isa isa) {
+      int info[4];
+      __cpuid(info, 0);
+      int max_leaf = info[0];
+
+      __cpuid(info, 1);
+      bool sse41 = info[2] & SSE41_BIT;
+      bool osxsave = info[2] & OSXSAVE_BIT;
+      if (isa == CpuFeatures::kSse41)
+        return sse41;
+      if (!osxsave || max_leaf < 7)
+        return false;
+
+      unsigned long long xcr0 = _xgetbv(0);
+      __cpuidex(info, 7, 0);
+      if (isa == CpuFeatures::kAvx2)
+        return (info[1] & AVX2_BIT) && (xcr0 & XCR0_AVX) == XCR0_AVX;
+      if (isa == CpuFeatures::kAvx512)
+        return (info[1] & AVX512F_BIT) && (xcr0 & XCR0_AVX512) == XCR0_AVX512;
+      return false;
+    }
+#elif GNU_X86
+    // The builtins check the OS saves the wider registers as well.
+    bool detect(CpuFeatures::Isa isa) {
+      __builtin_cpu_init();
+      switch (isa) {
+        case CpuFeatures::kSse41:
+          return __builtin_cpu_supports("sse4.1");
+        case CpuFeatures::kAvx2:
+          return __builtin_cpu_supports("avx2");
+        case CpuFeatures::kAvx512:
+          return __builtin_cpu_supports("avx512f");
+        default:
+          return false;
+      }
+    }
+#else
+    bool detect(CpuFeatures::Isa isa) {
+      return false;
+    }
+#endif
+
+    struct DetectedFeatures {
+      DetectedFeatures() {
+        supported[CpuFeatures::kGeneric] = true;
+        for (int i = CpuFeatures::kGeneric + 1; i < CpuFeatures::kNumIsas; ++i)
+          supported[i] = detect(static_cast<CpuFeatures::Isa>(i));
+      }
+
+      bool supported[CpuFeatures::kNumIsas];
+    };
+
+    const DetectedFeatures& detectedFeatures() {
+      static const DetectedFeatures features;
+      return features;
+    }
+  } // namespace
+
+  bool CpuFeatures::supports(Isa isa) {
+    if (isa < kGeneric || isa >= kNumIsas)
+      return false;
+    return detectedFeatures().supported[isa];
+  }
+
+  CpuFeatures::Isa CpuFeatures::best() {
+    for (int i = kNumIsas - 1; i > kGeneric; --i) {
+      if (supports(static_cast<Isa>(i)))
+        return static_cast<Isa>(i);
+    }
+    return kGeneric;
+  }
+
+  const char* CpuFeatures::name(Isa isa) {
+    switch (isa) {
+      case kSse41:
+        return "SSE4.1";
+      case kAvx2:
+        return "AVX2";
+      case kAvx512:
+        return "AVX-512";
+      default:
+        return "generic";
+    }
+  }
+} // namespace mopo
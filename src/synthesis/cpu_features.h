@@ -0,0 +1,42 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+namespace mopo {
+
+  // Instruction sets the kernels are built for, read from CPUID once. The
+  // rest of the tree is compiled for the baseline so the binary loads on
+  // any x86-64 (or non x86) machine.
+  class CpuFeatures {
+    public:
+      enum Isa {
+        kGeneric,
+        kSse41,
+        kAvx2,
+        kAvx512,
+        kNumIsas
+      };
+
+      static bool supports(Isa isa);
+      static Isa best();
+      static const char* name(Isa isa);
+  };
+} // namespace mopo
+
+#endif // CPU_FEATURES_H
@@ -0,0 +1,104 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cpu_governor.h"
+#include "utils.h"
+
+#define DEFAULT_OVERLOAD 0.8
+#define DEFAULT_HEADROOM 0.5
+#define LOAD_DECAY 0.95
+#define SETTLE_BLOCKS 8
+#define RECOVER_SECONDS 2.0
+
+#define REDUCED_RELEASED_UNISON 3
+#define MIN_RELEASED_UNISON 1
+
+namespace mopo {
+
+  CpuGovernor::CpuGovernor() : Processor(0, 0),
+      enabled_(false), overload_(DEFAULT_OVERLOAD), headroom_(DEFAULT_HEADROOM),
+      level_(kFullQuality), load_(0.0), settle_blocks_(0), quiet_blocks_(0),
+      level_changes_(0) {
+    block_start_ = std::chrono::steady_clock::now();
+  }
+
+  void CpuGovernor::beginBlock() {
+    if (enabled_)
+      block_start_ = std::chrono::steady_clock::now();
+  }
+
+  void CpuGovernor::process() {
+    if (!enabled_) {
+      load_ = 0.0;
+      quiet_blocks_ = 0;
+      setLevel(kFullQuality);
+      return;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - block_start_;
+    mopo_float deadline = (1.0 * buffer_size_) / sample_rate_;
+    mopo_float block_load = elapsed.count() / deadline;
+
+    // Follow spikes immediately, fall back slowly.
+    load_ = utils::max(block_load, load_ * LOAD_DECAY);
+
+    if (settle_blocks_ > 0) {
+      settle_blocks_--;
+      return;
+    }
+
+    if (load_ > overload_) {
+      quiet_blocks_ = 0;
+      if (level_ < kNoTelemetry)
+        setLevel(static_cast<Level>(level_ + 1));
+      return;
+    }
+
+    if (load_ >= headroom_ || level_ == kFullQuality) {
+      quiet_blocks_ = 0;
+      return;
+    }
+
+    quiet_blocks_++;
+    if (quiet_blocks_ * deadline >= RECOVER_SECONDS) {
+      quiet_blocks_ = 0;
+      setLevel(static_cast<Level>(level_ - 1));
+    }
+  }
+
+  void CpuGovernor::setThresholds(mopo_float overload, mopo_float headroom) {
+    overload_ = overload;
+    headroom_ = utils::min(headroom, overload);
+  }
+
+  int CpuGovernor::releasedUnison() const {
+    if (level_ >= kNoTelemetry)
+      return MIN_RELEASED_UNISON;
+    if (level_ >= kReducedUnison)
+      return REDUCED_RELEASED_UNISON;
+    return 0;
+  }
+
+  void CpuGovernor::setLevel(Level level) {
+    if (level == level_)
+      return;
+
+    // Give the new level a few blocks to show up in the measurements.
+    level_ = level;
+    settle_blocks_ = SETTLE_BLOCKS;
+    level_changes_++;
+  }
+} // namespace mopo
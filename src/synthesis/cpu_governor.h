@@ -0,0 +1,83 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef CPU_GOVERNOR_H
+#define CPU_GOVERNOR_H
+
+#include "processor.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace mopo {
+
+  // Measures how long the engine takes to render a block against the time
+  // the block lasts and steps quality down when it runs out of headroom.
+  // Quality comes back one level at a time once the load has stayed low.
+  // Settings and readings are atomic, so other threads can turn it on and
+  // meter it while the audio thread runs it.
+  class CpuGovernor : public Processor {
+    public:
+      enum Level {
+        kFullQuality,
+        kReducedUnison,
+        kNoTelemetry,
+        kNumLevels
+      };
+
+      CpuGovernor();
+
+      virtual Processor* clone() const override {
+        MOPO_ASSERT(false);
+        return nullptr;
+      }
+
+      // Call around the work being measured. process() ends the block.
+      void beginBlock();
+      void process() override;
+
+      // Turning it off returns to full quality on the next process().
+      void setEnabled(bool enabled) { enabled_ = enabled; }
+      bool enabled() const { return enabled_; }
+      void setThresholds(mopo_float overload, mopo_float headroom);
+
+      Level level() const { return level_; }
+      mopo_float load() const { return load_; }
+      int numLevelChanges() const { return level_changes_; }
+
+      // Unison voices a released note may keep, zero for no limit.
+      int releasedUnison() const;
+      bool skipTelemetry() const { return level_ >= kNoTelemetry; }
+
+    private:
+      void setLevel(Level level);
+
+      std::atomic<bool> enabled_;
+      std::atomic<mopo_float> overload_;
+      std::atomic<mopo_float> headroom_;
+
+      std::atomic<Level> level_;
+      std::atomic<mopo_float> load_;
+      int settle_blocks_;
+      int quiet_blocks_;
+      std::atomic<int> level_changes_;
+
+      std::chrono::steady_clock::time_point block_start_;
+  };
+} // namespace mopo
+
+#endif // CPU_GOVERNOR_H
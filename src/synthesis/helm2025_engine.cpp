@@ -20,8 +20,11 @@
 #include "helm2025_lfo.h"
 #include "helm2025_voice_handler.h"
 #include "peak_meter.h"
+#include "random_generator.h"
 #include "value_switch.h"
 
+#include <chrono>
+
 #ifdef __APPLE__
 #include <fenv.h>
 #endif
@@ -32,6 +35,13 @@ namespace {
   constexpr double VOLUME_SMOOTH_TIME = 0.005;
   constexpr double CLAMP_MIN = -2.1;
   constexpr double CLAMP_MAX = 2.1;
+  constexpr int OFFLINE_DISTORTION_STAGES = 2;
+
+  // Differs between runs and between engines made at the same moment.
+  uint64_t entropySeed(const void* instance) {
+    uint64_t time = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    return mopo::RandomGenerator::mix(time, reinterpret_cast<uintptr_t>(instance));
+  }
 }
 
 namespace mopo {
@@ -43,9 +53,18 @@ namespace mopo {
     , lfo_1_(nullptr)
     , lfo_2_(nullptr)
     , peak_meter_(nullptr)
-    , step_sequencer_(nullptr) {
+    , step_sequencer_(nullptr)
+    , distortion_oversampler_(nullptr)
+    , distortion_on_(nullptr)
+    , applied_level_(CpuGovernor::kFullQuality)
+    , offline_render_(false)
+    , deterministic_render_(false)
+    , realtime_governor_enabled_(false)
+    , latency_samples_(0)
+    , realtime_cpu_budget_(0.0) {
     init();
     bps_ = controls_["beats_per_minute"];
+    setRandomSeed(entropySeed(this));
   }
 
   HelmEngine::~HelmEngine() {
@@ -67,6 +86,7 @@ namespace mopo {
     Output* polyphony = createMonoModControl("polyphony", true);
 
     voice_handler_ = new HelmVoiceHandler(beats_per_second_clamped->output());
+    voice_handler_->setProfiler(&profiler_);
     addSubmodule(voice_handler_);
     voice_handler_->setPolyphony(32);
     voice_handler_->plug(polyphony, VoiceHandler::kPolyphony);
@@ -177,23 +197,32 @@ namespace mopo {
     arpeggiator_->plug(arp_on_, Arpeggiator::kOn);
 
     addProcessor(voice_handler_);
+    voice_handler_->setProfileSection(profiler_.section("voices"));
+
+    // Distortion, optionally oversampled to keep high drive from aliasing.
+    Value* distortion_oversampling = createBaseControl("distortion_oversampling");
+    distortion_oversampler_ = new Oversampler();
+    distortion_oversampler_->plug(voice_handler_, Oversampler::kAudio);
+    distortion_oversampler_->plug(distortion_oversampling, Oversampler::kStages);
 
-    // Distortion
     Distortion* distortion = new Distortion();
-    Value* distortion_on = createBaseControl("distortion_on");
+    distortion_on_ = createBaseControl("distortion_on");
     Value* distortion_type = createBaseControl("distortion_type");
     Output* distortion_drive = createMonoModControl("distortion_drive", true);
     Output* distortion_mix = createMonoModControl("distortion_mix", true);
     cr::MagnitudeScale* distortion_gain = new cr::MagnitudeScale();
     distortion_gain->plug(distortion_drive);
 
-    distortion->plug(voice_handler_, Distortion::kAudio);
-    distortion->plug(distortion_on, Distortion::kOn);
+    distortion->plug(distortion_oversampler_->audio(), Distortion::kAudio);
+    distortion->plug(distortion_on_, Distortion::kOn);
     distortion->plug(distortion_type, Distortion::kType);
     distortion->plug(distortion_gain, Distortion::kDrive);
     distortion->plug(distortion_mix, Distortion::kMix);
-    addProcessor(distortion);
+    distortion_oversampler_->addProcessor(distortion);
+    distortion_oversampler_->setOversampledOutput(distortion->output());
     addProcessor(distortion_gain);
+    addProcessor(distortion_oversampler_);
+    distortion_oversampler_->setProfileSection(profiler_.section("distortion"));
 
     // Delay effect.
     Output* delay_free_frequency = createMonoModControl("delay_frequency", true);
@@ -213,14 +242,14 @@ namespace mopo {
     delay_samples->plug(delay_frequency_smoothed);
 
     Delay* delay = new Delay(MAX_DELAY_SAMPLES);
-    delay->plug(distortion, Delay::kAudio);
+    delay->plug(distortion_oversampler_, Delay::kAudio);
     delay->plug(delay_samples, Delay::kSampleDelay);
     delay->plug(delay_feedback_clamped, Delay::kFeedback);
     delay->plug(delay_wet, Delay::kWet);
 
     BypassRouter* delay_container = new BypassRouter();
     delay_container->plug(delay_on, BypassRouter::kOn);
-    delay_container->plug(distortion, BypassRouter::kAudio);
+    delay_container->plug(distortion_oversampler_, BypassRouter::kAudio);
     delay_container->addProcessor(delay_feedback_clamped);
     delay_container->addProcessor(delay_frequency_smoothed);
     delay_container->addProcessor(delay_samples);
@@ -228,6 +257,7 @@ namespace mopo {
     delay_container->registerOutput(delay->output());
 
     addProcessor(delay_container);
+    delay_container->setProfileSection(profiler_.section("delay"));
 
     // DC Blocker.
     DcFilter* dc_filter = new DcFilter();
@@ -259,6 +289,7 @@ namespace mopo {
     reverb_container->registerOutput(reverb->output(1));
 
     addProcessor(reverb_container);
+    reverb_container->setProfileSection(profiler_.section("reverb"));
 
     // Volume.
     Output* volume = createMonoModControl("volume", true);
@@ -296,6 +327,7 @@ namespace mopo {
     registerOutput(clamp_right->output());
 
     HelmModule::init();
+    updateAllocatedBytes();
   }
 
   void HelmEngine::connectModulation(ModulationConnection* connection) noexcept {
@@ -366,6 +398,11 @@ namespace mopo {
   }
 
   void HelmEngine::process() noexcept {
+    profiler_.beginBlock();
+    trace_recorder_.beginBlock();
+    cpu_governor_.setEnabled(realtime_governor_enabled_ && !offline_render_);
+    cpu_governor_.beginBlock();
+
     bool playing_arp = arp_on_->value();
     if (was_playing_arp_ != playing_arp)
       arpeggiator_->allNotesOff();
@@ -374,20 +411,42 @@ namespace mopo {
     arpeggiator_->process();
     ProcessorRouter::process();
 
-    if (getNumActiveVoices() == 0) {
+    // Idle modulation only keeps the meters moving.
+    if (getNumActiveVoices() == 0 && !cpu_governor_.skipTelemetry()) {
       for (auto& modulation : mod_connections_)
         modulation->modulation_scale.process();
     }
+
+    cpu_governor_.process();
+    if (cpu_governor_.level() != applied_level_) {
+      applied_level_ = cpu_governor_.level();
+      voice_handler_->setReducedQuality(cpu_governor_.releasedUnison());
+    }
+
+    // The patch can change the oversampling, the plugin reports it later.
+    latency_samples_ = distortion_oversampler_->getLatency();
+
+    profiler_.setActiveVoices(getNumActiveVoices());
+    profiler_.endBlock(buffer_size_, sample_rate_);
+    trace_recorder_.endBlock(buffer_size_, sample_rate_);
   }
 
   void HelmEngine::setBufferSize(int buffer_size) noexcept {
     ProcessorRouter::setBufferSize(buffer_size);
     arpeggiator_->setBufferSize(buffer_size);
+    cpu_governor_.setBufferSize(buffer_size);
   }
 
   void HelmEngine::setSampleRate(int sample_rate) noexcept {
     ProcessorRouter::setSampleRate(sample_rate);
     arpeggiator_->setSampleRate(sample_rate);
+    cpu_governor_.setSampleRate(sample_rate);
+    updateAllocatedBytes();
+  }
+
+  void HelmEngine::updateAllocatedBytes() {
+    profiler_.setVoiceBytes(voice_handler_->getPolyRouter()->allocatedBytes());
+    profiler_.setInstanceBytes(allocatedBytes());
   }
 
   void HelmEngine::allNotesOff(int sample) noexcept {
@@ -423,6 +482,22 @@ namespace mopo {
     voice_handler_->setChannelAftertouch(channel, value, sample);
   }
 
+  void HelmEngine::setSlide(mopo_float value, int channel, int sample) noexcept {
+    voice_handler_->setSlide(value, channel, sample);
+  }
+
+  void HelmEngine::setMpe(bool mpe) noexcept {
+    voice_handler_->setMpe(mpe);
+  }
+
+  bool HelmEngine::isMpe() const noexcept {
+    return voice_handler_->isMpe();
+  }
+
+  void HelmEngine::setMpePitchBendRange(mopo_float semitones) noexcept {
+    voice_handler_->setMpePitchBendRange(semitones);
+  }
+
   void HelmEngine::setBpm(mopo_float bpm) noexcept {
     mopo_float bps = bpm / 60.0;
     if (bps_->value() != bps)
@@ -445,6 +520,81 @@ namespace mopo {
   void HelmEngine::sustainOff() noexcept {
     voice_handler_->sustainOff();
   }
+
+  void HelmEngine::setVoiceRetirement(mopo_float threshold_decibels,
+                                      mopo_float hold_seconds) noexcept {
+    VoiceRetirementPolicy& policy = voice_handler_->getRetirementPolicy();
+    policy.setThreshold(threshold_decibels);
+    policy.setHoldTime(hold_seconds);
+  }
+
+  const VoiceLifetimeStats& HelmEngine::getVoiceLifetimeStats() const noexcept {
+    return voice_handler_->getVoiceLifetimeStats();
+  }
+
+  void HelmEngine::setStealPolicy(VoiceHandler::StealPolicy policy) noexcept {
+    voice_handler_->setStealPolicy(policy);
+  }
+
+  void HelmEngine::setCpuBudget(mopo_float fraction) noexcept {
+    realtime_cpu_budget_ = fraction;
+    if (!offline_render_)
+      voice_handler_->setCpuBudget(fraction);
+  }
+
+  mopo_float HelmEngine::getProjectedLoad() const noexcept {
+    return voice_handler_->getProjectedLoad();
+  }
+
+  bool HelmEngine::startTrace(const std::string& path) {
+    return trace_writer_.start(&trace_recorder_, path);
+  }
+
+  void HelmEngine::stopTrace() {
+    trace_writer_.stop();
+  }
+
+  void HelmEngine::setCpuGovernorEnabled(bool enabled) noexcept {
+    // Picked up by the next block, offline renders leave it off.
+    realtime_governor_enabled_ = enabled;
+  }
+
+  void HelmEngine::setCpuGovernorThresholds(mopo_float overload, mopo_float headroom) noexcept {
+    cpu_governor_.setThresholds(overload, headroom);
+  }
+
+  void HelmEngine::setOfflineRender(bool offline) noexcept {
+    // Keep realtime settings made while offline for when we come back.
+    if (offline != offline_render_) {
+      offline_render_ = offline;
+      voice_handler_->setCpuBudget(offline ? 0.0 : realtime_cpu_budget_);
+    }
+
+    // Only here, so automating distortion mid bounce can't reset the
+    // filters or move the latency.
+    updateOfflineOversampling();
+  }
+
+  void HelmEngine::setDeterministicRender(bool deterministic, uint64_t seed) {
+    deterministic_render_ = deterministic;
+    setRandomSeed(deterministic ? seed : entropySeed(this));
+  }
+
+  void HelmEngine::setRandomSeed(uint64_t seed) {
+    // The arp runs outside the router.
+    HelmModule::setRandomSeed(RandomGenerator::mix(seed, 0));
+    arpeggiator_->setRandomSeed(RandomGenerator::mix(seed, 1));
+  }
+
+  void HelmEngine::updateOfflineOversampling() noexcept {
+    bool distorting = offline_render_ && distortion_on_->value() != 0.0;
+    distortion_oversampler_->setMinimumStages(distorting ? OFFLINE_DISTORTION_STAGES : 0);
+    latency_samples_ = distortion_oversampler_->getLatency();
+  }
+
+  void HelmEngine::setPolyBlepOscillators(bool poly_blep) noexcept {
+    voice_handler_->setPolyBlepOscillators(poly_blep);
+  }
 } // namespace mopo
 
 
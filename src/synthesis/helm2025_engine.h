@@ -19,6 +19,7 @@
 #define HELM_ENGINE_H
 
 #include "mopo.h"
+#include "cpu_governor.h"
 #include "helm2025_voice_handler.h"
 #include "helm2025_common.h"
 #include "midi_event.h"
@@ -60,6 +61,10 @@ namespace mopo {
       [[nodiscard]] int getNumActiveVoices() const noexcept;
       [[nodiscard]] mopo_float getLastActiveNote() const noexcept;
 
+      // Samples of delay added by oversampled stages, for host compensation.
+      // Updated every block, safe to read from any thread.
+      [[nodiscard]] int getLatencySamples() const noexcept { return latency_samples_; }
+
       // Keyboard events.
       void allNotesOff(int sample = 0) noexcept override;
       void noteOn(mopo_float note, mopo_float velocity = 1.0,
@@ -71,14 +76,74 @@ namespace mopo {
       void correctToTime(mopo_float samples) noexcept override;
       void setAftertouch(mopo_float note, mopo_float value, int sample = 0) noexcept;
       void setChannelAftertouch(int channel, mopo_float value, int sample = 0) noexcept;
+      void setSlide(mopo_float value, int channel = 0, int sample = 0) noexcept;
+      void setMpe(bool mpe) noexcept;
+      bool isMpe() const noexcept;
+      void setMpePitchBendRange(mopo_float semitones) noexcept;
 
       // Sustain pedal events.
       void sustainOn() noexcept;
       void sustainOff() noexcept;
 
+      // Voice retirement.
+      void setVoiceRetirement(mopo_float threshold_decibels, mopo_float hold_seconds) noexcept;
+      [[nodiscard]] const VoiceLifetimeStats& getVoiceLifetimeStats() const noexcept;
+
+      // Voice stealing and CPU budget.
+      void setStealPolicy(VoiceHandler::StealPolicy policy) noexcept;
+      void setCpuBudget(mopo_float fraction) noexcept;
+      [[nodiscard]] mopo_float getProjectedLoad() const noexcept;
+
+      // Adaptive CPU governor. Safe to set and read from any thread, its
+      // load and level are for meters.
+      void setCpuGovernorEnabled(bool enabled) noexcept;
+      void setCpuGovernorThresholds(mopo_float overload, mopo_float headroom) noexcept;
+      [[nodiscard]] const CpuGovernor& getCpuGovernor() const noexcept { return cpu_governor_; }
+      [[nodiscard]] bool shouldSkipTelemetry() const noexcept {
+        return offline_render_ || cpu_governor_.skipTelemetry();
+      }
+
+      // Rendering faster than realtime, for bounces. Nothing watches the
+      // clock, so the governor and CPU budget are held off, telemetry is
+      // skipped and distortion gets oversampled even if the patch doesn't
+      // ask for it. Whether distortion is on is read here, so call it again
+      // before each render once the patch is loaded. Call from the audio
+      // thread.
+      void setOfflineRender(bool offline) noexcept;
+      [[nodiscard]] bool isOfflineRender() const noexcept { return offline_render_; }
+
+      // Restarts every random stream, unison phases, noise, sample and hold
+      // and the random arp, from _seed_ so the same patch and MIDI render the
+      // same audio. Turned off, streams restart from a fresh seed each time.
+      void setDeterministicRender(bool deterministic, uint64_t seed = 0);
+      [[nodiscard]] bool isDeterministicRender() const noexcept { return deterministic_render_; }
+      void setRandomSeed(uint64_t seed) override;
+
+      // Section timings, missed block deadlines and voice and instance
+      // memory. Stays empty unless mopo is built with MOPO_PROFILE.
+      [[nodiscard]] const Profiler& getProfiler() const noexcept { return profiler_; }
+      [[nodiscard]] Profiler& getProfiler() noexcept { return profiler_; }
+
+      // Writes a Chrome trace of every processor run to _path_ until
+      // stopTrace(). Returns false unless built with MOPO_PROFILE.
+      bool startTrace(const std::string& path);
+      void stopTrace();
+      [[nodiscard]] bool isTracing() const noexcept { return trace_writer_.running(); }
+
+      // Classic waveforms from PolyBLEP instead of the wave tables. Off by
+      // default: the tables alias less, PolyBLEP touches no table memory.
+      void setPolyBlepOscillators(bool poly_blep) noexcept;
+
+      // Stutters hold no memory until they're handed some, so voices don't
+      // carry it while stutter is off. Collect them with processing held off.
+      std::vector<Stutter*> getStutters() const { return voice_handler_->getStutters(); }
+
       HelmLfo* getPolyLfo() const { return voice_handler_ ? voice_handler_->getPolyLfo() : nullptr; }
 
     private:
+      void updateAllocatedBytes();
+      void updateOfflineOversampling() noexcept;
+
   HelmVoiceHandler* voice_handler_;
   Arpeggiator* arpeggiator_;
       ValueSwitch* arp_on_;
@@ -92,6 +157,20 @@ namespace mopo {
   HelmLfo* lfo_2_;
   PeakMeter* peak_meter_;
   StepGenerator* step_sequencer_;
+      Oversampler* distortion_oversampler_;
+      Value* distortion_on_;
+
+      CpuGovernor cpu_governor_;
+      CpuGovernor::Level applied_level_;
+
+      bool offline_render_;
+      bool deterministic_render_;
+      std::atomic<bool> realtime_governor_enabled_;
+      std::atomic<int> latency_samples_;
+      mopo_float realtime_cpu_budget_;
+      Profiler profiler_;
+      TraceRecorder trace_recorder_;
+      TraceWriter trace_writer_;
 
       std::set<ModulationConnection*> mod_connections_;
   };
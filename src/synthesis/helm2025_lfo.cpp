@@ -24,16 +24,8 @@
 
 namespace mopo {
 
-  namespace {
-    mopo_float randomLfoValue() {
-      return 2.0 * rand() / RAND_MAX - 1.0;
-    }
-  } // namespace
-
-
-
   HelmLfo::HelmLfo() : Processor(kNumInputs, kNumOutputs, false), offset_(0.0),
-                       cycle_seed_(0), cycle_count_(0), randoms_(), random_index_(0) { }
+                       cycle_seed_(0), cycle_count_(0), random_seed_(0), num_randoms_(0), random_index_(0) { }
 
   void HelmLfo::process() {
     int reset_offset = -1;
@@ -53,7 +45,7 @@ namespace mopo {
       cycle_resolution = 16;
     } else if (waveform == Wave::kWhiteNoise) {
       // WhiteNoise : résolution audio (pour affichage fluide)
-      cycle_resolution = std::max(8, std::min(512, static_cast<int>(sample_rate_ / std::max(1.0, frequency))));
+      cycle_resolution = std::max(8, std::min(MAX_CYCLE_RESOLUTION, static_cast<int>(sample_rate_ / std::max(1.0, frequency))));
     }
 
     mopo_float* osc_phase_buffer = output(kOscPhase)->buffer;
@@ -64,8 +56,8 @@ namespace mopo {
       if (i == reset_offset) {
         offset_ = 0.0;
         // Nouveau cycle : seed unique basé sur le compteur de cycles
-        cycle_seed_ = static_cast<uint32_t>(cycle_count_++);
-        randoms_ = mopo::generateSyncedRandoms(cycle_seed_, cycle_resolution);
+        cycle_seed_ = nextCycleSeed();
+        generateRandoms(cycle_resolution);
         random_index_ = 0;
       }
 
@@ -76,8 +68,8 @@ namespace mopo {
 
       // Détection du wrap de cycle (free-run) : renouvellement du seed et du random
       if (phased_offset < last_phased_offset_) {
-        cycle_seed_ = static_cast<uint32_t>(cycle_count_++);
-        randoms_ = mopo::generateSyncedRandoms(cycle_seed_, cycle_resolution);
+        cycle_seed_ = nextCycleSeed();
+        generateRandoms(cycle_resolution);
         random_index_ = 0;
       }
       last_phased_offset_ = phased_offset;
@@ -87,13 +79,13 @@ namespace mopo {
       // Pour S&H/S&G/WhiteNoise, utiliser la séquence synchronisée
       if (waveform == Wave::kWhiteNoise) {
         // White noise : nouvelle valeur à chaque sample
-        if (randoms_.empty()) randoms_ = mopo::generateSyncedRandoms(cycle_seed_, cycle_resolution);
+        if (num_randoms_ == 0) generateRandoms(cycle_resolution);
         value_buffer[i] = randoms_[(random_index_++) % cycle_resolution];
       }
       else if (waveform == Wave::kSampleAndHold) {
         // S&H : valeur constante sur chaque step
         int step = static_cast<int>(phased_offset * cycle_resolution);
-        if (randoms_.empty()) randoms_ = mopo::generateSyncedRandoms(cycle_seed_, cycle_resolution);
+        if (num_randoms_ == 0) generateRandoms(cycle_resolution);
         value_buffer[i] = randoms_[std::min(step, cycle_resolution - 1)];
       }
       else if (waveform == Wave::kSampleAndGlide) {
@@ -101,7 +93,7 @@ namespace mopo {
         float phasef = phased_offset * (cycle_resolution - 1);
         int index = static_cast<int>(phasef);
         float t = phasef - index;
-        if (randoms_.empty()) randoms_ = mopo::generateSyncedRandoms(cycle_seed_, cycle_resolution);
+        if (num_randoms_ == 0) generateRandoms(cycle_resolution);
         float r1 = randoms_[std::min(index, cycle_resolution - 1)];
         float r2 = randoms_[std::min(index + 1, cycle_resolution - 1)];
         value_buffer[i] = utils::interpolate(r1, r2, t);
@@ -114,18 +106,33 @@ namespace mopo {
     }
   }
 
+  void HelmLfo::setRandomSeed(uint64_t seed) {
+    random_seed_ = seed;
+    cycle_count_ = 0;
+  }
+
+  uint32_t HelmLfo::nextCycleSeed() {
+    return static_cast<uint32_t>(RandomGenerator::mix(random_seed_, cycle_count_++));
+  }
+
+  void HelmLfo::generateRandoms(int resolution) {
+    num_randoms_ = resolution;
+    generateSyncedRandoms(cycle_seed_, num_randoms_, randoms_);
+  }
+
   void HelmLfo::correctToTime(mopo_float samples) {
     mopo_float frequency = input(kFrequency)->at(0);
     offset_ = samples * frequency / sample_rate_;
     mopo_float integral;
     offset_ = utils::mod(offset_, &integral);
     // Réinitialiser la séquence random si besoin
-    randoms_.clear();
+    num_randoms_ = 0;
   }
 // Membres privés à ajouter dans helm2025_lfo.h :
 // uint32_t cycle_seed_;
 // uint64_t cycle_count_;
-// std::vector<float> randoms_;
+// float randoms_[MAX_CYCLE_RESOLUTION];
+// int num_randoms_;
 // int random_index_;
 } // namespace mopo
 
@@ -21,6 +21,8 @@
 #include "processor.h"
 #include "wave.h"
 
+#define MAX_CYCLE_RESOLUTION 512
+
 namespace mopo {
 
   // A processor that produces an oscillation stream based on the input
@@ -47,17 +49,25 @@ namespace mopo {
       virtual Processor* clone() const override { return new HelmLfo(*this); }
       void process() override;
       void correctToTime(mopo_float samples);
+      void setRandomSeed(uint64_t seed) override;
 
     public:
   // Synchronisation UI : accès au seed et à la résolution du cycle (16 pour S&H/S&G)
   uint32_t getCycleSeed() const { return cycle_seed_; }
-  int getCycleResolution() const { return static_cast<int>(randoms_.size()); }
+  int getCycleResolution() const { return num_randoms_; }
     protected:
+      uint32_t nextCycleSeed();
+      void generateRandoms(int resolution);
+
       mopo_float offset_;
       // Pour la synchronisation des randoms par cycle
       uint32_t cycle_seed_;
       uint64_t cycle_count_;
-      std::vector<float> randoms_;
+      // Chaque voix a ses propres cycles
+      uint64_t random_seed_;
+      // Fixe pour que le process et les clones n'allouent pas
+      float randoms_[MAX_CYCLE_RESOLUTION];
+      int num_randoms_;
   int random_index_;
   // Pour la détection robuste du wrap de cycle
   mopo_float last_phased_offset_ = 0.0f;
@@ -17,10 +17,30 @@
 #include "helm2025_oscillators.h"
 
 #include "detune_lookup.h"
+#include "oscillator_kernels.h"
+#include "poly_blep.h"
 
 #define RAND_DECAY 0.999
+#define SAMPLE_STEPS 8
 
 namespace mopo {
+
+  namespace {
+    const int SAMPLES_PER_STEP = FixedPointWaveLookup::FIXED_LOOKUP_SIZE / SAMPLE_STEPS;
+
+    // Cosine ease across one Sample & Glide step.
+    struct GlideCurve {
+      GlideCurve() {
+        for (int i = 0; i < SAMPLES_PER_STEP; ++i)
+          values[i] = (1.0 - cos(PI * i / SAMPLES_PER_STEP)) / 2.0;
+      }
+
+      mopo_float values[SAMPLES_PER_STEP];
+    };
+
+    const GlideCurve glide_curve;
+  } // namespace
+
   const mopo_float HelmOscillators::scales[] = {
       1.0, 1.0,
       sqrt(1.0 / 2.0), sqrt(1.0 / 2.0),
@@ -32,7 +52,8 @@ namespace mopo {
       sqrt(1.0 / 8.0), sqrt(1.0 / 8.0),
   };
 
-  HelmOscillators::HelmOscillators() : Processor(kNumInputs, 1) {
+  HelmOscillators::HelmOscillators(bool simd_kernels) : Processor(kNumInputs, 1),
+      kernels_(simd_kernels ? &OscillatorKernels::get() : genericOscillatorKernels()) {
     utils::zeroBuffer(oscillator1_cross_mods_, MAX_BUFFER_SIZE + 1);
     utils::zeroBuffer(oscillator2_cross_mods_, MAX_BUFFER_SIZE + 1);
 
@@ -74,8 +95,8 @@ namespace mopo {
     oscillator2_phases_[0] = 0;
 
     for (int u = 1; u < MAX_UNISON; ++u) {
-      oscillator1_phases_[u] = (UINT_MAX / RAND_MAX) * rand();
-      oscillator2_phases_[u] = (UINT_MAX / RAND_MAX) * rand();
+      oscillator1_phases_[u] = random_.next();
+      oscillator2_phases_[u] = random_.next();
     }
   }
 
@@ -203,18 +224,60 @@ namespace mopo {
     }
   }
 
+  int HelmOscillators::limitReleasedVoices(int voices) {
+    // Under load the governor caps unison on notes that are already fading
+    // out. Detune ratios keep using the full count so the remaining voices
+    // do not move; the outermost voices are the ones dropped.
+    int limit = input(kReleasedUnison)->at(0);
+    int state = static_cast<int>(input(kEnvelopePhase)->at(0));
+    if (limit <= 0 || state < Envelope::kReleasing)
+      return voices;
+    return std::min(voices, limit);
+  }
+
+  int HelmOscillators::polyBlepWaveform(int waveform) {
+    if (input(kPolyBlep)->at(0) == 0.0 || !poly_blep::hasWaveform(waveform))
+      return -1;
+    return waveform;
+  }
+
+  void HelmOscillators::renderVoice(mopo_float* totals, const int* cross_mods,
+                                    const int* phase_diffs, const mopo_float* phase_inc,
+                                    const mopo_float* wave_buffer, int blep_waveform,
+                                    unsigned int start_phase, int detune, int start, int end) {
+    if (blep_waveform >= 0) {
+      kernels_->render_poly_blep(blep_waveform, totals, cross_mods, phase_diffs, phase_inc,
+                                 start_phase, detune, start, end);
+    }
+    else {
+      kernels_->render_table(totals, cross_mods, phase_diffs, wave_buffer,
+                             start_phase, detune, start, end);
+    }
+  }
+
   void HelmOscillators::processVoices() {
     int voices1 = utils::iclamp(input(kUnisonVoices1)->source->buffer[0], 1, MAX_UNISON);
     int voices2 = utils::iclamp(input(kUnisonVoices2)->source->buffer[0], 1, MAX_UNISON);
+    voices1 = limitReleasedVoices(voices1);
+    voices2 = limitReleasedVoices(voices2);
+
+    int wave1 = static_cast<int>(input(kOscillator1Waveform)->source->buffer[0] + 0.5);
+    int wave2 = static_cast<int>(input(kOscillator2Waveform)->source->buffer[0] + 0.5);
+    int blep1 = polyBlepWaveform(wave1);
+    int blep2 = polyBlepWaveform(wave2);
+    const mopo_float* phase_inc1 = input(kOscillator1PhaseInc)->source->buffer;
+    const mopo_float* phase_inc2 = input(kOscillator2PhaseInc)->source->buffer;
 
     utils::zeroBuffer(oscillator1_totals_, buffer_size_);
     utils::zeroBuffer(oscillator2_totals_, buffer_size_);
 
     int j = 0;
     if (input(kReset)->source->triggered) {
-      int trigger_offset = input(kReset)->source->trigger_offset;
-      for (; j < trigger_offset; ++j)
-        tickInitialVoices(j);
+      j = input(kReset)->source->trigger_offset;
+      renderVoice(oscillator1_totals_, oscillator2_cross_mods_, oscillator1_phase_diffs_,
+                  phase_inc1, wave_buffers1_[0], blep1, oscillator1_phases_[0], 0, 0, j);
+      renderVoice(oscillator2_totals_, oscillator1_cross_mods_, oscillator2_phase_diffs_,
+                  phase_inc2, wave_buffers2_[0], blep2, oscillator2_phases_[0], 0, 0, j);
 
       oscillator1_phases_[0] = 0;
       oscillator2_phases_[0] = 0;
@@ -222,9 +285,6 @@ namespace mopo {
       last_phase2_ = 0;
       
       // Regenerate random waveforms on reset
-      int wave1 = static_cast<int>(input(kOscillator1Waveform)->source->buffer[0] + 0.5);
-      int wave2 = static_cast<int>(input(kOscillator2Waveform)->source->buffer[0] + 0.5);
-      
       if (wave1 == FixedPointWaveLookup::kSampleAndHold) {
         regenerateSampleAndHold(sample_hold_buffer1_);
       }
@@ -240,8 +300,10 @@ namespace mopo {
       }
     }
 
-    for (; j < buffer_size_; ++j)
-      tickInitialVoices(j);
+    renderVoice(oscillator1_totals_, oscillator2_cross_mods_, oscillator1_phase_diffs_,
+                phase_inc1, wave_buffers1_[0], blep1, oscillator1_phases_[0], 0, j, buffer_size_);
+    renderVoice(oscillator2_totals_, oscillator1_cross_mods_, oscillator2_phase_diffs_,
+                phase_inc2, wave_buffers2_[0], blep2, oscillator2_phases_[0], 0, j, buffer_size_);
 
     for (int v = 1; v < voices1; ++v) {
       const mopo_float* wave_buffer = wave_buffers1_[v];
@@ -250,15 +312,15 @@ namespace mopo {
 
       int i = 0;
       if (input(kReset)->source->triggered) {
-        int trigger_offset = input(kReset)->source->trigger_offset;
-        for (; i < trigger_offset; ++i)
-          tickVoice1(i, v, wave_buffer, start_phase, detune);
+        i = input(kReset)->source->trigger_offset;
+        renderVoice(oscillator1_totals_, oscillator1_cross_mods_, oscillator1_phase_diffs_,
+                    phase_inc1, wave_buffer, blep1, start_phase, detune, 0, i);
 
-        oscillator1_phases_[v] = (UINT_MAX / RAND_MAX) * rand();
+        oscillator1_phases_[v] = random_.next();
       }
 
-      for (; i < buffer_size_; ++i)
-        tickVoice1(i, v, wave_buffer, start_phase, detune);
+      renderVoice(oscillator1_totals_, oscillator1_cross_mods_, oscillator1_phase_diffs_,
+                  phase_inc1, wave_buffer, blep1, start_phase, detune, i, buffer_size_);
     }
 
     for (int v = 1; v < voices2; ++v) {
@@ -268,14 +330,15 @@ namespace mopo {
 
       int i = 0;
       if (input(kReset)->source->triggered) {
-        int trigger_offset = input(kReset)->source->trigger_offset;
-        for (; i < trigger_offset; ++i)
-          tickVoice2(i, v, wave_buffer, start_phase, detune);
+        i = input(kReset)->source->trigger_offset;
+        renderVoice(oscillator2_totals_, oscillator2_cross_mods_, oscillator2_phase_diffs_,
+                    phase_inc2, wave_buffer, blep2, start_phase, detune, 0, i);
 
-        oscillator2_phases_[v] = (UINT_MAX / RAND_MAX) * rand();
+        oscillator2_phases_[v] = random_.next();
       }
-      for (; i < buffer_size_; ++i)
-        tickVoice2(i, v, wave_buffer, start_phase, detune);
+
+      renderVoice(oscillator2_totals_, oscillator2_cross_mods_, oscillator2_phase_diffs_,
+                  phase_inc2, wave_buffer, blep2, start_phase, detune, i, buffer_size_);
     }
 
     finishVoices(voices1, voices2);
@@ -315,19 +378,20 @@ namespace mopo {
     processVoices();
   }
 
+  void HelmOscillators::setRandomSeed(uint64_t seed) {
+    random_.setSeed(seed);
+  }
+
   void HelmOscillators::regenerateSampleAndHold(mopo_float buffer[][2 * FixedPointWaveLookup::FIXED_LOOKUP_SIZE]) {
     // Generate Sample & Hold waveform: random values that stay constant
     for (int h = 0; h < FixedPointWaveLookup::HARMONICS + 1; ++h) {
-      mopo_float current_value = (2.0 * rand()) / RAND_MAX - 1.0;
-      
-      for (int i = 0; i < FixedPointWaveLookup::FIXED_LOOKUP_SIZE; ++i) {
-        // Change value at each step
-        if (i % (FixedPointWaveLookup::FIXED_LOOKUP_SIZE / 8) == 0)
-          current_value = (2.0 * rand()) / RAND_MAX - 1.0;
-        
-        buffer[h][i] = current_value;
-        // Diff for interpolation (stays constant for S&H)
-        buffer[h][i + FixedPointWaveLookup::FIXED_LOOKUP_SIZE] = 0.0;
+      for (int s = 0; s < SAMPLE_STEPS; ++s) {
+        mopo_float value = random_.nextBipolar();
+        for (int i = s * SAMPLES_PER_STEP; i < (s + 1) * SAMPLES_PER_STEP; ++i) {
+          buffer[h][i] = value;
+          // Diff for interpolation (stays constant for S&H)
+          buffer[h][i + FixedPointWaveLookup::FIXED_LOOKUP_SIZE] = 0.0;
+        }
       }
     }
   }
@@ -335,30 +399,22 @@ namespace mopo {
   void HelmOscillators::regenerateSampleAndGlide(mopo_float buffer[][2 * FixedPointWaveLookup::FIXED_LOOKUP_SIZE]) {
     // Generate Sample & Glide waveform: smoothly interpolated random values
     for (int h = 0; h < FixedPointWaveLookup::HARMONICS + 1; ++h) {
-      const int steps = 8; // Number of random values per cycle
-      const int samples_per_step = FixedPointWaveLookup::FIXED_LOOKUP_SIZE / steps;
-      
-      mopo_float random_values[steps + 1];
-      for (int s = 0; s <= steps; ++s) {
-        random_values[s] = (2.0 * rand()) / RAND_MAX - 1.0;
-      }
-      
-      for (int i = 0; i < FixedPointWaveLookup::FIXED_LOOKUP_SIZE; ++i) {
-        int step = i / samples_per_step;
-        if (step >= steps) step = steps - 1;
-        
-        mopo_float t = (mopo_float)(i % samples_per_step) / samples_per_step;
-        // Smooth interpolation using cosine
-        mopo_float smooth_t = (1.0 - cos(PI * t)) / 2.0;
-        
-        mopo_float value = utils::interpolate(random_values[step], random_values[step + 1], smooth_t);
-        buffer[h][i] = value;
-        
-        // Calculate diff for next sample
-        mopo_float next_t = (mopo_float)((i + 1) % samples_per_step) / samples_per_step;
-        mopo_float next_smooth_t = (1.0 - cos(PI * next_t)) / 2.0;
-        mopo_float next_value = utils::interpolate(random_values[step], random_values[step + 1], next_smooth_t);
-        buffer[h][i + FixedPointWaveLookup::FIXED_LOOKUP_SIZE] = next_value - value;
+      mopo_float random_values[SAMPLE_STEPS + 1];
+      random_.fillBipolar(random_values, SAMPLE_STEPS + 1);
+
+      for (int s = 0; s < SAMPLE_STEPS; ++s) {
+        mopo_float from = random_values[s];
+        mopo_float to = random_values[s + 1];
+        mopo_float* values = buffer[h] + s * SAMPLES_PER_STEP;
+        mopo_float* diffs = values + FixedPointWaveLookup::FIXED_LOOKUP_SIZE;
+
+        for (int i = 0; i < SAMPLES_PER_STEP; ++i)
+          values[i] = utils::interpolate(from, to, glide_curve.values[i]);
+
+        // The last diff of a step points back to its start, as it always has.
+        for (int i = 0; i < SAMPLES_PER_STEP - 1; ++i)
+          diffs[i] = values[i + 1] - values[i];
+        diffs[SAMPLES_PER_STEP - 1] = from - values[SAMPLES_PER_STEP - 1];
       }
     }
   }
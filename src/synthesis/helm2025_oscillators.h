@@ -20,9 +20,12 @@
 
 #include "mopo.h"
 #include "fixed_point_wave.h"
+#include "random_generator.h"
 
 namespace mopo {
 
+  struct OscillatorKernels;
+
   class HelmOscillators : public Processor {
     public:
       static const int MAX_UNISON = 15;
@@ -43,13 +46,19 @@ namespace mopo {
         kHarmonize2,
         kReset,
         kCrossMod,
+        kEnvelopePhase,
+        kReleasedUnison,
+        kPolyBlep,
         kNumInputs
       };
 
-      HelmOscillators();
+      // With _simd_kernels_ the voice loops use the widest kernels the CPU
+      // runs, otherwise the baseline ones.
+      HelmOscillators(bool simd_kernels = false);
 
       virtual void process();
       virtual Processor* clone() const { return new HelmOscillators(*this); }
+      virtual void setRandomSeed(uint64_t seed) override;
 
       Output* getOscillator1Output() { return output(0); }
       Output* getOscillator2Output() { return output(1); }
@@ -69,6 +78,12 @@ namespace mopo {
       void processInitial();
       void processCrossMod();
       void processVoices();
+      int limitReleasedVoices(int voices);
+      int polyBlepWaveform(int waveform);
+      void renderVoice(mopo_float* totals, const int* cross_mods,
+                       const int* phase_diffs, const mopo_float* phase_inc,
+                       const mopo_float* wave_buffer, int blep_waveform,
+                       unsigned int start_phase, int detune, int start, int end);
       void finishVoices(int voices1, int voices2);
 
       inline void tickCrossMod(int i, const mopo_float cross_mod,
@@ -84,28 +99,6 @@ namespace mopo {
         dest_cross_mod2[i + 1] = sin2 * cross_mod * INT_MAX;
       }
 
-      inline void tickInitialVoices(int i) {
-        int phase1 = oscillator2_cross_mods_[i] + oscillator1_phases_[0] + oscillator1_phase_diffs_[i];
-        int phase2 = oscillator1_cross_mods_[i] + oscillator2_phases_[0] + oscillator2_phase_diffs_[i];
-
-        oscillator1_totals_[i] += FixedPointWave::interpretWave(wave_buffers1_[0], phase1);
-        oscillator2_totals_[i] += FixedPointWave::interpretWave(wave_buffers2_[0], phase2);
-      }
-
-      inline void tickVoice1(int i, int voice, const mopo_float* wave_buffer,
-                             unsigned int start_phase, int detune) {
-        int phase = oscillator1_cross_mods_[i] + start_phase +
-                    i * detune + oscillator1_phase_diffs_[i];
-        oscillator1_totals_[i] += FixedPointWave::interpretWave(wave_buffer, phase);
-      }
-
-      inline void tickVoice2(int i, int voice, const mopo_float* wave_buffer,
-                             unsigned int start_phase, int detune) {
-        int phase = oscillator2_cross_mods_[i] + start_phase +
-                    i * detune + oscillator2_phase_diffs_[i];
-        oscillator2_totals_[i] += FixedPointWave::interpretWave(wave_buffer, phase);
-      }
-
       inline void tickOut(int i, mopo_float* dest,
                           const mopo_float* amp1, const mopo_float* amp2,
                           const mopo_float* oscillator1_totals,
@@ -117,6 +110,8 @@ namespace mopo {
         MOPO_ASSERT(std::isfinite(dest[i]));
       }
 
+      const OscillatorKernels* kernels_;
+
       int oscillator1_cross_mods_[MAX_BUFFER_SIZE + 1];
       int oscillator2_cross_mods_[MAX_BUFFER_SIZE + 1];
 
@@ -143,6 +138,9 @@ namespace mopo {
       
       unsigned int last_phase1_;
       unsigned int last_phase2_;
+
+      // Unison phases and the Sample & Hold and Sample & Glide steps.
+      RandomGenerator random_;
       
       void regenerateSampleAndHold(mopo_float buffer[][2 * FixedPointWaveLookup::FIXED_LOOKUP_SIZE]);
       void regenerateSampleAndGlide(mopo_float buffer[][2 * FixedPointWaveLookup::FIXED_LOOKUP_SIZE]);
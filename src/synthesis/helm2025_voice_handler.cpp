@@ -26,9 +26,12 @@
 #include "trigger_random.h"
 #include "value_switch.h"
 
+#include <set>
 #include <sstream>
 
 #define PITCH_MOD_RANGE 12
+#define MPE_PITCH_BEND_RANGE 48.0
+#define EXPRESSION_HALF_LIFE 0.004
 #define MIN_GAIN_DB -24.0
 #define MAX_GAIN_DB 24.0
 
@@ -94,7 +97,9 @@ namespace mopo {
 
   HelmVoiceHandler::HelmVoiceHandler(Output* beats_per_second) :
       ProcessorRouter(VoiceHandler::kNumInputs, 0), VoiceHandler(MAX_POLYPHONY),
-      beats_per_second_(beats_per_second) {
+      beats_per_second_(beats_per_second), profiler_(nullptr) {
+    released_unison_ = new cr::Value(0.0);
+    poly_blep_ = new cr::Value(0.0);
     output_ = new Multiply();
     registerOutput(output_->output());
   }
@@ -124,6 +129,20 @@ namespace mopo {
     mod_sources_["pitch_wheel"] = choose_pitch_wheel_->output();
     mod_sources_["mod_wheel"] = choose_mod_wheel->output();
 
+    // Quality switches the engine sets for every voice.
+    addGlobalProcessor(released_unison_);
+    addGlobalProcessor(poly_blep_);
+
+    // Per note expression from MPE controllers.
+    mpe_pitch_bend_range_ = new cr::Value(MPE_PITCH_BEND_RANGE);
+    expression_half_life_ = new cr::Value(EXPRESSION_HALF_LIFE);
+    addGlobalProcessor(mpe_pitch_bend_range_);
+    addGlobalProcessor(expression_half_life_);
+
+    mpe_pitch_bend_ = createExpressionLane(Voice::kPitchBend);
+    mod_sources_["mpe_pitch_bend"] = mpe_pitch_bend_;
+    mod_sources_["slide"] = createExpressionLane(Voice::kSlide);
+
     // Create all synthesizer voice components.
     createArticulation(note(), last_note(), velocity(), voice_event());
     createOscillators(current_frequency_->output(),
@@ -144,9 +163,18 @@ namespace mopo {
     addProcessor(output_);
 
     setVoiceKiller(amplitude_->output());
+    setVoiceEnvelope(amplitude_envelope_);
+    setVoiceCost(unison_cost_->output());
 
     HelmModule::init();
     setupPolyModulationReadouts();
+
+    // Modulation sources can be plugged anywhere later, so they have to
+    // stay computed where they are.
+    std::set<const Output*> mod_sources;
+    for (auto& mod_source : getModulationSources())
+      mod_sources.insert(mod_source.second);
+    getPolyRouter()->fuseOperators(mod_sources);
   }
 
   void HelmVoiceHandler::createOscillators(Output* midi, Output* reset) {
@@ -155,15 +183,24 @@ namespace mopo {
     cr::Multiply* pitch_bend = new cr::Multiply();
     pitch_bend->plug(choose_pitch_wheel_, 0);
     pitch_bend->plug(pitch_bend_range, 1);
+    cr::Add* wheel_bent_midi = new cr::Add();
+    wheel_bent_midi->plug(midi, 0);
+    wheel_bent_midi->plug(pitch_bend, 1);
+
+    cr::Multiply* note_bend = new cr::Multiply();
+    note_bend->plug(mpe_pitch_bend_, 0);
+    note_bend->plug(mpe_pitch_bend_range_, 1);
     cr::Add* bent_midi = new cr::Add();
-    bent_midi->plug(midi, 0);
-    bent_midi->plug(pitch_bend, 1);
+    bent_midi->plug(wheel_bent_midi, 0);
+    bent_midi->plug(note_bend, 1);
 
     addProcessor(pitch_bend);
+    addProcessor(wheel_bent_midi);
+    addProcessor(note_bend);
     addProcessor(bent_midi);
 
     // Oscillator 1.
-    HelmOscillators* oscillators = new HelmOscillators();
+    HelmOscillators* oscillators = new HelmOscillators(true);
     Output* oscillator1_waveform = createPolyModControl("osc_1_waveform", true);
     Output* oscillator1_transpose = createPolyModControl("osc_1_transpose", true);
     Output* oscillator1_tune = createPolyModControl("osc_1_tune", true);
@@ -196,6 +233,10 @@ namespace mopo {
 
     Output* cross_mod = createPolyModControl("cross_modulation", true);
     oscillators->plug(cross_mod, HelmOscillators::kCrossMod);
+    oscillators->plug(amplitude_envelope_->output(Envelope::kPhase),
+                      HelmOscillators::kEnvelopePhase);
+    oscillators->plug(released_unison_, HelmOscillators::kReleasedUnison);
+    oscillators->plug(poly_blep_, HelmOscillators::kPolyBlep);
 
     addProcessor(oscillator1_transposed);
     addProcessor(oscillator1_midi);
@@ -203,6 +244,7 @@ namespace mopo {
     addProcessor(oscillator1_phase_inc);
     addProcessor(oscillator1_phase_inc_smooth);
     addProcessor(oscillators);
+    profile(oscillators, "oscillators");
 
     // Oscillator 2.
     Output* oscillator2_waveform = createPolyModControl("osc_2_waveform", true);
@@ -234,6 +276,13 @@ namespace mopo {
     oscillators->plug(oscillator2_unison_voices, HelmOscillators::kUnisonVoices2);
     oscillators->plug(oscillator2_unison_harmonize, HelmOscillators::kHarmonize2);
 
+    // Voice cost for stealing: the base voice plus each unison voice rendered.
+    cr::Add* unison_voices = new cr::Add();
+    unison_voices->plug(oscillator1_unison_voices, 0);
+    unison_voices->plug(oscillator2_unison_voices, 1);
+    unison_cost_ = unison_voices;
+    addProcessor(unison_voices);
+
     addProcessor(oscillator2_transposed);
     addProcessor(oscillator2_midi);
     addProcessor(oscillator2_frequency);
@@ -289,6 +338,7 @@ namespace mopo {
     addProcessor(sub_phase_inc);
     addProcessor(sub_oscillator);
     addProcessor(smooth_sub_volume);
+    profile(sub_oscillator, "oscillators");
 
     Add *oscillator_sum = new Add();
     oscillator_sum->plug(oscillators, 0);
@@ -303,6 +353,7 @@ namespace mopo {
     noise_oscillator->plug(noise_volume, NoiseOscillator::kAmplitude);
 
     addProcessor(noise_oscillator);
+    profile(noise_oscillator, "oscillators");
 
     Add *oscillator_noise_sum = new Add();
     oscillator_noise_sum->plug(oscillator_sum, 0);
@@ -495,6 +546,7 @@ namespace mopo {
     addProcessor(final_gain);
     addProcessor(frequency_cutoff);
     addProcessor(filter);
+    profile(filter, "filter");
 
     addProcessor(drive_magnitude);
 
@@ -505,12 +557,13 @@ namespace mopo {
     // Stutter.
     BypassRouter* stutter_container = new BypassRouter();
     addProcessor(stutter_container);
+    profile(stutter_container, "stutter");
 
     ValueSwitch* stutter_on = createBaseSwitchControl("stutter_on");
     stutter_container->plug(stutter_on, BypassRouter::kOn);
     stutter_container->plug(filter, BypassRouter::kAudio);
 
-    Stutter* stutter = new Stutter(STUTTER_MAX_SAMPLES);
+    stutter_ = new Stutter(STUTTER_MAX_SECONDS);
     Output* stutter_free_frequency = createPolyModControl("stutter_frequency", true);
     Output* stutter_frequency = createTempoSyncSwitch("stutter", stutter_free_frequency->owner,
                                                       beats_per_second_, true, stutter_on);
@@ -521,18 +574,19 @@ namespace mopo {
 
     Output* stutter_softness = createPolyModControl("stutter_softness", true);
 
-    stutter_container->addProcessor(stutter);
-    stutter_container->registerOutput(stutter->output());
+    stutter_container->addProcessor(stutter_);
+    stutter_container->registerOutput(stutter_->output());
 
-    stutter->plug(filter, Stutter::kAudio);
-    stutter->plug(stutter_frequency, Stutter::kStutterFrequency);
-    stutter->plug(resample_frequency, Stutter::kResampleFrequency);
-    stutter->plug(stutter_softness, Stutter::kWindowSoftness);
-    stutter->plug(reset, Stutter::kReset);
+    stutter_->plug(filter, Stutter::kAudio);
+    stutter_->plug(stutter_frequency, Stutter::kStutterFrequency);
+    stutter_->plug(resample_frequency, Stutter::kResampleFrequency);
+    stutter_->plug(stutter_softness, Stutter::kWindowSoftness);
+    stutter_->plug(reset, Stutter::kReset);
 
     // Formant Filter.
     formant_container_ = new BypassRouter();
     addProcessor(formant_container_);
+    profile(formant_container_, "formant");
 
     ValueSwitch* formant_on = createBaseSwitchControl("formant_on");
     formant_container_->plug(formant_on->output(ValueSwitch::kValue), BypassRouter::kOn);
@@ -582,10 +636,14 @@ namespace mopo {
       cr::MidiScale* formant_frequency = new cr::MidiScale();
       formant_frequency->plug(formant_midi);
 
-      formant_filter_->getFormant(i)->plug(&formant_filter_types[i], BiquadFilter::kType);
-      formant_filter_->getFormant(i)->plug(formant_magnitude, BiquadFilter::kGain);
-      formant_filter_->getFormant(i)->plug(formant_q, BiquadFilter::kResonance);
-      formant_filter_->getFormant(i)->plug(formant_frequency, BiquadFilter::kCutoff);
+      formant_filter_->plug(&formant_filter_types[i],
+                            FormantManager::formantInput(i, FormantManager::kType));
+      formant_filter_->plug(formant_magnitude,
+                            FormantManager::formantInput(i, FormantManager::kGain));
+      formant_filter_->plug(formant_q,
+                            FormantManager::formantInput(i, FormantManager::kResonance));
+      formant_filter_->plug(formant_frequency,
+                            FormantManager::formantInput(i, FormantManager::kCutoff));
 
       addProcessor(formant_gain);
       addProcessor(formant_magnitude);
@@ -756,6 +814,21 @@ namespace mopo {
     }
   }
 
+  void HelmVoiceHandler::setReducedQuality(int released_unison) {
+    released_unison_->set(released_unison);
+  }
+
+  void HelmVoiceHandler::setPolyBlepOscillators(bool poly_blep) {
+    poly_blep_->set(poly_blep ? 1.0 : 0.0);
+  }
+
+  std::vector<Stutter*> HelmVoiceHandler::getStutters() const {
+    std::vector<Stutter*> stutters(1, stutter_);
+    for (Processor* copy : getVoiceCopies(stutter_))
+      stutters.push_back(dynamic_cast<Stutter*>(copy));
+    return stutters;
+  }
+
   void HelmVoiceHandler::noteOn(mopo_float note, mopo_float velocity, int sample, int channel) {
     if (getPressedNotes().size() < polyphony() || legato_->value() == 0.0)
       note_retriggered_.trigger(note, sample);
@@ -778,6 +851,25 @@ namespace mopo {
     return VoiceHandler::shouldAccumulate(output);
   }
 
+  Output* HelmVoiceHandler::createExpressionLane(Voice::Expression lane) {
+    cr::Value* value = new cr::Value();
+    value->plug(expression(lane));
+
+    cr::SmoothFilter* smoothed = new cr::SmoothFilter();
+    smoothed->plug(value, cr::SmoothFilter::kTarget);
+    smoothed->plug(expression_half_life_, cr::SmoothFilter::kHalfLife);
+    smoothed->plug(note(), cr::SmoothFilter::kReset);
+
+    addProcessor(value);
+    addProcessor(smoothed);
+    return smoothed->output();
+  }
+
+  void HelmVoiceHandler::profile(Processor* processor, const std::string& section) {
+    if (profiler_)
+      processor->setProfileSection(profiler_->section(section));
+  }
+
   void HelmVoiceHandler::setupPolyModulationReadouts() {
     output_map& poly_mods = HelmModule::getPolyModulations();
 
@@ -787,12 +879,41 @@ namespace mopo {
 
   void HelmVoiceHandler::setModWheel(mopo_float value, int channel) {
     MOPO_ASSERT(channel >= 1 && channel <= mopo::NUM_MIDI_CHANNELS);
-    mod_wheel_amounts_[channel - 1]->set(value);
+    if (isMpe() && channel == 1) {
+      for (int i = 0; i < mopo::NUM_MIDI_CHANNELS; ++i)
+        mod_wheel_amounts_[i]->set(value);
+    }
+    else
+      mod_wheel_amounts_[channel - 1]->set(value);
   }
 
   void HelmVoiceHandler::setPitchWheel(mopo_float value, int channel) {
     MOPO_ASSERT(channel >= 1 && channel <= mopo::NUM_MIDI_CHANNELS);
-    pitch_wheel_amounts_[channel - 1]->set(value);
+    if (isMpe() && channel == 1) {
+      for (int i = 0; i < mopo::NUM_MIDI_CHANNELS; ++i)
+        pitch_wheel_amounts_[i]->set(value);
+    }
+    else if (isMpe())
+      setChannelExpression(channel - 1, Voice::kPitchBend, value);
+    else
+      pitch_wheel_amounts_[channel - 1]->set(value);
+  }
+
+  void HelmVoiceHandler::setSlide(mopo_float value, int channel, int sample) {
+    MOPO_ASSERT(channel >= 1 && channel <= mopo::NUM_MIDI_CHANNELS);
+    setChannelExpression(channel - 1, Voice::kSlide, value, sample);
+  }
+
+  void HelmVoiceHandler::setMpe(bool mpe) {
+    VoiceHandler::setMpe(mpe);
+    for (int i = 0; i < mopo::NUM_MIDI_CHANNELS; ++i)
+      pitch_wheel_amounts_[i]->set(0.0);
+    for (int i = 1; i < mopo::NUM_MIDI_CHANNELS; ++i)
+      setChannelExpression(i, Voice::kPitchBend, 0.0);
+  }
+
+  void HelmVoiceHandler::setMpePitchBendRange(mopo_float semitones) {
+    mpe_pitch_bend_range_->set(semitones);
   }
 
   output_map& HelmVoiceHandler::getPolyModulations() {
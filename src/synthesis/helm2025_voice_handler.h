@@ -38,6 +38,7 @@ namespace mopo {
   class Oscillator;
   class SmoothValue;
   class StepGenerator;
+  class Stutter;
   class TriggerCombiner;
   class HelmOscillators;
 
@@ -58,6 +59,12 @@ namespace mopo {
       bool shouldAccumulate(Output* output) override;
       void setModWheel(mopo_float value, int channel = 0);
       void setPitchWheel(mopo_float value, int channel = 0);
+      void setSlide(mopo_float value, int channel = 0, int sample = 0);
+
+      // With MPE on, pitch bend on a member channel bends only its note, by
+      // _semitones_, and the master channel's wheels reach every voice.
+      void setMpe(bool mpe);
+      void setMpePitchBendRange(mopo_float semitones);
       Output* note_retrigger() { return &note_retriggered_; }
 
       // HelmModule
@@ -65,6 +72,18 @@ namespace mopo {
 
       HelmLfo* getPolyLfo() const { return poly_lfo_; }
 
+      // Quality reductions requested by the CPU governor.
+      void setReducedQuality(int released_unison);
+
+      // Classic shapes from PolyBLEP instead of the wave tables.
+      void setPolyBlepOscillators(bool poly_blep);
+
+      // Every voice's stutter and the template's, which later voices copy.
+      std::vector<Stutter*> getStutters() const;
+
+      // Voice sections are timed under _profiler_. Call before init().
+      void setProfiler(Profiler* profiler) { profiler_ = profiler; }
+
     private:
       // Create the portamento, legato, amplifier envelope and other processors
       // that effect how voices start and turn into other notes.
@@ -81,13 +100,25 @@ namespace mopo {
 
       void setupPolyModulationReadouts();
 
+      // Smoothed per voice expression lane, jumping on new notes.
+      Output* createExpressionLane(Voice::Expression lane);
+
+      void profile(Processor* processor, const std::string& section);
+
       Output* beats_per_second_;
+      Profiler* profiler_;
 
       Processor* note_from_center_;
       Gate* choose_pitch_wheel_;
+      Output* mpe_pitch_bend_;
+      cr::Value* mpe_pitch_bend_range_;
+      cr::Value* expression_half_life_;
       Value* mod_wheel_amounts_[mopo::NUM_MIDI_CHANNELS];
       Value* pitch_wheel_amounts_[mopo::NUM_MIDI_CHANNELS];
       Processor* current_frequency_;
+      Processor* unison_cost_;
+      cr::Value* released_unison_;
+      cr::Value* poly_blep_;
       Envelope* amplitude_envelope_;
       Processor* amplitude_;
       SimpleDelay* osc_feedback_;
@@ -100,6 +131,7 @@ namespace mopo {
       FormantManager* formant_filter_;
       Envelope* filter_envelope_;
       BypassRouter* formant_container_;
+      Stutter* stutter_;
       Output note_retriggered_;
       HelmLfo* poly_lfo_;
 
@@ -19,12 +19,10 @@
 #define NOISE_OSCILLATOR_H
 
 #include "mopo.h"
+#include "random_generator.h"
 
 namespace mopo {
 
-  const mopo_float NOISE_CONSTANT = 9.19191919191919191919191919191919191919191919;
-  const int NOISE_INT_CONSTANT = NOISE_CONSTANT;
-
   class NoiseOscillator : public Processor {
     public:
       enum Inputs {
@@ -37,18 +35,10 @@ namespace mopo {
 
       virtual void process();
       virtual Processor* clone() const { return new NoiseOscillator(*this); }
+      virtual void setRandomSeed(uint64_t seed) override { random_.setSeed(seed); }
 
     protected:
-      inline void tick(int i, mopo_float* dest, mopo_float amplitude) {
-        current_noise_value_ *= current_noise_value_;
-        current_noise_value_ = current_noise_value_ - floor(current_noise_value_);
-
-        dest[i] = amplitude * (2.0 * current_noise_value_ - 1.0);
-
-        current_noise_value_ += NOISE_INT_CONSTANT;
-      }
-
-      mopo_float current_noise_value_;
+      RandomGenerator random_;
   };
 } // namespace mopo
 
@@ -0,0 +1,61 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "oscillator_kernels.h"
+#include "oscillator_kernels_impl.h"
+
+namespace mopo {
+
+  namespace {
+    const OscillatorKernels generic_kernels = {
+      CpuFeatures::kGeneric, renderTableSamples, renderPolyBlep
+    };
+
+    const OscillatorKernels& bestKernels() {
+      for (int i = CpuFeatures::kNumIsas - 1; i > CpuFeatures::kGeneric; --i) {
+        const OscillatorKernels* kernels = OscillatorKernels::get(static_cast<CpuFeatures::Isa>(i));
+        if (kernels)
+          return *kernels;
+      }
+      return generic_kernels;
+    }
+  } // namespace
+
+  const OscillatorKernels* genericOscillatorKernels() {
+    return &generic_kernels;
+  }
+
+  const OscillatorKernels& OscillatorKernels::get() {
+    static const OscillatorKernels& kernels = bestKernels();
+    return kernels;
+  }
+
+  const OscillatorKernels* OscillatorKernels::get(CpuFeatures::Isa isa) {
+    if (!CpuFeatures::supports(isa))
+      return nullptr;
+
+    switch (isa) {
+      case CpuFeatures::kSse41:
+        return sse41OscillatorKernels();
+      case CpuFeatures::kAvx2:
+        return avx2OscillatorKernels();
+      case CpuFeatures::kAvx512:
+        return avx512OscillatorKernels();
+      default:
+        return genericOscillatorKernels();
+    }
+  }
+} // namespace mopo
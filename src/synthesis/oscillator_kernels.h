@@ -0,0 +1,56 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef OSCILLATOR_KERNELS_H
+#define OSCILLATOR_KERNELS_H
+
+#include "common.h"
+#include "cpu_features.h"
+
+namespace mopo {
+
+  // Inner loops of HelmOscillators, built once per instruction set in
+  // their own translation units. Each adds one voice to _totals_ over
+  // [start, end). The phase of sample i is
+  // cross_mods[i] + start_phase + i * detune + phase_diffs[i].
+  struct OscillatorKernels {
+    typedef void (*RenderTable)(mopo_float* totals, const int* cross_mods,
+                                const int* phase_diffs, const mopo_float* wave_buffer,
+                                unsigned int start_phase, int detune, int start, int end);
+    typedef void (*RenderPolyBlep)(int waveform, mopo_float* totals, const int* cross_mods,
+                                   const int* phase_diffs, const mopo_float* phase_inc,
+                                   unsigned int start_phase, int detune, int start, int end);
+
+    // Best kernels this CPU runs, chosen on first use.
+    static const OscillatorKernels& get();
+
+    // Kernels for _isa_, or nullptr when not built in or not supported.
+    static const OscillatorKernels* get(CpuFeatures::Isa isa);
+
+    CpuFeatures::Isa isa;
+    RenderTable render_table;
+    RenderPolyBlep render_poly_blep;
+  };
+
+  // Defined per instruction set, nullptr when compiled without it.
+  const OscillatorKernels* genericOscillatorKernels();
+  const OscillatorKernels* sse41OscillatorKernels();
+  const OscillatorKernels* avx2OscillatorKernels();
+  const OscillatorKernels* avx512OscillatorKernels();
+} // namespace mopo
+
+#endif // OSCILLATOR_KERNELS_H
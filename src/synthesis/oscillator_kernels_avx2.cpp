@@ -0,0 +1,79 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Built with AVX2 enabled. Selected at runtime, nothing else in the tree
+// may depend on this file's instruction set.
+
+#include "oscillator_kernels.h"
+
+#if defined(__AVX2__)
+#include "oscillator_kernels_impl.h"
+
+#include <immintrin.h>
+
+namespace mopo {
+
+  namespace {
+    // Table reads for four samples of one voice at a time.
+    void renderTable(mopo_float* totals, const int* cross_mods,
+                     const int* phase_diffs, const mopo_float* wave_buffer,
+                     unsigned int start_phase, int detune, int start, int end) {
+      const __m128i lane_offsets = _mm_setr_epi32(0, 1, 2, 3);
+      const __m128i fractional_mask = _mm_set1_epi32(FixedPointWaveLookup::FRACTIONAL_MASK);
+      const mopo_float* diffs = wave_buffer + FixedPointWaveLookup::FIXED_LOOKUP_SIZE;
+
+      int i = start;
+      for (; i + 4 <= end; i += 4) {
+        __m128i sample = _mm_add_epi32(_mm_set1_epi32(i), lane_offsets);
+        __m128i phase = _mm_add_epi32(_mm_set1_epi32(start_phase),
+                                      _mm_mullo_epi32(sample, _mm_set1_epi32(detune)));
+        phase = _mm_add_epi32(phase, _mm_loadu_si128((const __m128i*)(cross_mods + i)));
+        phase = _mm_add_epi32(phase, _mm_loadu_si128((const __m128i*)(phase_diffs + i)));
+
+        __m128i index = _mm_srli_epi32(phase, FixedPointWaveLookup::FRACTIONAL_BITS);
+        __m256d mult = _mm256_cvtepi32_pd(_mm_and_si128(phase, fractional_mask));
+        __m256d base = _mm256_i32gather_pd(wave_buffer, index, sizeof(mopo_float));
+        __m256d diff = _mm256_i32gather_pd(diffs, index, sizeof(mopo_float));
+
+        __m256d value = _mm256_add_pd(base, _mm256_mul_pd(mult, diff));
+        __m256d total = _mm256_loadu_pd(totals + i);
+        _mm256_storeu_pd(totals + i, _mm256_add_pd(total, value));
+      }
+
+      renderTableSamples(totals, cross_mods, phase_diffs, wave_buffer,
+                         start_phase, detune, i, end);
+    }
+
+    const OscillatorKernels avx2_kernels = {
+      CpuFeatures::kAvx2, renderTable, renderPolyBlep
+    };
+  } // namespace
+
+  const OscillatorKernels* avx2OscillatorKernels() {
+    return &avx2_kernels;
+  }
+} // namespace mopo
+
+#else
+
+namespace mopo {
+
+  const OscillatorKernels* avx2OscillatorKernels() {
+    return nullptr;
+  }
+} // namespace mopo
+
+#endif
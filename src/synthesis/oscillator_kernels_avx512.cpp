@@ -0,0 +1,79 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Built with AVX-512F enabled. Selected at runtime, nothing else in the
+// tree may depend on this file's instruction set.
+
+#include "oscillator_kernels.h"
+
+#if defined(__AVX512F__)
+#include "oscillator_kernels_impl.h"
+
+#include <immintrin.h>
+
+namespace mopo {
+
+  namespace {
+    // Table reads for eight samples of one voice at a time.
+    void renderTable(mopo_float* totals, const int* cross_mods,
+                     const int* phase_diffs, const mopo_float* wave_buffer,
+                     unsigned int start_phase, int detune, int start, int end) {
+      const __m256i lane_offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+      const __m256i fractional_mask = _mm256_set1_epi32(FixedPointWaveLookup::FRACTIONAL_MASK);
+      const mopo_float* diffs = wave_buffer + FixedPointWaveLookup::FIXED_LOOKUP_SIZE;
+
+      int i = start;
+      for (; i + 8 <= end; i += 8) {
+        __m256i sample = _mm256_add_epi32(_mm256_set1_epi32(i), lane_offsets);
+        __m256i phase = _mm256_add_epi32(_mm256_set1_epi32(start_phase),
+                                         _mm256_mullo_epi32(sample, _mm256_set1_epi32(detune)));
+        phase = _mm256_add_epi32(phase, _mm256_loadu_si256((const __m256i*)(cross_mods + i)));
+        phase = _mm256_add_epi32(phase, _mm256_loadu_si256((const __m256i*)(phase_diffs + i)));
+
+        __m256i index = _mm256_srli_epi32(phase, FixedPointWaveLookup::FRACTIONAL_BITS);
+        __m512d mult = _mm512_cvtepi32_pd(_mm256_and_si256(phase, fractional_mask));
+        __m512d base = _mm512_i32gather_pd(index, wave_buffer, sizeof(mopo_float));
+        __m512d diff = _mm512_i32gather_pd(index, diffs, sizeof(mopo_float));
+
+        __m512d value = _mm512_add_pd(base, _mm512_mul_pd(mult, diff));
+        __m512d total = _mm512_loadu_pd(totals + i);
+        _mm512_storeu_pd(totals + i, _mm512_add_pd(total, value));
+      }
+
+      renderTableSamples(totals, cross_mods, phase_diffs, wave_buffer,
+                         start_phase, detune, i, end);
+    }
+
+    const OscillatorKernels avx512_kernels = {
+      CpuFeatures::kAvx512, renderTable, renderPolyBlep
+    };
+  } // namespace
+
+  const OscillatorKernels* avx512OscillatorKernels() {
+    return &avx512_kernels;
+  }
+} // namespace mopo
+
+#else
+
+namespace mopo {
+
+  const OscillatorKernels* avx512OscillatorKernels() {
+    return nullptr;
+  }
+} // namespace mopo
+
+#endif
@@ -0,0 +1,111 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Shared body of the oscillator kernel translation units. Only include it
+// from those: everything here has internal linkage so each instruction set
+// keeps its own copy and none leaks into baseline code through the linker.
+
+#pragma once
+#ifndef OSCILLATOR_KERNELS_IMPL_H
+#define OSCILLATOR_KERNELS_IMPL_H
+
+#include "oscillator_kernels.h"
+#include "fixed_point_wave.h"
+#include "poly_blep.h"
+
+#include <climits>
+
+#define MIN_BLEP_PHASE_INC (1.0 / UINT_MAX)
+#define MAX_BLEP_PHASE_INC 0.5
+
+namespace mopo {
+
+  namespace {
+    const mopo_float PHASE_SCALE = 1.0 / (1.0 + UINT_MAX);
+
+    // Same arithmetic as FixedPointWave::interpretWave.
+    void renderTableSamples(mopo_float* totals, const int* cross_mods,
+                            const int* phase_diffs, const mopo_float* wave_buffer,
+                            unsigned int start_phase, int detune, int start, int end) {
+      const mopo_float* diffs = wave_buffer + FixedPointWaveLookup::FIXED_LOOKUP_SIZE;
+      for (int i = start; i < end; ++i) {
+        unsigned int phase = cross_mods[i] + start_phase + i * detune + phase_diffs[i];
+        unsigned int index = phase >> FixedPointWaveLookup::FRACTIONAL_BITS;
+        mopo_float mult = phase & FixedPointWaveLookup::FRACTIONAL_MASK;
+        totals[i] += wave_buffer[index] + mult * diffs[index];
+      }
+    }
+
+    // Same phase as the table path, read as [0, 1). Cross modulation
+    // moves the phase but is left out of the step width.
+    template<int waveform>
+    void renderPolyBlepWave(mopo_float* totals, const int* cross_mods,
+                            const int* phase_diffs, const mopo_float* phase_inc,
+                            unsigned int start_phase, int detune, int start, int end) {
+      mopo_float detune_inc = PHASE_SCALE * detune;
+
+      VECTORIZE_LOOP
+      for (int i = start; i < end; ++i) {
+        // Centered so the conversion is signed, which vectorizes.
+        int phase = cross_mods[i] + start_phase + i * detune + phase_diffs[i] - INT_MIN;
+        mopo_float t = 0.5 + PHASE_SCALE * phase;
+        mopo_float dt = phase_inc[i] + detune_inc;
+        dt = MIN_BLEP_PHASE_INC + poly_blep::ramp(dt - MIN_BLEP_PHASE_INC);
+        dt = MAX_BLEP_PHASE_INC - poly_blep::ramp(MAX_BLEP_PHASE_INC - dt);
+        totals[i] += poly_blep::wave<waveform>(t, dt, 1.0 / dt);
+      }
+    }
+
+    void renderPolyBlep(int waveform, mopo_float* totals, const int* cross_mods,
+                        const int* phase_diffs, const mopo_float* phase_inc,
+                        unsigned int start_phase, int detune, int start, int end) {
+      switch (waveform) {
+        case FixedPointWaveLookup::kTriangle:
+          renderPolyBlepWave<FixedPointWaveLookup::kTriangle>(
+              totals, cross_mods, phase_diffs, phase_inc, start_phase, detune, start, end);
+          break;
+        case FixedPointWaveLookup::kSquare:
+          renderPolyBlepWave<FixedPointWaveLookup::kSquare>(
+              totals, cross_mods, phase_diffs, phase_inc, start_phase, detune, start, end);
+          break;
+        case FixedPointWaveLookup::kDownSaw:
+          renderPolyBlepWave<FixedPointWaveLookup::kDownSaw>(
+              totals, cross_mods, phase_diffs, phase_inc, start_phase, detune, start, end);
+          break;
+        case FixedPointWaveLookup::kUpSaw:
+          renderPolyBlepWave<FixedPointWaveLookup::kUpSaw>(
+              totals, cross_mods, phase_diffs, phase_inc, start_phase, detune, start, end);
+          break;
+        case FixedPointWaveLookup::kPulse25:
+          renderPolyBlepWave<FixedPointWaveLookup::kPulse25>(
+              totals, cross_mods, phase_diffs, phase_inc, start_phase, detune, start, end);
+          break;
+        case FixedPointWaveLookup::kPulse10:
+          renderPolyBlepWave<FixedPointWaveLookup::kPulse10>(
+              totals, cross_mods, phase_diffs, phase_inc, start_phase, detune, start, end);
+          break;
+        case FixedPointWaveLookup::kSawSquare:
+          renderPolyBlepWave<FixedPointWaveLookup::kSawSquare>(
+              totals, cross_mods, phase_diffs, phase_inc, start_phase, detune, start, end);
+          break;
+        default:
+          MOPO_ASSERT(false);
+      }
+    }
+  } // namespace
+} // namespace mopo
+
+#endif // OSCILLATOR_KERNELS_IMPL_H
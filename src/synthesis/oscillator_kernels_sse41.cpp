@@ -0,0 +1,89 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Built with SSE4.1 enabled. Selected at runtime, nothing else in the tree
+// may depend on this file's instruction set.
+
+#include "oscillator_kernels.h"
+
+#if defined(__SSE4_1__) || (defined(_MSC_VER) && defined(_M_X64))
+#include "oscillator_kernels_impl.h"
+
+#include <immintrin.h>
+
+namespace mopo {
+
+  namespace {
+    // Phase math for four samples at once, then two pairs of table reads.
+    void renderTable(mopo_float* totals, const int* cross_mods,
+                     const int* phase_diffs, const mopo_float* wave_buffer,
+                     unsigned int start_phase, int detune, int start, int end) {
+      const __m128i lane_offsets = _mm_setr_epi32(0, 1, 2, 3);
+      const __m128i fractional_mask = _mm_set1_epi32(FixedPointWaveLookup::FRACTIONAL_MASK);
+      const mopo_float* diffs = wave_buffer + FixedPointWaveLookup::FIXED_LOOKUP_SIZE;
+
+      int i = start;
+      for (; i + 4 <= end; i += 4) {
+        __m128i sample = _mm_add_epi32(_mm_set1_epi32(i), lane_offsets);
+        __m128i phase = _mm_add_epi32(_mm_set1_epi32(start_phase),
+                                      _mm_mullo_epi32(sample, _mm_set1_epi32(detune)));
+        phase = _mm_add_epi32(phase, _mm_loadu_si128((const __m128i*)(cross_mods + i)));
+        phase = _mm_add_epi32(phase, _mm_loadu_si128((const __m128i*)(phase_diffs + i)));
+
+        __m128i index = _mm_srli_epi32(phase, FixedPointWaveLookup::FRACTIONAL_BITS);
+        __m128i fraction = _mm_and_si128(phase, fractional_mask);
+        __m128d mult_low = _mm_cvtepi32_pd(fraction);
+        __m128d mult_high = _mm_cvtepi32_pd(_mm_unpackhi_epi64(fraction, fraction));
+
+        int index0 = _mm_cvtsi128_si32(index);
+        int index1 = _mm_extract_epi32(index, 1);
+        int index2 = _mm_extract_epi32(index, 2);
+        int index3 = _mm_extract_epi32(index, 3);
+        __m128d base_low = _mm_setr_pd(wave_buffer[index0], wave_buffer[index1]);
+        __m128d base_high = _mm_setr_pd(wave_buffer[index2], wave_buffer[index3]);
+        __m128d diff_low = _mm_setr_pd(diffs[index0], diffs[index1]);
+        __m128d diff_high = _mm_setr_pd(diffs[index2], diffs[index3]);
+
+        __m128d value_low = _mm_add_pd(base_low, _mm_mul_pd(mult_low, diff_low));
+        __m128d value_high = _mm_add_pd(base_high, _mm_mul_pd(mult_high, diff_high));
+        _mm_storeu_pd(totals + i, _mm_add_pd(_mm_loadu_pd(totals + i), value_low));
+        _mm_storeu_pd(totals + i + 2, _mm_add_pd(_mm_loadu_pd(totals + i + 2), value_high));
+      }
+
+      renderTableSamples(totals, cross_mods, phase_diffs, wave_buffer,
+                         start_phase, detune, i, end);
+    }
+
+    const OscillatorKernels sse41_kernels = {
+      CpuFeatures::kSse41, renderTable, renderPolyBlep
+    };
+  } // namespace
+
+  const OscillatorKernels* sse41OscillatorKernels() {
+    return &sse41_kernels;
+  }
+} // namespace mopo
+
+#else
+
+namespace mopo {
+
+  const OscillatorKernels* sse41OscillatorKernels() {
+    return nullptr;
+  }
+} // namespace mopo
+
+#endif
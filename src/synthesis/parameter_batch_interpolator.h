@@ -8,6 +8,11 @@ namespace mopo {
 
 // Batch interpolator for multiple parameters (SOA layout)
 // Supports up to MAX_PARAMS parameters interpolated in parallel per block.
+//
+// Not part of the runtime kernel dispatch (see oscillator_kernels.h). Only
+// the unbuilt audio pipeline sketch includes it, and its AVX path is behind
+// a compile time check, so baseline builds get the scalar loop. The
+// simd_utils.h Vec8f wrapper the simd_* sketches include isn't in the tree.
 class ParameterBatchInterpolator {
 public:
     static constexpr int MAX_BLOCK = 128;
@@ -0,0 +1,121 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef POLY_BLEP_H
+#define POLY_BLEP_H
+
+#include "common.h"
+#include "fixed_point_wave.h"
+
+namespace mopo {
+
+  // Band limited versions of the classic waveforms. The naive shape is
+  // corrected with a two sample polynomial around every step (PolyBLEP) or
+  // corner (PolyBLAMP), so the cost is flat across pitch and no table memory
+  // is read. Two samples of correction alias more than the harmonic tables
+  // do, so this is the cheap path rather than the default one. Corrections
+  // are written without branches or compares so the render loops vectorize.
+  //
+  // _t_ is the phase in [0, 1) and _dt_ the phase increment per sample.
+  // Shapes match harmonic 0 of the FixedPointWaveLookup tables.
+  //
+  // Everything is static so each oscillator kernel translation unit keeps
+  // its own copy compiled for its instruction set.
+  namespace poly_blep {
+    static inline bool hasWaveform(int waveform) {
+      switch (waveform) {
+        case FixedPointWaveLookup::kTriangle:
+        case FixedPointWaveLookup::kSquare:
+        case FixedPointWaveLookup::kDownSaw:
+        case FixedPointWaveLookup::kUpSaw:
+        case FixedPointWaveLookup::kPulse25:
+        case FixedPointWaveLookup::kPulse10:
+        case FixedPointWaveLookup::kSawSquare:
+          return true;
+        default:
+          return false;
+      }
+    }
+
+    // max(value, 0) without a compare so GCC does not need
+    // -fno-trapping-math to vectorize it.
+    static inline mopo_float ramp(mopo_float value) {
+      return 0.5 * (value + fabs(value));
+    }
+
+    // Truncation instead of floor for the same reason, _t_ is never negative.
+    static inline mopo_float wrap(mopo_float t) {
+      return t - static_cast<int>(t);
+    }
+
+    // Residual of a step of -2 at t = 0.
+    static inline mopo_float blep(mopo_float t, mopo_float inv_dt) {
+      mopo_float after = ramp(1.0 - t * inv_dt);
+      mopo_float before = ramp(1.0 + (t - 1.0) * inv_dt);
+      return before * before - after * after;
+    }
+
+    // Residual of a slope change of one per sample at t = 0.
+    static inline mopo_float blamp(mopo_float t, mopo_float inv_dt) {
+      mopo_float after = ramp(1.0 - t * inv_dt);
+      mopo_float before = ramp(1.0 + (t - 1.0) * inv_dt);
+      return (1.0 / 6.0) * (after * after * after + before * before * before);
+    }
+
+    static inline mopo_float upSaw(mopo_float t, mopo_float inv_dt) {
+      return 2.0 * t - 1.0 - blep(t, inv_dt);
+    }
+
+    static inline mopo_float pulse(mopo_float t, mopo_float width, mopo_float inv_dt) {
+      mopo_float naive = 2.0 * static_cast<int>(1.0 + width - t) - 1.0;
+      return naive + blep(t, inv_dt) - blep(wrap(t + 1.0 - width), inv_dt);
+    }
+
+    static inline mopo_float triangle(mopo_float t, mopo_float dt, mopo_float inv_dt) {
+      // Peaks at 0.25 and troughs at 0.75, slope 4 per cycle.
+      mopo_float shifted = wrap(t + 0.75);
+      mopo_float naive = fabs(2.0 - 4.0 * shifted) - 1.0;
+      mopo_float corners = blamp(wrap(t + 0.25), inv_dt) -
+                           blamp(wrap(t + 0.75), inv_dt);
+      return naive + 8.0 * dt * corners;
+    }
+
+    template<int waveform>
+    static inline mopo_float wave(mopo_float t, mopo_float dt, mopo_float inv_dt) {
+      switch (waveform) {
+        case FixedPointWaveLookup::kTriangle:
+          return triangle(t, dt, inv_dt);
+        case FixedPointWaveLookup::kSquare:
+          return pulse(t, 0.5, inv_dt);
+        case FixedPointWaveLookup::kDownSaw:
+          return -upSaw(t, inv_dt);
+        case FixedPointWaveLookup::kUpSaw:
+          return upSaw(t, inv_dt);
+        case FixedPointWaveLookup::kPulse25:
+          return pulse(t, 0.25, inv_dt);
+        case FixedPointWaveLookup::kPulse10:
+          return pulse(t, 0.1, inv_dt);
+        case FixedPointWaveLookup::kSawSquare:
+          return -0.6 * upSaw(t, inv_dt) + 0.4 * pulse(t, 0.5, inv_dt);
+        default:
+          return 0.0;
+      }
+    }
+  } // namespace poly_blep
+} // namespace mopo
+
+#endif // POLY_BLEP_H
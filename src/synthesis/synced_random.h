@@ -1,17 +1,19 @@
 #pragma once
+#include "random_generator.h"
+
 #include <vector>
-#include <random>
 #include <cstdint>
 
 namespace mopo {
+// Remplit _values_ avec _resolution_ randoms [-1,1] pour un cycle, sans allouer
+inline void generateSyncedRandoms(uint32_t seed, int resolution, float* values) {
+    RandomGenerator(seed).fillBipolar(values, resolution);
+}
+
 // Génère une séquence de randoms [-1,1] pour un cycle, à partir d'un seed et d'une résolution
 inline std::vector<float> generateSyncedRandoms(uint32_t seed, int resolution) {
-    std::mt19937 rng(seed);
-    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
     std::vector<float> values(resolution);
-    for (int i = 0; i < resolution; ++i) {
-        values[i] = dist(rng);
-    }
+    generateSyncedRandoms(seed, resolution, values.data());
     return values;
 }
 } // namespace mopo
@@ -19,6 +19,7 @@
 #define TRIGGER_RANDOM_H
 
 #include "processor.h"
+#include "random_generator.h"
 
 namespace mopo {
 
@@ -35,9 +36,11 @@ namespace mopo {
 
       virtual Processor* clone() const { return new TriggerRandom(*this); }
       virtual void process();
+      virtual void setRandomSeed(uint64_t seed) override { random_.setSeed(seed); }
 
     private:
       mopo_float value_;
+      RandomGenerator random_;
   };
 } // namespace mopo
 